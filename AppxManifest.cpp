@@ -0,0 +1,250 @@
+#include "AppxManifest.h"
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+
+namespace {
+
+    // One markup tag: the local name (prefix stripped) and the raw attribute text
+    struct Tag {
+        std::string name;
+        const char* attrs = nullptr;
+        std::size_t attrsSize = 0;
+        bool        closing = false;
+        bool        selfClosing = false;
+    };
+
+    bool StartsWith(const char* p, const char* end, const char* s)
+    {
+        const std::size_t n = std::strlen(s);
+        return static_cast<std::size_t>(end - p) >= n && std::memcmp(p, s, n) == 0;
+    }
+
+    const char* Find(const char* p, const char* end, const char* s)
+    {
+        for (; p < end; ++p) {
+            if (StartsWith(p, end, s)) return p;
+        }
+        return end;
+    }
+
+    bool IsNameChar(char c)
+    {
+        return c != '\0' && !std::strchr(" \t\r\n/>=", c);
+    }
+
+    // Next element tag at or after `p`; comments, processing instructions,
+    // CDATA and declarations are skipped
+    bool NextTag(const char*& p, const char* end, Tag& tag)
+    {
+        while (p < end) {
+            p = static_cast<const char*>(std::memchr(p, '<', end - p));
+            if (!p) { p = end; return false; }
+
+            if (StartsWith(p, end, "<!--")) { p = Find(p + 4, end, "-->"); p = p < end ? p + 3 : end; continue; }
+            if (StartsWith(p, end, "<![CDATA[")) { p = Find(p + 9, end, "]]>"); p = p < end ? p + 3 : end; continue; }
+            if (StartsWith(p, end, "<?")) { p = Find(p + 2, end, "?>"); p = p < end ? p + 2 : end; continue; }
+            if (StartsWith(p, end, "<!")) { p = Find(p + 2, end, ">"); p = p < end ? p + 1 : end; continue; }
+
+            const char* q = p + 1;
+            tag.closing = q < end && *q == '/';
+            if (tag.closing) ++q;
+            const char* nameStart = q;
+            while (q < end && IsNameChar(*q)) ++q;
+            const char* localStart = nameStart;
+            for (const char* c = nameStart; c < q; ++c) {
+                if (*c == ':') localStart = c + 1;
+            }
+            tag.name.assign(localStart, q);
+
+            // Attribute values may contain '>', so walk quotes to find the end
+            const char* attrs = q;
+            char quote = 0;
+            while (q < end && (quote || *q != '>')) {
+                if (quote) { if (*q == quote) quote = 0; }
+                else if (*q == '"' || *q == '\'') quote = *q;
+                ++q;
+            }
+            if (q >= end) { p = end; return false; }
+
+            tag.selfClosing = q > attrs && q[-1] == '/';
+            tag.attrs = attrs;
+            tag.attrsSize = static_cast<std::size_t>(q - attrs) - (tag.selfClosing ? 1 : 0);
+            p = q + 1;
+            return true;
+        }
+        return false;
+    }
+
+    // Replaces the predefined and numeric character references
+    std::string DecodeEntities(const char* p, const char* end)
+    {
+        std::string out;
+        out.reserve(end - p);
+        while (p < end) {
+            if (*p != '&') { out += *p++; continue; }
+            const char* semi = static_cast<const char*>(std::memchr(p, ';', end - p));
+            if (!semi) { out += *p++; continue; }
+            const std::string ref(p + 1, semi);
+            unsigned long cp = 0;
+            if (ref == "amp") out += '&';
+            else if (ref == "lt") out += '<';
+            else if (ref == "gt") out += '>';
+            else if (ref == "quot") out += '"';
+            else if (ref == "apos") out += '\'';
+            else if (ref.size() > 1 && ref[0] == '#') {
+                cp = (ref[1] == 'x' || ref[1] == 'X') ? std::strtoul(ref.c_str() + 2, nullptr, 16)
+                                                      : std::strtoul(ref.c_str() + 1, nullptr, 10);
+                // Encode as UTF-8
+                if (cp < 0x80) out += char(cp);
+                else if (cp < 0x800) { out += char(0xC0 | (cp >> 6)); out += char(0x80 | (cp & 0x3F)); }
+                else if (cp < 0x10000) {
+                    out += char(0xE0 | (cp >> 12)); out += char(0x80 | ((cp >> 6) & 0x3F));
+                    out += char(0x80 | (cp & 0x3F));
+                }
+                else if (cp < 0x110000) {
+                    out += char(0xF0 | (cp >> 18)); out += char(0x80 | ((cp >> 12) & 0x3F));
+                    out += char(0x80 | ((cp >> 6) & 0x3F)); out += char(0x80 | (cp & 0x3F));
+                }
+            }
+            else { out.append(p, semi + 1); }
+            p = semi + 1;
+        }
+        return out;
+    }
+
+    // Value of an unprefixed attribute in the tag
+    bool GetAttribute(const Tag& tag, const char* name, std::string& value)
+    {
+        const char* p = tag.attrs;
+        const char* end = tag.attrs + tag.attrsSize;
+        const std::size_t nameLen = std::strlen(name);
+        while (p < end) {
+            while (p < end && !IsNameChar(*p)) ++p;
+            const char* n = p;
+            while (p < end && IsNameChar(*p)) ++p;
+            const char* nEnd = p;
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+            if (p >= end || *p != '=') continue;
+            ++p;
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+            if (p >= end || (*p != '"' && *p != '\'')) return false;
+            const char quote = *p++;
+            const char* v = p;
+            while (p < end && *p != quote) ++p;
+            if (p >= end) return false;
+            if (static_cast<std::size_t>(nEnd - n) == nameLen && std::memcmp(n, name, nameLen) == 0) {
+                value = DecodeEntities(v, p);
+                return true;
+            }
+            ++p;
+        }
+        return false;
+    }
+
+    // ASCII case-insensitive compare; asset names are matched the way the file system does
+    bool EqualsNoCase(const std::wstring& a, std::size_t offset, const std::wstring& b)
+    {
+        if (a.size() < offset + b.size()) return false;
+        for (std::size_t i = 0; i < b.size(); ++i) {
+            wchar_t x = a[offset + i], y = b[i];
+            if (x >= L'A' && x <= L'Z') x = x - L'A' + L'a';
+            if (y >= L'A' && y <= L'Z') y = y - L'A' + L'a';
+            if (x != y) return false;
+        }
+        return true;
+    }
+
+    std::wstring Lower(std::wstring s)
+    {
+        for (wchar_t& c : s) {
+            if (c >= L'A' && c <= L'Z') c = c - L'A' + L'a';
+        }
+        return s;
+    }
+
+    // Integer after `key` in a qualifier such as "targetsize-32"
+    bool QualifierValue(const std::wstring& q, const wchar_t* key, int& value)
+    {
+        const std::size_t n = std::wcslen(key);
+        if (q.compare(0, n, key) != 0 || q.size() == n) return false;
+        value = 0;
+        for (std::size_t i = n; i < q.size(); ++i) {
+            if (q[i] < L'0' || q[i] > L'9' || value > 100000) return false;
+            value = value * 10 + (q[i] - L'0');
+        }
+        return value > 0;
+    }
+}
+
+bool AppxManifest::FindSquare44x44Logo(const char* xml, std::size_t size, const std::string& appId,
+    std::string& logo)
+{
+    if (!xml) return false;
+    const char* p = xml;
+    const char* end = xml + size;
+
+    Tag tag;
+    bool inApp = false;
+    while (NextTag(p, end, tag)) {
+        if (tag.name == "Application") {
+            if (tag.closing) {
+                if (inApp) return false; // Our application had no logo
+                continue;
+            }
+            std::string id;
+            inApp = !tag.selfClosing && (appId.empty() || (GetAttribute(tag, "Id", id) && id == appId));
+            continue;
+        }
+        if (inApp && !tag.closing && tag.name == "VisualElements") {
+            return GetAttribute(tag, "Square44x44Logo", logo) && !logo.empty();
+        }
+    }
+    return false;
+}
+
+std::wstring AppxManifest::PickLogoVariant(const std::wstring& logoFile,
+    const std::vector<std::wstring>& candidates, int targetPx)
+{
+    // Split "Square44x44Logo.png" into stem and extension
+    const std::size_t dot = logoFile.rfind(L'.');
+    if (dot == std::wstring::npos || targetPx <= 0) return std::wstring();
+    const std::wstring stem = logoFile.substr(0, dot);
+    const std::wstring ext = logoFile.substr(dot);
+
+    std::wstring best;
+    long long bestRank = 0;
+    for (const std::wstring& name : candidates) {
+        if (name.size() < stem.size() + ext.size()) continue;
+        if (!EqualsNoCase(name, 0, stem) || !EqualsNoCase(name, name.size() - ext.size(), ext)) continue;
+
+        // Qualifiers sit between the stem and the extension: ".targetsize-24_altform-unplated"
+        std::wstring quals = Lower(name.substr(stem.size(), name.size() - stem.size() - ext.size()));
+        if (!quals.empty() && quals[0] != L'.') continue;
+
+        int px = 44; // Unqualified is scale-100
+        bool targetSize = false, unplated = false, usable = true;
+        std::size_t pos = quals.empty() ? std::wstring::npos : 1;
+        while (pos != std::wstring::npos && pos <= quals.size()) {
+            const std::size_t sep = quals.find(L'_', pos);
+            const std::wstring q = quals.substr(pos, sep == std::wstring::npos ? std::wstring::npos : sep - pos);
+            pos = sep == std::wstring::npos ? std::wstring::npos : sep + 1;
+
+            int value;
+            if (QualifierValue(q, L"targetsize-", value)) { px = value; targetSize = true; }
+            else if (QualifierValue(q, L"scale-", value)) { px = 44 * value / 100; }
+            else if (q == L"altform-unplated") unplated = true;
+            else if (q.compare(0, 9, L"contrast-") == 0 || q.compare(0, 6, L"theme-") == 0 ||
+                     q == L"altform-lightunplated") usable = false;
+        }
+        if (!usable || px <= 0) continue;
+
+        long long rank = px == targetPx ? 0 : px > targetPx ? px - targetPx : 100000LL + (targetPx - px);
+        rank = rank * 4 + (targetSize ? 0 : 2) + (unplated ? 0 : 1);
+        if (best.empty() || rank < bestRank) {
+            best = name;
+            bestRank = rank;
+        }
+    }
+    return best;
+}
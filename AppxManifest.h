@@ -0,0 +1,33 @@
+#pragma once
+#ifndef APPXMANIFEST_H
+#define APPXMANIFEST_H
+
+// Finds a packaged app's small logo without the shell: read the
+// Square44x44Logo of its <Application> in AppxManifest.xml, then pick the
+// best of the qualified files next to it (Logo.targetsize-32.png,
+// Logo.scale-200.png, ...). Platform-neutral.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace AppxManifest {
+
+    // Square44x44Logo of the application with Id `appId` (or of the first
+    // application if `appId` is empty), e.g. "Assets\Square44x44Logo.png".
+    // Scans the UTF-8 manifest in one pass without building a tree.
+    bool FindSquare44x44Logo(const char* xml, std::size_t size, const std::string& appId,
+        std::string& logo);
+
+    // Chooses among `candidates` (file names in the logo's folder) the variant
+    // of `logoFile` (file name only) to draw at `targetPx`. targetsize-N
+    // assets are N px and scale-S assets are 44 * S / 100 px. The best is an
+    // exact size, then the smallest larger, then the largest smaller; on a tie
+    // targetsize beats scale and unplated beats plated. High contrast and
+    // light-theme variants are skipped. Returns an empty string if nothing fits.
+    std::wstring PickLogoVariant(const std::wstring& logoFile, const std::vector<std::wstring>& candidates,
+        int targetPx);
+
+} // namespace AppxManifest
+
+#endif // APPXMANIFEST_H
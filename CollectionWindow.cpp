@@ -1,11 +1,13 @@
 ﻿#include "CollectionWindow.h"
 #include "Resource.h"
 #include "Strings.h"
+#include "HandleAudit.h"
 #include <windowsx.h>
 #include <dwmapi.h> 
 #include <uxtheme.h> 
 #include <algorithm>
 #include <vector>
+#include <unordered_map>
 
 #pragma comment(lib, "dwmapi.lib") 
 #pragma comment(lib, "UxTheme.lib") 
@@ -61,7 +63,7 @@ CollectionWindow::CollectionWindow(HWND parent, TrayManager& trayManager, Positi
 
 CollectionWindow::~CollectionWindow() {
     if (hImageList_) {
-        ImageList_Destroy(hImageList_);
+        ImageList_Destroy(WTT_UNTRACK(hImageList_));
         hImageList_ = nullptr;
     }
     if (hEventHook_) {
@@ -105,6 +107,7 @@ bool CollectionWindow::CreateAndShow() {
     ::DwmSetWindowAttribute(hWnd_, DWMWA_SYSTEMBACKDROP_TYPE, &backdrop, sizeof(backdrop));
 
     BuildUI();
+    trayManager_.MaterializeIcons(); // Collection-mode entries only carry an icon source until now
     PopulateList();
 
     AdjustWindowToContent();
@@ -224,47 +227,93 @@ void CollectionWindow::BuildUI() {
 }
 
 void CollectionWindow::PopulateList() {
-    iconSize_ = GetSystemMetrics(SM_CYSMICON) + MulDiv(12, dpi_, 96);
+    iconSize_ = GetSystemMetricsForDpi(SM_CYSMICON, dpi_) + MulDiv(12, dpi_, 96);
     if (iconSize_ < 20) iconSize_ = 20;
-    hImageList_ = ImageList_Create(iconSize_, iconSize_, ILC_COLOR32 | ILC_MASK, 10, 10);
+    hImageList_ = WTT_TRACK(ImageList_Create(iconSize_, iconSize_, ILC_COLOR32 | ILC_MASK, 10, 10), "HIMAGELIST");
 
     const auto& icons = trayManager_.GetTrayIcons();
-    if (icons.empty()) {
+    if (icons.Empty()) {
         EnableWindow(hBtnRestoreAll_, FALSE);
     }
     else {
         EnableWindow(hBtnRestoreAll_, TRUE);
     }
 
-    int imageIndex = 0;
-    for (const auto& pair : icons) {
-        const TrayIcon& ti = pair.second;
-        if (ti.originalIcon) {
-            ImageList_AddIcon(hImageList_, ti.originalIcon);
+    // Entries sharing an icon (same app or identical pixels) share one image
+    std::unordered_map<IconStore::Slot, int> imageForIcon;
+    int itemIndex = 0;
+    for (const auto& rec : icons) {
+        const TrayIcon& ti = rec.entry;
+        auto found = imageForIcon.find(ti.icon);
+        int image;
+        if (found != imageForIcon.end()) {
+            image = found->second;
         }
         else {
-            HICON hPlaceholder = (HICON)LoadImage(nullptr, IDI_APPLICATION, IMAGE_ICON, 0, 0, LR_SHARED);
-            ImageList_AddIcon(hImageList_, hPlaceholder);
+            HICON icon = trayManager_.GetIcon(ti, iconSize_);
+            if (!icon) icon = (HICON)LoadImage(nullptr, IDI_APPLICATION, IMAGE_ICON, 0, 0, LR_SHARED);
+            image = ImageList_AddIcon(hImageList_, icon);
+            imageForIcon.emplace(ti.icon, image);
         }
 
         LVITEMW lvi{};
         lvi.mask = LVIF_TEXT | LVIF_IMAGE | LVIF_PARAM;
-        lvi.iItem = imageIndex;
+        lvi.iItem = itemIndex;
         lvi.iSubItem = 0;
-        lvi.iImage = imageIndex;
-        lvi.lParam = (LPARAM)pair.first;
-        lvi.pszText = (LPWSTR)ti.windowTitle.c_str();
+        lvi.iImage = image;
+        lvi.lParam = (LPARAM)rec.id;
+        lvi.pszText = (LPWSTR)ti.details->windowTitle.c_str();
 
         ListView_InsertItem(hListView_, &lvi);
-        imageIndex++;
+        itemIndex++;
     }
 
     ListView_SetImageList(hListView_, hImageList_, LVSIL_SMALL);
 }
 
+void CollectionWindow::NotifyIconChanged(UINT iconId) {
+    if (s_instance && s_instance->hListView_) {
+        s_instance->OnIconChanged(iconId);
+    }
+}
+
+void CollectionWindow::OnIconChanged(UINT iconId) {
+    LVFINDINFOW fi{};
+    fi.flags = LVFI_PARAM;
+    fi.lParam = (LPARAM)iconId;
+    int item = ListView_FindItem(hListView_, -1, &fi);
+    if (item < 0) return;
+
+    const TrayIcon* ti = trayManager_.GetTrayIcons().Find(iconId);
+    HICON icon = ti ? trayManager_.GetIcon(*ti, iconSize_) : nullptr;
+    if (!icon || !hImageList_) return;
+
+    LVITEMW lvi{};
+    lvi.mask = LVIF_IMAGE;
+    lvi.iItem = item;
+    lvi.iImage = ImageList_AddIcon(hImageList_, icon);
+    if (lvi.iImage >= 0) ListView_SetItem(hListView_, &lvi);
+}
+
+// Moved to a monitor with another DPI: refill the list at the new icon size.
+// The icons come from the sizes already stored, nothing is extracted again.
+void CollectionWindow::OnDpiChanged(UINT dpi, const RECT* suggested) {
+    dpi_ = dpi;
+    SetWindowPos(hWnd_, nullptr, suggested->left, suggested->top,
+        suggested->right - suggested->left, suggested->bottom - suggested->top,
+        SWP_NOZORDER | SWP_NOACTIVATE);
+
+    HIMAGELIST old = hImageList_;
+    ListView_DeleteAllItems(hListView_);
+    PopulateList();
+    if (old) ImageList_Destroy(WTT_UNTRACK(old));
+
+    AdjustWindowToContent();
+}
+
 void CollectionWindow::AdjustWindowToContent() {
     const auto& icons = trayManager_.GetTrayIcons();
-    int count = (int)icons.size();
+    int count = (int)icons.Size();
     if (count < 0) count = 0;
 
     // --- MODIFIED: Increased per-row padding for a more spacious look ---
@@ -367,9 +416,8 @@ void CollectionWindow::OnRestoreItem(int itemIndex) {
 
         HWND hwndToRestore = nullptr;
         const auto& icons = trayManager_.GetTrayIcons();
-        auto it = icons.find(iconId);
-        if (it != icons.end()) {
-            hwndToRestore = it->second.targetWindow;
+        if (const TrayIcon* ti = icons.Find(iconId)) {
+            hwndToRestore = ti->targetWindow;
         }
         lastRestoredHwnd_ = hwndToRestore;
         suppressCloseUntil_ = GetTickCount64() + 800; 
@@ -388,7 +436,7 @@ void CollectionWindow::OnRestoreItem(int itemIndex) {
 }
 
 void CollectionWindow::OnRestoreAll() {
-    trayManager_.RestoreAllWindows();
+    trayManager_.RestoreAllWindows(true);
     Destroy();
 }
 
@@ -505,6 +553,10 @@ LRESULT CollectionWindow::HandleMessage(HWND hWnd, UINT msg, WPARAM wParam, LPAR
         }
         return 0;
 
+    case WM_DPICHANGED:
+        OnDpiChanged(HIWORD(wParam), reinterpret_cast<const RECT*>(lParam));
+        return 0;
+
     case WM_CLOSE:
         Destroy();
         return 0;
@@ -33,6 +33,9 @@ public:
      // --- MODIFIED ---
     static bool Show(HWND parent, TrayManager& trayManager, PositioningMode mode, DisableModeCallback onDisable);
 
+    // Refreshes the icon of one entry if the window is open.
+    static void NotifyIconChanged(UINT iconId);
+
 private:
     // --- MODIFIED ---
     CollectionWindow(HWND parent, TrayManager& trayManager, PositioningMode mode, DisableModeCallback onDisable);
@@ -64,6 +67,8 @@ private:
     void OnRestoreAll();
     void OnKillFocus();
     void OnToggleCollectionMode(); // --- NEW ---
+    void OnIconChanged(UINT iconId);
+    void OnDpiChanged(UINT dpi, const RECT* suggested);
 
     // --- NEW: ġر + ָϡ ---
     static void CALLBACK WinEventProc(HWINEVENTHOOK hHook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD dwEventThread, DWORD dwmsEventTime);
@@ -0,0 +1,178 @@
+#include "Diagnostics.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <cstdio>
+
+namespace {
+    struct LatencyStats {
+        long long count = 0;
+        long long total = 0;
+        long long max = 0;
+    };
+
+    // Probe names are string literals, so a sample finds its row by pointer
+    // without building a string; there are few enough rows to scan
+    struct LatencyRow {
+        const wchar_t* name;
+        LatencyStats   stats;
+    };
+
+    std::vector<LatencyRow>& Stats()
+    {
+        static std::vector<LatencyRow> stats;
+        return stats;
+    }
+
+    // API names are literals too, and found the same way
+    struct CallRow {
+        const wchar_t* api;
+        long long      count;
+    };
+
+    void AddCalls(std::vector<CallRow>& rows, const wchar_t* api, long long count)
+    {
+        auto it = std::find_if(rows.begin(), rows.end(),
+            [api](const CallRow& r) { return r.api == api; });
+        if (it == rows.end()) rows.push_back(CallRow{ api, count });
+        else it->count += count;
+    }
+
+    // Calls counted since the active ScopedCallCount started. Per thread, so
+    // work done by the icon worker or the mouse hook is not billed to the UI
+    // operation; with no scope active nothing is counted.
+    struct PendingCalls {
+        const wchar_t*       scope = nullptr;
+        std::vector<CallRow> rows;
+    };
+
+    PendingCalls& Pending()
+    {
+        thread_local PendingCalls pending;
+        return pending;
+    }
+
+    struct CallStatsRow {
+        const wchar_t*       name;
+        LatencyStats         stats;   // Calls per operation
+        std::vector<CallRow> apis;    // Totals over all operations
+    };
+
+    std::vector<CallStatsRow>& CallStats()
+    {
+        static std::vector<CallStatsRow> stats;
+        return stats;
+    }
+}
+
+long long Diagnostics::NowMicros()
+{
+    static LARGE_INTEGER freq = [] { LARGE_INTEGER f; ::QueryPerformanceFrequency(&f); return f; }();
+    LARGE_INTEGER now;
+    ::QueryPerformanceCounter(&now);
+    return now.QuadPart * 1000000 / freq.QuadPart;
+}
+
+void Diagnostics::RecordLatency(const wchar_t* name, long long micros)
+{
+    if (!name) return;
+    auto& rows = Stats();
+    auto it = std::find_if(rows.begin(), rows.end(),
+        [name](const LatencyRow& r) { return r.name == name; });
+    if (it == rows.end()) it = rows.insert(rows.end(), LatencyRow{ name, {} });
+
+    LatencyStats& s = it->stats;
+    s.count++;
+    s.total += micros;
+    if (micros > s.max) s.max = micros;
+}
+
+void Diagnostics::CountCall(const wchar_t* api)
+{
+    PendingCalls& pending = Pending();
+    if (pending.scope && api) AddCalls(pending.rows, api, 1);
+}
+
+Diagnostics::ScopedCallCount::ScopedCallCount(const wchar_t* name) : name_(name)
+{
+    PendingCalls& pending = Pending();
+    pending.scope = name;
+    pending.rows.clear();
+}
+
+Diagnostics::ScopedCallCount::~ScopedCallCount()
+{
+    PendingCalls& pending = Pending();
+    pending.scope = nullptr;
+    if (!name_) return;
+
+    auto& rows = CallStats();
+    auto it = std::find_if(rows.begin(), rows.end(),
+        [this](const CallStatsRow& r) { return r.name == name_; });
+    if (it == rows.end()) it = rows.insert(rows.end(), CallStatsRow{ name_, {}, {} });
+
+    long long total = 0;
+    for (const CallRow& r : pending.rows) {
+        total += r.count;
+        AddCalls(it->apis, r.api, r.count);
+    }
+    pending.rows.clear();
+
+    LatencyStats& s = it->stats;
+    s.count++;
+    s.total += total;
+    if (total > s.max) s.max = total;
+}
+
+std::wstring Diagnostics::FormatCallReport()
+{
+    // Merged by name like the latency rows, APIs sorted by name
+    struct Operation {
+        LatencyStats                      stats;
+        std::map<std::wstring, long long> apis;
+    };
+    std::map<std::wstring, Operation> byName;
+    for (const auto& r : CallStats()) {
+        Operation& op = byName[r.name];
+        op.stats.count += r.stats.count;
+        op.stats.total += r.stats.total;
+        op.stats.max = (std::max)(op.stats.max, r.stats.max);
+        for (const CallRow& c : r.apis) op.apis[c.api] += c.count;
+    }
+
+    std::wstring out;
+    for (const auto& kv : byName) {
+        const auto& s = kv.second.stats;
+        wchar_t line[200];
+        swprintf_s(line, L"%s: n=%lld avg=%lld calls max=%lld calls\n",
+            kv.first.c_str(), s.count, s.count ? s.total / s.count : 0, s.max);
+        out += line;
+        for (const auto& api : kv.second.apis) {
+            swprintf_s(line, L"  %s: %lld\n", api.first.c_str(), api.second);
+            out += line;
+        }
+    }
+    return out;
+}
+
+std::wstring Diagnostics::FormatLatencyReport()
+{
+    // Rows of the same name recorded from different literals are merged
+    std::map<std::wstring, LatencyStats> byName;
+    for (const auto& r : Stats()) {
+        LatencyStats& s = byName[r.name];
+        s.count += r.stats.count;
+        s.total += r.stats.total;
+        s.max = (std::max)(s.max, r.stats.max);
+    }
+
+    std::wstring out;
+    for (const auto& kv : byName) {
+        const auto& s = kv.second;
+        wchar_t line[200];
+        swprintf_s(line, L"%s: n=%lld avg=%lld us max=%lld us\n",
+            kv.first.c_str(), s.count, s.count ? s.total / s.count : 0, s.max);
+        out += line;
+    }
+    return out;
+}
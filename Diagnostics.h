@@ -0,0 +1,59 @@
+#pragma once
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <windows.h>
+#include <string>
+
+// Lightweight timing probes. Samples are accumulated silently per name
+// (count / total / max); the diagnostics dump formats and traces them, so
+// recording adds nothing to the latency being measured.
+namespace Diagnostics {
+
+    // Monotonic timestamp in microseconds (QueryPerformanceCounter).
+    long long NowMicros();
+
+    // Records one latency sample. `name` must be a string literal.
+    void RecordLatency(const wchar_t* name, long long micros);
+
+    // Human readable summary of all recorded samples.
+    std::wstring FormatLatencyReport();
+
+    // Counts one Win32/COM call made on behalf of the operation a
+    // ScopedCallCount on this thread is measuring; outside one it does
+    // nothing. `api` must be a string literal.
+    void CountCall(const wchar_t* api);
+
+    // Human readable summary of the call counts per operation, with the
+    // totals per API.
+    std::wstring FormatCallReport();
+
+    // Records the lifetime of the object as one sample.
+    class ScopedLatency {
+    public:
+        explicit ScopedLatency(const wchar_t* name) : name_(name), start_(NowMicros()) {}
+        ~ScopedLatency() { RecordLatency(name_, NowMicros() - start_); }
+
+        ScopedLatency(const ScopedLatency&) = delete;
+        ScopedLatency& operator=(const ScopedLatency&) = delete;
+    private:
+        const wchar_t* name_;
+        long long      start_;
+    };
+
+    // Adds the calls made on this thread during its lifetime to the totals of
+    // one operation. `name` must be a string literal; scopes don't nest.
+    class ScopedCallCount {
+    public:
+        explicit ScopedCallCount(const wchar_t* name);
+        ~ScopedCallCount();
+
+        ScopedCallCount(const ScopedCallCount&) = delete;
+        ScopedCallCount& operator=(const ScopedCallCount&) = delete;
+    private:
+        const wchar_t* name_;
+    };
+
+} // namespace Diagnostics
+
+#endif // DIAGNOSTICS_H
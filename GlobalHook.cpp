@@ -1,4 +1,5 @@
 ﻿#include "GlobalHook.h"
+#include "WindowMessaging.h"
 #include <dwmapi.h>
 #include <uxtheme.h>
 #include <UIAutomation.h>
@@ -71,8 +72,7 @@ LRESULT GlobalHook::SafeNcHitTest(HWND hwnd, POINT ptScreen) {
 
     DWORD_PTR res = 0;
     LPARAM lp = MAKELPARAM((short)ptScreen.x, (short)ptScreen.y);
-    BOOL ok = ::SendMessageTimeoutW(hwnd, WM_NCHITTEST, 0, lp,
-        SMTO_ABORTIFHUNG | SMTO_BLOCK, 50, &res);
+    bool ok = WindowMessaging::SendWithDeadline(hwnd, WM_NCHITTEST, 0, lp, 50, &res);
 
     if (pSetThreadDpiAwarenessContext && oldCtx) {
         pSetThreadDpiAwarenessContext(oldCtx);
@@ -119,9 +119,8 @@ HWND GlobalHook::GetTopLevelFromPoint(POINT ptScreen) {
 bool GlobalHook::HitByTitleBarInfoEx(HWND hwnd, POINT ptScreen) {
     TITLEBARINFOEX tbix{};
     tbix.cbSize = sizeof(tbix);
-    if (!::SendMessageTimeoutW(hwnd, WM_GETTITLEBARINFOEX, 0,
-        reinterpret_cast<LPARAM>(&tbix),
-        SMTO_ABORTIFHUNG | SMTO_BLOCK, 60, nullptr)) {
+    if (!WindowMessaging::SendWithDeadline(hwnd, WM_GETTITLEBARINFOEX, 0,
+        reinterpret_cast<LPARAM>(&tbix), 60, nullptr)) {
         return false;
     }
     const RECT& rcMin = tbix.rgrect[2];
@@ -0,0 +1,135 @@
+#include "HandleAudit.h"
+
+#ifdef WTT_HANDLE_AUDIT
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    struct Site {
+        const char* kind = "";
+        long long   created = 0;
+        long long   freed = 0;
+        long long   live = 0;
+        long long   marked = 0;   // `live` at the last Mark
+    };
+
+    struct State {
+        std::mutex                                   lock;
+        std::unordered_map<const void*, std::string> live;          // Handle -> creation site
+        std::map<std::string, Site>                  sites;
+        std::map<std::string, long long>             unknownFrees;  // By freeing site
+    };
+
+    State& Audit()
+    {
+        static State state;
+        return state;
+    }
+
+    // "C:\src\IconPipeline.cpp:58" -> "IconPipeline.cpp:58"
+    std::string ShortSite(const std::string& site)
+    {
+        const size_t slash = site.find_last_of("\\/");
+        return slash == std::string::npos ? site : site.substr(slash + 1);
+    }
+
+    // Report lines are ASCII (kinds and source file names), formatted narrow
+    // so the same code runs under the portable tests
+    void Append(std::wstring& out, const char* line)
+    {
+        out.append(line, line + std::strlen(line));
+    }
+}
+
+void HandleAudit::Created(const void* handle, const char* kind, const char* site)
+{
+    if (!handle) return;
+    State& s = Audit();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    auto it = s.live.find(handle);
+    if (it != s.live.end()) {
+        // Freed somewhere unaudited and handed out again
+        s.sites[it->second].live--;
+        it->second = site;
+    }
+    else {
+        s.live.emplace(handle, site);
+    }
+    Site& entry = s.sites[site];
+    entry.kind = kind;
+    entry.created++;
+    entry.live++;
+}
+
+void HandleAudit::Destroyed(const void* handle, const char* site)
+{
+    if (!handle) return;
+    State& s = Audit();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    auto it = s.live.find(handle);
+    if (it == s.live.end()) {
+        s.unknownFrees[site]++;
+        return;
+    }
+    Site& entry = s.sites[it->second];
+    entry.freed++;
+    entry.live--;
+    s.live.erase(it);
+}
+
+std::size_t HandleAudit::LiveCount()
+{
+    State& s = Audit();
+    std::lock_guard<std::mutex> guard(s.lock);
+    return s.live.size();
+}
+
+void HandleAudit::Mark()
+{
+    State& s = Audit();
+    std::lock_guard<std::mutex> guard(s.lock);
+    for (auto& kv : s.sites) kv.second.marked = kv.second.live;
+}
+
+std::wstring HandleAudit::FormatReport()
+{
+    State& s = Audit();
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    std::vector<const std::pair<const std::string, Site>*> order;
+    for (const auto& kv : s.sites) {
+        if (kv.second.live != 0 || kv.second.live != kv.second.marked) order.push_back(&kv);
+    }
+    std::sort(order.begin(), order.end(),
+        [](const std::pair<const std::string, Site>* a, const std::pair<const std::string, Site>* b) {
+            return a->second.live - a->second.marked > b->second.live - b->second.marked;
+        });
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "Audited handles: %zu live\n", s.live.size());
+    std::wstring out;
+    Append(out, line);
+    for (const auto* kv : order) {
+        const Site& site = kv->second;
+        std::snprintf(line, sizeof(line), "  %+lld since mark, %lld live (%lld created, %lld freed) %s at %s\n",
+            site.live - site.marked, site.live, site.created, site.freed, site.kind,
+            ShortSite(kv->first).c_str());
+        Append(out, line);
+    }
+    for (const auto& kv : s.unknownFrees) {
+        std::snprintf(line, sizeof(line), "  %lld frees of unrecorded handles at %s\n", kv.second,
+            ShortSite(kv.first).c_str());
+        Append(out, line);
+    }
+    return out;
+}
+
+#endif // WTT_HANDLE_AUDIT
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef HANDLEAUDIT_H
+#define HANDLEAUDIT_H
+
+#include <cstddef>
+#include <string>
+
+// Leak audit for the GDI and USER objects the icon and menu paths create and
+// free by hand. Builds defining WTT_HANDLE_AUDIT (the Debug configurations)
+// record every such handle with the call site that made it and drop it where
+// it is freed, so whatever is still live after a soak run points at its leak.
+// Otherwise the macros are the bare expressions.
+//
+//     HICON icon = WTT_TRACK(::CreateIconIndirect(&ii), "HICON");
+//     WTT_TRACKED(info.hbmColor, "HBITMAP");   // Handed out through a pointer
+//     ::DestroyIcon(WTT_UNTRACK(icon));
+namespace HandleAudit {
+
+#ifdef WTT_HANDLE_AUDIT
+    // Records a handle made at `site`; null handles are ignored. Thread-safe.
+    void Created(const void* handle, const char* kind, const char* site);
+
+    // Forgets a handle that is about to be freed at `site`.
+    void Destroyed(const void* handle, const char* site);
+
+    template <typename H>
+    H Track(H handle, const char* kind, const char* site)
+    {
+        Created(handle, kind, site);
+        return handle;
+    }
+
+    template <typename H>
+    H Untrack(H handle, const char* site)
+    {
+        Destroyed(handle, site);
+        return handle;
+    }
+
+    // Handles created and not freed yet.
+    std::size_t LiveCount();
+
+    // Baseline the report's growth column is measured from.
+    void Mark();
+
+    // Live handles per creation site, most grown since Mark first, then the
+    // frees of handles that were never recorded.
+    std::wstring FormatReport();
+#endif
+
+} // namespace HandleAudit
+
+#define WTT_AUDIT_STRINGIZE2(x) #x
+#define WTT_AUDIT_STRINGIZE(x) WTT_AUDIT_STRINGIZE2(x)
+#define WTT_AUDIT_SITE __FILE__ ":" WTT_AUDIT_STRINGIZE(__LINE__)
+
+#ifdef WTT_HANDLE_AUDIT
+#define WTT_TRACK(expr, kind)      HandleAudit::Track((expr), kind, WTT_AUDIT_SITE)
+#define WTT_TRACKED(handle, kind)  HandleAudit::Created((handle), kind, WTT_AUDIT_SITE)
+#define WTT_UNTRACK(handle)        HandleAudit::Untrack((handle), WTT_AUDIT_SITE)
+#else
+#define WTT_TRACK(expr, kind)      (expr)
+#define WTT_TRACKED(handle, kind)  ((void)0)
+#define WTT_UNTRACK(handle)        (handle)
+#endif
+
+#endif // HANDLEAUDIT_H
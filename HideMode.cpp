@@ -0,0 +1,79 @@
+#include "HideMode.h"
+#include <algorithm>
+#include <cwctype>
+
+namespace {
+    std::wstring ToLower(std::wstring s)
+    {
+        std::transform(s.begin(), s.end(), s.begin(),
+            [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+        return s;
+    }
+
+    std::wstring Trim(const std::wstring& s)
+    {
+        size_t b = 0, e = s.size();
+        while (b < e && std::iswspace(s[b])) ++b;
+        while (e > b && std::iswspace(s[e - 1])) --e;
+        return s.substr(b, e - b);
+    }
+}
+
+std::vector<std::wstring> HideModePolicy::ParseAppList(const std::wstring& list)
+{
+    std::vector<std::wstring> apps;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find_first_of(L";,", start);
+        if (end == std::wstring::npos) end = list.size();
+        std::wstring item = Trim(list.substr(start, end - start));
+        if (!item.empty()) apps.push_back(ToLower(item));
+        start = end + 1;
+    }
+    return apps;
+}
+
+bool HideModePolicy::Hide(HideBackend& window, const HideRequest& request, HideMode& mode)
+{
+    mode = HideMode::Traditional;
+    if (request.cloakRequested && !request.isPackaged && window.Cloak()) {
+        mode = HideMode::Cloak;
+        return true;
+    }
+
+    const bool hidden = window.HideTraditional();
+
+    // UWP windows leave taskbar remnants behind; parking removes them
+    if (request.isUwp && request.useVirtualDesktop) {
+        const bool parked = window.Park();
+        return hidden || parked;
+    }
+    return hidden;
+}
+
+void HideModePolicy::PrepareRestore(HideBackend& window, const RestoreState& state)
+{
+    if (state.hideMode == HideMode::Cloak) {
+        window.Uncloak();
+        return;
+    }
+
+    // Only untracked here; the hidden desktop is removed once nothing is
+    // parked on it, so the other parked windows don't pop up
+    if (window.IsParked()) window.Unpark(state.originalDesktop);
+    window.UnhideTraditional();
+}
+
+HideMode HideModePolicy::SelectForExecutable(const std::wstring& exePath,
+    const std::vector<std::wstring>& cloakApps)
+{
+    if (exePath.empty() || cloakApps.empty()) return HideMode::Traditional;
+
+    size_t slash = exePath.find_last_of(L"\\/");
+    std::wstring fileName = ToLower(slash == std::wstring::npos ? exePath : exePath.substr(slash + 1));
+
+    for (const auto& app : cloakApps) {
+        if (app == fileName) return HideMode::Cloak;
+    }
+    return HideMode::Traditional;
+}
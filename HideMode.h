@@ -0,0 +1,78 @@
+#pragma once
+#ifndef HIDEMODE_H
+#define HIDEMODE_H
+
+// Platform-neutral hide-mode policy and the hide/restore dispatch built on
+// it. The mode a window was hidden with is kept on its tray entry. Nothing in
+// here touches <windows.h>; the window operations come from a HideBackend.
+
+#include <string>
+#include <vector>
+
+enum class HideMode : unsigned char {
+    Traditional = 0, // DeleteTab + WS_EX_TOOLWINDOW + SW_HIDE (frame is re-laid out on restore)
+    Cloak = 1        // Shell cloak on the hidden desktop, the surface stays composed so restore is a single move back
+};
+
+// What the hide path recorded about a window; the restore path needs nothing else
+struct RestoreState {
+    HideMode hideMode{ HideMode::Traditional };
+    int      originalDesktop{ 0 };
+    bool     wasMaximized{ false };
+};
+
+// What Hide decides on, from the window's capture and the settings
+struct HideRequest {
+    bool isUwp{ false };              // Gets the virtual desktop enhancement
+    bool isPackaged{ false };         // Never cloaked, the enhancement owns its cloak state
+    bool cloakRequested{ false };     // The executable is on the cloak list
+    bool useVirtualDesktop{ false };
+};
+
+// The operations hiding and restoring one window are made of. WindowManager
+// implements them with the shell and the virtual desktop API, the tests with
+// a simulated window.
+class HideBackend {
+public:
+    virtual ~HideBackend() = default;
+
+    // Taskbar tab removed, tool-window style, hidden
+    virtual bool HideTraditional() = 0;
+    // Styles and taskbar tab back; showing is left to the caller
+    virtual void UnhideTraditional() = 0;
+
+    // Parked on the hidden desktop (and counted there) with the tab removed;
+    // false if the desktop API is missing
+    virtual bool Cloak() = 0;
+    // Back onto the current desktop with its tab, uncounted
+    virtual void Uncloak() = 0;
+
+    // The UWP enhancement: moved to the hidden desktop and counted there
+    virtual bool Park() = 0;
+    // Whether the window is counted as parked
+    virtual bool IsParked() const = 0;
+    // Back to `desktop`, uncounted
+    virtual void Unpark(int desktop) = 0;
+};
+
+namespace HideModePolicy {
+    // Splits a ';' or ',' separated list of executable names, trimming blanks.
+    // e.g. L"Code.exe; chrome.exe" -> { L"code.exe", L"chrome.exe" } (lower-cased)
+    std::vector<std::wstring> ParseAppList(const std::wstring& list);
+
+    // Picks the hide mode for a process image path. The file-name part of
+    // exePath is matched case-insensitively against the cloak app list.
+    HideMode SelectForExecutable(const std::wstring& exePath,
+        const std::vector<std::wstring>& cloakApps);
+
+    // Hides a window: cloaked if requested and possible, otherwise the
+    // traditional way, plus parking for UWP windows with the enhancement on.
+    // `mode` receives how, for RestoreState. False if nothing worked.
+    bool Hide(HideBackend& window, const HideRequest& request, HideMode& mode);
+
+    // Undoes Hide except for showing the window. A window is unparked if it
+    // was parked, whatever the enhancement setting is by now.
+    void PrepareRestore(HideBackend& window, const RestoreState& state);
+}
+
+#endif // HIDEMODE_H
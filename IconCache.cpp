@@ -0,0 +1,264 @@
+#include "IconCache.h"
+#include "IconPipeline.h"
+#include "Settings.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+    const std::uint32_t kMagic = 0x43495457;   // "WTIC"
+    const std::uint16_t kVersion = 1;
+    const int           kMaxSizes = 8;
+    const std::uint32_t kMaxKeyChars = 4096;
+
+    // File layout: the header, then `recordCount` records back to back
+    struct FileHeader {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t sizeCount;
+        std::uint32_t sizes[kMaxSizes];      // Layout of every record's pixels
+        std::uint32_t recordCount;
+        std::uint32_t reserved;
+    };
+
+    // Followed by the key (UTF-16, padded to 4 bytes) and the pixels; whole
+    // records are padded to 8 bytes
+    struct RecordHeader {
+        std::uint32_t recordBytes;
+        std::uint32_t keyChars;
+        std::uint64_t writeTime;
+        std::uint64_t sourceSize;
+        std::uint64_t lastUse;
+        std::uint32_t checksum;              // FNV-1a of the key and the pixels
+        std::uint32_t reserved;
+    };
+
+    const int kSizeCount = static_cast<int>(sizeof(IconPipeline::kIconSizes) / sizeof(IconPipeline::kIconSizes[0]));
+    static_assert(kSizeCount <= kMaxSizes, "cache header holds up to kMaxSizes sizes");
+    static_assert(sizeof(wchar_t) == 2, "keys are stored as UTF-16");
+
+    std::size_t KeyBytes(std::size_t chars)
+    {
+        return (chars * sizeof(wchar_t) + 3) & ~std::size_t(3);
+    }
+
+    std::size_t RecordBytes(std::size_t keyChars)
+    {
+        const std::size_t n = sizeof(RecordHeader) + KeyBytes(keyChars) + IconCache::PixelCount() * 4;
+        return (n + 7) & ~std::size_t(7);
+    }
+}
+
+std::size_t IconCache::PixelCount()
+{
+    std::size_t n = 0;
+    for (int size : IconPipeline::kIconSizes) n += static_cast<std::size_t>(size) * size;
+    return n;
+}
+
+bool IconCache::StampFile(const std::wstring& path, Stamp& stamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA fad{};
+    if (path.empty() || !::GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &fad) ||
+        (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        return false;
+    stamp.writeTime = (static_cast<std::uint64_t>(fad.ftLastWriteTime.dwHighDateTime) << 32) |
+        fad.ftLastWriteTime.dwLowDateTime;
+    stamp.size = (static_cast<std::uint64_t>(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+    return true;
+}
+
+std::wstring IconCache::DefaultPath()
+{
+    return SettingsManager::GetProgramDirectoryW() + L"\\icon_cache.bin";
+}
+
+std::uint32_t IconCache::Checksum(const std::wstring& key, const std::uint32_t* pixels)
+{
+    std::uint32_t h = 2166136261u;
+    auto mix = [&h](const void* data, std::size_t bytes) {
+        const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+        for (std::size_t i = 0; i < bytes; ++i) {
+            h ^= p[i];
+            h *= 16777619u;
+        }
+    };
+    mix(key.data(), key.size() * sizeof(wchar_t));
+    mix(pixels, PixelCount() * 4);
+    return h;
+}
+
+void IconCache::Load(const std::wstring& path)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    LoadLocked(path);
+}
+
+void IconCache::LoadLocked(const std::wstring& path)
+{
+    path_ = path;
+    entries_.clear();
+    file_.Close();
+    clock_ = 0;
+    dirty_ = false;
+    if (!file_.Open(path)) return;
+
+    // A file written for other sizes or by another version is ignored whole
+    const std::uint8_t* data = file_.data();
+    const std::size_t size = file_.size();
+    FileHeader header;
+    if (size < sizeof(header)) { file_.Close(); return; }
+    std::memcpy(&header, data, sizeof(header));
+    bool valid = header.magic == kMagic && header.version == kVersion && header.sizeCount == kSizeCount;
+    for (int i = 0; valid && i < kSizeCount; ++i) {
+        valid = header.sizes[i] == static_cast<std::uint32_t>(IconPipeline::kIconSizes[i]);
+    }
+    if (!valid) { file_.Close(); return; }
+
+    // Records up to the first malformed one are kept
+    std::size_t offset = sizeof(header);
+    for (std::uint32_t i = 0; i < header.recordCount; ++i) {
+        RecordHeader record;
+        if (size - offset < sizeof(record)) break;
+        std::memcpy(&record, data + offset, sizeof(record));
+        if (record.keyChars == 0 || record.keyChars > kMaxKeyChars ||
+            record.recordBytes != RecordBytes(record.keyChars) || size - offset < record.recordBytes)
+            break;
+
+        const wchar_t* key = reinterpret_cast<const wchar_t*>(data + offset + sizeof(record));
+        Entry& e = entries_[std::wstring(key, record.keyChars)];
+        e = Entry{};
+        e.stamp.writeTime = record.writeTime;
+        e.stamp.size = record.sourceSize;
+        e.lastUse = record.lastUse;
+        e.checksum = record.checksum;
+        e.mapped = reinterpret_cast<const std::uint32_t*>(
+            data + offset + sizeof(record) + KeyBytes(record.keyChars));
+        clock_ = std::max(clock_, record.lastUse);
+        offset += record.recordBytes;
+    }
+}
+
+bool IconCache::Find(const std::wstring& key, const Stamp& stamp, std::vector<std::uint32_t>& pixels)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.stamp.writeTime != stamp.writeTime ||
+        it->second.stamp.size != stamp.size) {
+        misses_++;
+        return false;
+    }
+
+    Entry& e = it->second;
+    if (!e.verified) {
+        if (Checksum(key, e.mapped) != e.checksum) {
+            // Damaged on disk; the rewrite drops it
+            entries_.erase(it);
+            dirty_ = true;
+            misses_++;
+            return false;
+        }
+        e.verified = true;
+    }
+
+    if (e.mapped) pixels.assign(e.mapped, e.mapped + PixelCount());
+    else pixels = e.pixels;
+    e.lastUse = ++clock_;
+    dirty_ = true;
+    hits_++;
+    return true;
+}
+
+void IconCache::Put(const std::wstring& key, const Stamp& stamp, const std::vector<std::uint32_t>& pixels)
+{
+    if (key.empty() || key.size() > kMaxKeyChars || pixels.size() != PixelCount()) return;
+
+    std::lock_guard<std::mutex> guard(lock_);
+    Entry& e = entries_[key];
+    e = Entry{};
+    e.stamp = stamp;
+    e.pixels = pixels;
+    e.checksum = Checksum(key, pixels.data());
+    e.verified = true;
+    e.lastUse = ++clock_;
+    dirty_ = true;
+}
+
+bool IconCache::Save()
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!dirty_ || path_.empty()) return true;
+
+    // Most recently used first, as many as fit under the cap
+    std::vector<const std::pair<const std::wstring, Entry>*> order;
+    order.reserve(entries_.size());
+    for (const auto& kv : entries_) order.push_back(&kv);
+    std::sort(order.begin(), order.end(),
+        [](const std::pair<const std::wstring, Entry>* a, const std::pair<const std::wstring, Entry>* b) {
+            return a->second.lastUse > b->second.lastUse;
+        });
+
+    const std::size_t pixelBytes = PixelCount() * 4;
+    FileHeader header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.sizeCount = static_cast<std::uint16_t>(kSizeCount);
+    for (int i = 0; i < kSizeCount; ++i) {
+        header.sizes[i] = static_cast<std::uint32_t>(IconPipeline::kIconSizes[i]);
+    }
+
+    std::vector<std::uint8_t> out(sizeof(header));
+    for (const auto* kv : order) {
+        if ((header.recordCount + 1) * pixelBytes > kMaxBytes) break;
+        const std::wstring& key = kv->first;
+        const Entry& e = kv->second;
+
+        RecordHeader record{};
+        record.recordBytes = static_cast<std::uint32_t>(RecordBytes(key.size()));
+        record.keyChars = static_cast<std::uint32_t>(key.size());
+        record.writeTime = e.stamp.writeTime;
+        record.sourceSize = e.stamp.size;
+        record.lastUse = e.lastUse;
+        record.checksum = e.checksum; // Unverified records keep theirs, so damage stays detectable
+
+        const std::size_t at = out.size();
+        out.resize(at + record.recordBytes, 0);
+        std::memcpy(&out[at], &record, sizeof(record));
+        std::memcpy(&out[at + sizeof(record)], key.data(), key.size() * sizeof(wchar_t));
+        std::memcpy(&out[at + sizeof(record) + KeyBytes(key.size())],
+            e.mapped ? e.mapped : e.pixels.data(), pixelBytes);
+        header.recordCount++;
+    }
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    // The view has to go before the file can be replaced
+    const std::wstring path = path_;
+    file_.Close();
+    entries_.clear();
+
+    const std::wstring temp = path + L".tmp";
+    bool ok = false;
+    HANDLE h = ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h != INVALID_HANDLE_VALUE) {
+        DWORD written = 0;
+        ok = ::WriteFile(h, out.data(), static_cast<DWORD>(out.size()), &written, nullptr) &&
+            written == out.size();
+        ::CloseHandle(h);
+        ok = ok && ::MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+        if (!ok) ::DeleteFileW(temp.c_str());
+    }
+
+    LoadLocked(path);
+    return ok;
+}
+
+IconCache::Stats IconCache::GetStats() const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    Stats s;
+    s.entries = entries_.size();
+    s.bytes = entries_.size() * PixelCount() * 4;
+    s.hits = hits_;
+    s.misses = misses_;
+    return s;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <windows.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+
+// Processed icons kept across runs in icon_cache.bin next to settings.ini.
+// An entry holds the final ARGB pixels of every size in
+// IconPipeline::kIconSizes, keyed by source identity and stamped with the
+// source file's write time and size, so a hit skips extraction and
+// background removal. Changed sources simply miss.
+//
+// The file is mapped at startup and its structure validated; each record's
+// checksum is checked when it is first used. New entries are kept in memory
+// and the file is rewritten on Save, least recently used entries dropped
+// beyond kMaxBytes. Thread-safe.
+class IconCache {
+public:
+    // Cap on the pixel bytes kept in the file
+    static constexpr std::size_t kMaxBytes = 4 * 1024 * 1024;
+
+    // Identity of a source file's content
+    struct Stamp {
+        std::uint64_t writeTime = 0;
+        std::uint64_t size = 0;
+    };
+
+    IconCache() = default;
+
+    IconCache(const IconCache&) = delete;
+    IconCache& operator=(const IconCache&) = delete;
+
+    // Reads the stamp of a source file; false if it can't be read.
+    [[nodiscard]] static bool StampFile(const std::wstring& path, Stamp& stamp);
+
+    // Path of the cache file (next to settings.ini).
+    static std::wstring DefaultPath();
+
+    // Maps and validates a cache file. A missing, foreign or damaged file
+    // leaves the cache empty; it is replaced on the next Save.
+    void Load(const std::wstring& path);
+
+    // Writes the cache back if anything changed.
+    bool Save();
+
+    // Pixels of all sizes, concatenated smallest first, if stored for `key`
+    // with the same stamp.
+    [[nodiscard]] bool Find(const std::wstring& key, const Stamp& stamp, std::vector<std::uint32_t>& pixels);
+    void Put(const std::wstring& key, const Stamp& stamp, const std::vector<std::uint32_t>& pixels);
+
+    // Pixel count of one entry: the sum of the squared sizes.
+    static std::size_t PixelCount();
+
+    struct Stats {
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+        long long   hits = 0;
+        long long   misses = 0;
+    };
+    [[nodiscard]] Stats GetStats() const;
+
+private:
+    struct Entry {
+        Stamp                      stamp;
+        std::uint64_t              lastUse = 0;
+        std::uint32_t              checksum = 0;
+        bool                       verified = false;   // Checksum checked (or computed here)
+        const std::uint32_t*       mapped = nullptr;   // Pixels inside the file view
+        std::vector<std::uint32_t> pixels;             // Pixels of entries added this run
+    };
+
+    static std::uint32_t Checksum(const std::wstring& key, const std::uint32_t* pixels);
+    void LoadLocked(const std::wstring& path);
+
+    mutable std::mutex                        lock_;
+    std::wstring                              path_;
+    MappedFile                                file_;
+    std::unordered_map<std::wstring, Entry>   entries_;
+    std::uint64_t                             clock_ = 0;     // Last use order
+    bool                                      dirty_ = false;
+    long long                                 hits_ = 0;
+    long long                                 misses_ = 0;
+};
+
+#endif // ICONCACHE_H
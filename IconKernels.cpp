@@ -0,0 +1,1048 @@
+#include "IconKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define ICONKERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ICONKERNELS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ICONKERNELS_TARGET(isa)
+#endif
+
+namespace {
+
+    using IconKernels::Isa;
+
+    int LowestBit(std::uint64_t m)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long i; _BitScanForward64(&i, m); return (int)i;
+#elif defined(_MSC_VER)
+        unsigned long i;
+        if (_BitScanForward(&i, (unsigned long)m)) return (int)i;
+        _BitScanForward(&i, (unsigned long)(m >> 32)); return (int)i + 32;
+#else
+        return __builtin_ctzll(m);
+#endif
+    }
+
+    int HighestBit(unsigned m)
+    {
+#if defined(_MSC_VER)
+        unsigned long i; _BitScanReverse(&i, m); return (int)i;
+#else
+        return 31 - __builtin_clz(m);
+#endif
+    }
+
+    // Precomputed weights of one resampling axis: output i reads `count[i]`
+    // input pixels from `start[i]`, weighted by weights[i * taps + k].
+    struct FilterTable {
+        IconKernels::Filter filter;
+        int srcLen = 0, dstLen = 0, taps = 0;
+        std::vector<int>   start, count;
+        std::vector<float> weights;
+    };
+
+    // Row primitives. `limit` is (threshold << 24) | 0xFFFFFF, so "alpha above
+    // threshold" is a plain unsigned compare against it.
+    struct RowKernels {
+        int (*firstAbove)(const std::uint32_t* row, int n, std::uint32_t limit);
+        int (*lastAbove)(const std::uint32_t* row, int n, std::uint32_t limit);
+        int (*matchEnd)(const std::uint32_t* row, int x, int n, std::uint32_t value, std::uint8_t tol);
+        int (*matchStart)(const std::uint32_t* row, int x, std::uint32_t value, std::uint8_t tol);
+        std::uint64_t (*matchBits)(const std::uint32_t* row, int n, std::uint32_t value, std::uint8_t tol);
+        // Resampling over premultiplied float pixels (4 floats each)
+        void (*convolve)(const float* src, float* dst, const FilterTable& t);
+        void (*accumulate)(float* acc, const float* src, float w, int n);
+        // Source format conversion. Masks are 1 bpp, most significant bit first.
+        void (*bgrToArgb)(const std::uint8_t* bgr, std::uint32_t* out, int n);
+        void (*lookup)(const std::uint8_t* index, const std::uint32_t* palette, std::uint32_t* out, int n);
+        void (*applyMask)(std::uint32_t* row, const std::uint8_t* mask, int n);
+    };
+
+    // --- Scalar ---
+
+    int FirstAboveScalar(const std::uint32_t* row, int n, std::uint32_t limit)
+    {
+        int i = 0;
+        while (i < n && row[i] <= limit) ++i;
+        return i;
+    }
+
+    int LastAboveScalar(const std::uint32_t* row, int n, std::uint32_t limit)
+    {
+        int i = n - 1;
+        while (i >= 0 && row[i] <= limit) --i;
+        return i;
+    }
+
+    // A pixel matches when every channel (alpha included) is within tol of value
+    inline bool Near(std::uint32_t p, std::uint32_t value, std::uint8_t tol)
+    {
+        if (p == value) return true;
+        for (int shift = 0; shift < 32; shift += 8) {
+            const int a = (p >> shift) & 0xFF, b = (value >> shift) & 0xFF;
+            if ((a > b ? a - b : b - a) > tol) return false;
+        }
+        return true;
+    }
+
+    // First index >= x whose pixel does not match value, or n
+    int MatchEndScalar(const std::uint32_t* row, int x, int n, std::uint32_t value, std::uint8_t tol)
+    {
+        while (x < n && Near(row[x], value, tol)) ++x;
+        return x;
+    }
+
+    // Leftmost index such that row[index..x] all match value (x + 1 if row[x] does not)
+    int MatchStartScalar(const std::uint32_t* row, int x, std::uint32_t value, std::uint8_t tol)
+    {
+        while (x >= 0 && Near(row[x], value, tol)) --x;
+        return x + 1;
+    }
+
+    // Bit i set when row[i] matches value, n <= 64
+    std::uint64_t MatchBitsScalar(const std::uint32_t* row, int n, std::uint32_t value, std::uint8_t tol)
+    {
+        std::uint64_t bits = 0;
+        for (int i = 0; i < n; ++i) {
+            if (Near(row[i], value, tol)) bits |= std::uint64_t(1) << i;
+        }
+        return bits;
+    }
+
+    // Horizontal pass: dst pixel i = sum of weighted src pixels
+    void ConvolveScalar(const float* src, float* dst, const FilterTable& t)
+    {
+        for (int i = 0; i < t.dstLen; ++i) {
+            const float* w = t.weights.data() + static_cast<std::size_t>(i) * t.taps;
+            const float* s = src + t.start[i] * 4;
+            float acc[4] = {};
+            for (int k = 0; k < t.count[i]; ++k) {
+                for (int c = 0; c < 4; ++c) acc[c] += w[k] * s[k * 4 + c];
+            }
+            std::copy(acc, acc + 4, dst + i * 4);
+        }
+    }
+
+    // Vertical pass: acc[i] += w * src[i] over n floats
+    void AccumulateScalar(float* acc, const float* src, float w, int n)
+    {
+        for (int i = 0; i < n; ++i) acc[i] += w * src[i];
+    }
+
+    // 24 bpp B,G,R triplets to opaque ARGB
+    void BgrToArgbScalar(const std::uint8_t* bgr, std::uint32_t* out, int n)
+    {
+        for (int i = 0; i < n; ++i, bgr += 3) {
+            out[i] = 0xFF000000u | (std::uint32_t(bgr[2]) << 16) | (std::uint32_t(bgr[1]) << 8) | bgr[0];
+        }
+    }
+
+    // Palette indices to colors; `palette` always has 256 entries
+    void LookupScalar(const std::uint8_t* index, const std::uint32_t* palette, std::uint32_t* out, int n)
+    {
+        for (int i = 0; i < n; ++i) out[i] = palette[index[i]];
+    }
+
+    // Clears the pixels whose AND mask bit is set
+    void ApplyMaskScalar(std::uint32_t* row, const std::uint8_t* mask, int n)
+    {
+        for (int i = 0; i < n; ++i) {
+            if (mask[i >> 3] & (0x80 >> (i & 7))) row[i] = 0;
+        }
+    }
+
+    const RowKernels kScalar = { FirstAboveScalar, LastAboveScalar, MatchEndScalar,
+        MatchStartScalar, MatchBitsScalar, ConvolveScalar, AccumulateScalar,
+        BgrToArgbScalar, LookupScalar, ApplyMaskScalar };
+
+#if ICONKERNELS_X86
+
+    // --- SSE2 (4 pixels per step) ---
+    // SSE2 only has signed compares; flipping the sign bit of both sides makes
+    // them order like unsigned values. Channel distance is |p - v| from two
+    // saturating subtractions; a pixel matches when no byte exceeds tol.
+
+    ICONKERNELS_TARGET("sse2")
+    inline int NearMask4(__m128i p, __m128i v, __m128i tol)
+    {
+        const __m128i dist = _mm_or_si128(_mm_subs_epu8(p, v), _mm_subs_epu8(v, p));
+        const __m128i over = _mm_subs_epu8(dist, tol);
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(over, _mm_setzero_si128())));
+    }
+
+    ICONKERNELS_TARGET("sse2")
+    int FirstAboveSse2(const std::uint32_t* row, int n, std::uint32_t limit)
+    {
+        const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+        const __m128i lim = _mm_set1_epi32((int)(limit ^ 0x80000000u));
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(row + i)), bias);
+            int m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, lim)));
+            if (m) return i + LowestBit((unsigned)m);
+        }
+        return i + FirstAboveScalar(row + i, n - i, limit);
+    }
+
+    ICONKERNELS_TARGET("sse2")
+    int LastAboveSse2(const std::uint32_t* row, int n, std::uint32_t limit)
+    {
+        const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+        const __m128i lim = _mm_set1_epi32((int)(limit ^ 0x80000000u));
+        int i = n;
+        for (; i >= 4; i -= 4) {
+            __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(row + i - 4)), bias);
+            int m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, lim)));
+            if (m) return i - 4 + HighestBit((unsigned)m);
+        }
+        return LastAboveScalar(row, i, limit);
+    }
+
+    ICONKERNELS_TARGET("sse2")
+    int MatchEndSse2(const std::uint32_t* row, int x, int n, std::uint32_t value, std::uint8_t tol)
+    {
+        const __m128i v = _mm_set1_epi32((int)value);
+        const __m128i t = _mm_set1_epi8((char)tol);
+        for (; x + 4 <= n; x += 4) {
+            int m = NearMask4(_mm_loadu_si128((const __m128i*)(row + x)), v, t) ^ 0xF;
+            if (m) return x + LowestBit((unsigned)m);
+        }
+        return MatchEndScalar(row, x, n, value, tol);
+    }
+
+    ICONKERNELS_TARGET("sse2")
+    int MatchStartSse2(const std::uint32_t* row, int x, std::uint32_t value, std::uint8_t tol)
+    {
+        const __m128i v = _mm_set1_epi32((int)value);
+        const __m128i t = _mm_set1_epi8((char)tol);
+        int end = x + 1; // Exclusive
+        for (; end >= 4; end -= 4) {
+            int m = NearMask4(_mm_loadu_si128((const __m128i*)(row + end - 4)), v, t) ^ 0xF;
+            if (m) return end - 4 + HighestBit((unsigned)m) + 1;
+        }
+        return MatchStartScalar(row, end - 1, value, tol);
+    }
+
+    ICONKERNELS_TARGET("sse2")
+    std::uint64_t MatchBitsSse2(const std::uint32_t* row, int n, std::uint32_t value, std::uint8_t tol)
+    {
+        const __m128i v = _mm_set1_epi32((int)value);
+        const __m128i t = _mm_set1_epi8((char)tol);
+        std::uint64_t bits = 0;
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            bits |= std::uint64_t(NearMask4(_mm_loadu_si128((const __m128i*)(row + i)), v, t)) << i;
+        }
+        if (i == n) return bits; // A 64-bit shift by 64 is undefined
+        return bits | (MatchBitsScalar(row + i, n - i, value, tol) << i);
+    }
+
+    ICONKERNELS_TARGET("sse2")
+    void ConvolveSse2(const float* src, float* dst, const FilterTable& t)
+    {
+        for (int i = 0; i < t.dstLen; ++i) {
+            const float* w = t.weights.data() + static_cast<std::size_t>(i) * t.taps;
+            const float* s = src + t.start[i] * 4;
+            __m128 acc = _mm_setzero_ps();
+            for (int k = 0; k < t.count[i]; ++k) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(s + k * 4)));
+            }
+            _mm_storeu_ps(dst + i * 4, acc);
+        }
+    }
+
+    ICONKERNELS_TARGET("sse2")
+    void AccumulateSse2(float* acc, const float* src, float w, int n)
+    {
+        const __m128 vw = _mm_set1_ps(w);
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(vw, _mm_loadu_ps(src + i))));
+        }
+        AccumulateScalar(acc + i, src + i, w, n - i);
+    }
+
+    // One mask byte covers 8 pixels: broadcast it and test one bit per lane
+    ICONKERNELS_TARGET("sse2")
+    void ApplyMaskSse2(std::uint32_t* row, const std::uint8_t* mask, int n)
+    {
+        const __m128i selLo = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+        const __m128i selHi = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+        const __m128i zero = _mm_setzero_si128();
+        int x = 0;
+        for (; x + 8 <= n; x += 8) {
+            const __m128i m = _mm_set1_epi32(mask[x >> 3]);
+            __m128i* p = (__m128i*)(row + x);
+            _mm_storeu_si128(p, _mm_and_si128(_mm_loadu_si128(p), _mm_cmpeq_epi32(_mm_and_si128(m, selLo), zero)));
+            _mm_storeu_si128(p + 1, _mm_and_si128(_mm_loadu_si128(p + 1), _mm_cmpeq_epi32(_mm_and_si128(m, selHi), zero)));
+        }
+        for (; x < n; ++x) {
+            if (mask[x >> 3] & (0x80 >> (x & 7))) row[x] = 0;
+        }
+    }
+
+    const RowKernels kSse2 = { FirstAboveSse2, LastAboveSse2, MatchEndSse2,
+        MatchStartSse2, MatchBitsSse2, ConvolveSse2, AccumulateSse2,
+        BgrToArgbScalar, LookupScalar, ApplyMaskSse2 };
+
+    // --- AVX2 (8 pixels per step) ---
+    // GCC and Clang don't clear the upper YMM halves on leaving a target("avx2")
+    // function, and the SSE2/scalar code that runs next (the tails here, the
+    // callers) then stalls on the dirty state. Every exit clears it first.
+
+    ICONKERNELS_TARGET("avx2")
+    inline int NearMask8(__m256i p, __m256i v, __m256i tol)
+    {
+        const __m256i dist = _mm256_or_si256(_mm256_subs_epu8(p, v), _mm256_subs_epu8(v, p));
+        const __m256i over = _mm256_subs_epu8(dist, tol);
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(over, _mm256_setzero_si256())));
+    }
+
+    ICONKERNELS_TARGET("avx2")
+    int FirstAboveAvx2(const std::uint32_t* row, int n, std::uint32_t limit)
+    {
+        const __m256i bias = _mm256_set1_epi32((int)0x80000000u);
+        const __m256i lim = _mm256_set1_epi32((int)(limit ^ 0x80000000u));
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(row + i)), bias);
+            int m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, lim)));
+            if (m) { _mm256_zeroupper(); return i + LowestBit((unsigned)m); }
+        }
+        _mm256_zeroupper();
+        return i + FirstAboveSse2(row + i, n - i, limit);
+    }
+
+    ICONKERNELS_TARGET("avx2")
+    int LastAboveAvx2(const std::uint32_t* row, int n, std::uint32_t limit)
+    {
+        const __m256i bias = _mm256_set1_epi32((int)0x80000000u);
+        const __m256i lim = _mm256_set1_epi32((int)(limit ^ 0x80000000u));
+        int i = n;
+        for (; i >= 8; i -= 8) {
+            __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(row + i - 8)), bias);
+            int m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, lim)));
+            if (m) { _mm256_zeroupper(); return i - 8 + HighestBit((unsigned)m); }
+        }
+        _mm256_zeroupper();
+        return LastAboveSse2(row, i, limit);
+    }
+
+    ICONKERNELS_TARGET("avx2")
+    int MatchEndAvx2(const std::uint32_t* row, int x, int n, std::uint32_t value, std::uint8_t tol)
+    {
+        const __m256i v = _mm256_set1_epi32((int)value);
+        const __m256i t = _mm256_set1_epi8((char)tol);
+        for (; x + 8 <= n; x += 8) {
+            int m = NearMask8(_mm256_loadu_si256((const __m256i*)(row + x)), v, t) ^ 0xFF;
+            if (m) { _mm256_zeroupper(); return x + LowestBit((unsigned)m); }
+        }
+        _mm256_zeroupper();
+        return MatchEndSse2(row, x, n, value, tol);
+    }
+
+    ICONKERNELS_TARGET("avx2")
+    int MatchStartAvx2(const std::uint32_t* row, int x, std::uint32_t value, std::uint8_t tol)
+    {
+        const __m256i v = _mm256_set1_epi32((int)value);
+        const __m256i t = _mm256_set1_epi8((char)tol);
+        int end = x + 1; // Exclusive
+        for (; end >= 8; end -= 8) {
+            int m = NearMask8(_mm256_loadu_si256((const __m256i*)(row + end - 8)), v, t) ^ 0xFF;
+            if (m) { _mm256_zeroupper(); return end - 8 + HighestBit((unsigned)m) + 1; }
+        }
+        _mm256_zeroupper();
+        return MatchStartSse2(row, end - 1, value, tol);
+    }
+
+    ICONKERNELS_TARGET("avx2")
+    std::uint64_t MatchBitsAvx2(const std::uint32_t* row, int n, std::uint32_t value, std::uint8_t tol)
+    {
+        const __m256i v = _mm256_set1_epi32((int)value);
+        const __m256i t = _mm256_set1_epi8((char)tol);
+        std::uint64_t bits = 0;
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            bits |= std::uint64_t(NearMask8(_mm256_loadu_si256((const __m256i*)(row + i)), v, t)) << i;
+        }
+        _mm256_zeroupper();
+        if (i == n) return bits;
+        return bits | (MatchBitsSse2(row + i, n - i, value, tol) << i);
+    }
+
+    // A pixel is one SSE register, so the horizontal pass stays on ConvolveSse2
+    ICONKERNELS_TARGET("avx2")
+    void AccumulateAvx2(float* acc, const float* src, float w, int n)
+    {
+        const __m256 vw = _mm256_set1_ps(w);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(acc + i,
+                _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(vw, _mm256_loadu_ps(src + i))));
+        }
+        _mm256_zeroupper();
+        AccumulateSse2(acc + i, src + i, w, n - i);
+    }
+
+    // Two 4-pixel groups of B,G,R bytes, one per 128-bit lane, widened with a
+    // byte shuffle. The second load reads 4 bytes past the group, hence x + 10.
+    ICONKERNELS_TARGET("avx2")
+    void BgrToArgbAvx2(const std::uint8_t* bgr, std::uint32_t* out, int n)
+    {
+        const __m256i shuffle = _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+        int x = 0;
+        for (; x + 10 <= n; x += 8) {
+            const std::uint8_t* p = bgr + x * 3;
+            __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                _mm_loadu_si128((const __m128i*)(p + 12)), 1);
+            _mm256_storeu_si256((__m256i*)(out + x), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha));
+        }
+        _mm256_zeroupper();
+        BgrToArgbScalar(bgr + x * 3, out + x, n - x);
+    }
+
+    ICONKERNELS_TARGET("avx2")
+    void LookupAvx2(const std::uint8_t* index, const std::uint32_t* palette, std::uint32_t* out, int n)
+    {
+        int x = 0;
+        for (; x + 8 <= n; x += 8) {
+            const __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(index + x)));
+            _mm256_storeu_si256((__m256i*)(out + x), _mm256_i32gather_epi32((const int*)palette, idx, 4));
+        }
+        _mm256_zeroupper();
+        LookupScalar(index + x, palette, out + x, n - x);
+    }
+
+    ICONKERNELS_TARGET("avx2")
+    void ApplyMaskAvx2(std::uint32_t* row, const std::uint8_t* mask, int n)
+    {
+        const __m256i sel = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+        const __m256i zero = _mm256_setzero_si256();
+        int x = 0;
+        for (; x + 8 <= n; x += 8) {
+            const __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(mask[x >> 3]), sel), zero);
+            __m256i* p = (__m256i*)(row + x);
+            _mm256_storeu_si256(p, _mm256_and_si256(_mm256_loadu_si256(p), keep));
+        }
+        _mm256_zeroupper();
+        for (; x < n; ++x) {
+            if (mask[x >> 3] & (0x80 >> (x & 7))) row[x] = 0;
+        }
+    }
+
+    const RowKernels kAvx2 = { FirstAboveAvx2, LastAboveAvx2, MatchEndAvx2,
+        MatchStartAvx2, MatchBitsAvx2, ConvolveSse2, AccumulateAvx2,
+        BgrToArgbAvx2, LookupAvx2, ApplyMaskAvx2 };
+
+    bool CpuHasSse2()
+    {
+#if defined(_M_X64) || defined(__x86_64__)
+        return true; // Baseline on x64
+#elif defined(_MSC_VER)
+        int r[4]; __cpuid(r, 1); return (r[3] & (1 << 26)) != 0;
+#else
+        return __builtin_cpu_supports("sse2");
+#endif
+    }
+
+    bool CpuHasAvx2()
+    {
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuid(r, 0);
+        if (r[0] < 7) return false;
+        __cpuid(r, 1);
+        const bool osxsave = (r[2] & (1 << 27)) != 0;
+        const bool avx = (r[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        if ((_xgetbv(0) & 0x6) != 0x6) return false; // OS saves XMM and YMM state
+        __cpuidex(r, 7, 0);
+        return (r[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+#endif // ICONKERNELS_X86
+
+    const RowKernels* KernelsFor(Isa isa)
+    {
+        switch (isa) {
+#if ICONKERNELS_X86
+        case Isa::Avx2: return &kAvx2;
+        case Isa::Sse2: return &kSse2;
+#endif
+        default:        return &kScalar;
+        }
+    }
+
+    Isa& ActiveIsaRef()
+    {
+        static Isa isa = IconKernels::BestSupportedIsa();
+        return isa;
+    }
+
+    const RowKernels& Active()
+    {
+        return *KernelsFor(ActiveIsaRef());
+    }
+}
+
+IconKernels::Isa IconKernels::BestSupportedIsa()
+{
+#if ICONKERNELS_X86
+    if (CpuHasAvx2()) return Isa::Avx2;
+    if (CpuHasSse2()) return Isa::Sse2;
+#endif
+    return Isa::Scalar;
+}
+
+IconKernels::Isa IconKernels::ActiveIsa()
+{
+    return ActiveIsaRef();
+}
+
+bool IconKernels::SelectIsa(Isa isa)
+{
+    if (static_cast<int>(isa) > static_cast<int>(BestSupportedIsa())) return false;
+    ActiveIsaRef() = isa;
+    return true;
+}
+
+const char* IconKernels::IsaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::Avx2: return "AVX2";
+    case Isa::Sse2: return "SSE2";
+    default:        return "scalar";
+    }
+}
+
+std::size_t IconKernels::FloodFillCorners(std::uint32_t* pixels, int width, int height, int stride,
+    std::vector<FillSeed>& stack, std::uint8_t tolerance, std::vector<std::uint8_t>* clearedMask)
+{
+    if (clearedMask) clearedMask->assign(static_cast<std::size_t>(width > 0 ? width : 0) * (height > 0 ? height : 0), 0);
+    if (!pixels || width <= 0 || height <= 0) return 0;
+
+    const std::uint32_t bg = pixels[0];
+    const unsigned bgAlpha = bg >> 24;
+    if (bgAlpha == 0) return 0; // Already transparent, nothing to remove
+
+    // Fill pixels are set to 0; keeping the tolerance below the bg alpha
+    // means a cleared pixel never matches again
+    const std::uint8_t tol = static_cast<std::uint8_t>(std::min<unsigned>(tolerance, bgAlpha - 1));
+
+    const RowKernels& k = Active();
+
+    auto row = [&](int y) { return pixels + static_cast<std::ptrdiff_t>(y) * stride; };
+
+    stack.clear();
+    const FillSeed corners[] = { { 0, 0 }, { width - 1, 0 }, { 0, height - 1 }, { width - 1, height - 1 } };
+    for (const FillSeed& c : corners) {
+        if (Near(row(c.y)[c.x], bg, tol)) stack.push_back(c);
+    }
+
+    // Pushes one seed per run of bg pixels in [x0, x1] on row y, 64 pixels
+    // at a time: a run starts where a match bit follows a non-match
+    auto scanRow = [&](int y, int x0, int x1) {
+        const std::uint32_t* r = row(y);
+        bool prevMatch = false;
+        for (int x = x0; x <= x1; x += 64) {
+            const int n = std::min(64, x1 - x + 1);
+            const std::uint64_t bits = k.matchBits(r + x, n, bg, tol);
+            std::uint64_t starts = bits & ~((bits << 1) | (prevMatch ? 1u : 0u));
+            while (starts) {
+                stack.push_back({ x + LowestBit(starts), y });
+                starts &= starts - 1;
+            }
+            prevMatch = (bits >> (n - 1)) & 1;
+        }
+    };
+
+    std::size_t cleared = 0;
+    while (!stack.empty()) {
+        const FillSeed s = stack.back();
+        stack.pop_back();
+
+        std::uint32_t* r = row(s.y);
+        if (!Near(r[s.x], bg, tol)) continue; // Filled through another seed meanwhile
+
+        const int left = k.matchStart(r, s.x, bg, tol);
+        const int right = k.matchEnd(r, s.x, width, bg, tol) - 1;
+
+        std::fill(r + left, r + right + 1, 0u);
+        if (clearedMask) {
+            std::uint8_t* m = clearedMask->data() + static_cast<std::size_t>(s.y) * width;
+            std::fill(m + left, m + right + 1, std::uint8_t(1));
+        }
+        cleared += static_cast<std::size_t>(right - left + 1);
+
+        if (s.y > 0) scanRow(s.y - 1, left, right);
+        if (s.y < height - 1) scanRow(s.y + 1, left, right);
+    }
+    return cleared;
+}
+
+std::size_t IconKernels::DecontaminateEdges(std::uint32_t* pixels, int width, int height, int stride,
+    std::uint32_t background, const std::vector<std::uint8_t>& clearedMask)
+{
+    if (!pixels || width <= 0 || height <= 0) return 0;
+    if (clearedMask.size() < static_cast<std::size_t>(width) * height) return 0;
+
+    const float bgc[3] = {
+        float((background >> 16) & 0xFF), float((background >> 8) & 0xFF), float(background & 0xFF)
+    };
+
+    auto cleared = [&](int x, int y) {
+        return x >= 0 && y >= 0 && x < width && y < height
+            && clearedMask[static_cast<std::size_t>(y) * width + x] != 0;
+    };
+
+    std::size_t changed = 0;
+    for (int y = 0; y < height; ++y) {
+        std::uint32_t* r = pixels + static_cast<std::ptrdiff_t>(y) * stride;
+        const std::uint8_t* m = clearedMask.data() + static_cast<std::size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            const std::uint32_t p = r[x];
+            if (m[x] || (p >> 24) == 0) continue;
+            if (!cleared(x - 1, y) && !cleared(x + 1, y) && !cleared(x, y - 1) && !cleared(x, y + 1))
+                continue;
+
+            // Observed = a * fg + (1 - a) * bg. The smallest a that keeps every
+            // channel of fg in range is the coverage of the foreground.
+            const float c[3] = { float((p >> 16) & 0xFF), float((p >> 8) & 0xFF), float(p & 0xFF) };
+            float a = 0.0f;
+            for (int i = 0; i < 3; ++i) {
+                if (c[i] > bgc[i]) a = std::max(a, (c[i] - bgc[i]) / (255.0f - bgc[i]));
+                else if (c[i] < bgc[i]) a = std::max(a, (bgc[i] - c[i]) / bgc[i]);
+            }
+            if (a >= 1.0f) continue; // Fully covered, nothing of bg blended in
+
+            std::uint32_t out = 0;
+            const unsigned alpha = static_cast<unsigned>(a * float(p >> 24) + 0.5f);
+            if (alpha) {
+                // Remove the bg share (premultiplied fg), then un-premultiply
+                out = alpha << 24;
+                for (int i = 0; i < 3; ++i) {
+                    float f = (c[i] - (1.0f - a) * bgc[i]) / a;
+                    f = std::min(255.0f, std::max(0.0f, f));
+                    out |= static_cast<std::uint32_t>(f + 0.5f) << (16 - 8 * i);
+                }
+            }
+            r[x] = out;
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+IconKernels::Bounds IconKernels::AlphaBounds(const std::uint32_t* pixels, int width, int height,
+    int stride, std::uint8_t alphaThreshold)
+{
+    const RowKernels& k = Active();
+    const std::uint32_t limit = (std::uint32_t(alphaThreshold) << 24) | 0x00FFFFFFu;
+
+    Bounds b;
+    b.left = width;
+    b.top = height;
+
+    for (int y = 0; y < height; ++y) {
+        const std::uint32_t* r = pixels + static_cast<std::ptrdiff_t>(y) * stride;
+
+        // First and last visible pixel of the row
+        const int first = k.firstAbove(r, width, limit);
+        if (first == width) continue;
+        const int last = k.lastAbove(r, width, limit);
+
+        if (b.bottom < 0) b.top = y;
+        b.bottom = y;
+        b.left = std::min(b.left, first);
+        b.right = std::max(b.right, last);
+    }
+
+    if (b.bottom < 0) return Bounds{};
+    return b;
+}
+
+double IconKernels::ChooseScale(const Bounds& content, int width, int height)
+{
+    if (content.empty()) return 1.0;
+
+    const int minDistance = std::min({ content.left, content.top,
+        width - 1 - content.right, height - 1 - content.bottom });
+
+    double scale = std::min((double)width / content.width(), (double)height / content.height());
+    scale = std::min(scale, 3.0); // Limit max scale
+    scale = std::max(scale, 1.0); // Don't shrink
+    if (minDistance < 4) {
+        scale = std::min(scale, 1.2); // Limit scale if content is already near edge
+    }
+    return scale;
+}
+
+namespace {
+
+    // Premultiplied float pixels (times `scale`) back to straight ARGB. Filter
+    // overshoot is clamped and color limited to what the alpha can carry.
+    void PackRow(const float* acc, float scale, std::uint32_t* out, int n)
+    {
+        for (int x = 0; x < n; ++x) {
+            const float* c = acc + x * 4;
+            const float a = std::min(255.0f, c[3] * scale);
+            if (a < 0.5f) {
+                out[x] = 0;
+                continue;
+            }
+            std::uint32_t px = static_cast<std::uint32_t>(a + 0.5f) << 24;
+            for (int i = 0; i < 3; ++i) {
+                const float v = std::min(255.0f, std::max(0.0f, c[i] * scale * 255.0f / a));
+                px |= static_cast<std::uint32_t>(v + 0.5f) << (16 - 8 * i);
+            }
+            out[x] = px;
+        }
+    }
+
+    float FilterWeight(IconKernels::Filter filter, float x)
+    {
+        x = std::fabs(x);
+        if (filter == IconKernels::Filter::Box) return x < 0.5f ? 1.0f : (x == 0.5f ? 0.5f : 0.0f);
+
+        // Lanczos3: sinc(x) * sinc(x / 3)
+        if (x < 1e-6f) return 1.0f;
+        if (x >= 3.0f) return 0.0f;
+        const float pi = 3.14159265358979f;
+        return 3.0f * std::sin(pi * x) * std::sin(pi * x / 3.0f) / (pi * pi * x * x);
+    }
+
+    void BuildFilterTable(FilterTable& t, IconKernels::Filter filter, int srcLen, int dstLen)
+    {
+        t.filter = filter;
+        t.srcLen = srcLen;
+        t.dstLen = dstLen;
+
+        // When shrinking, the filter widens so every source pixel contributes
+        const float ratio = float(srcLen) / float(dstLen);
+        const float stretch = std::max(1.0f, ratio);
+        const float radius = (filter == IconKernels::Filter::Box ? 0.5f : 3.0f) * stretch;
+
+        t.taps = static_cast<int>(std::ceil(radius)) * 2 + 1;
+        t.start.assign(dstLen, 0);
+        t.count.assign(dstLen, 0);
+        t.weights.assign(static_cast<std::size_t>(dstLen) * t.taps, 0.0f);
+
+        for (int i = 0; i < dstLen; ++i) {
+            const float center = (float(i) + 0.5f) * ratio;
+            const int first = std::max(0, static_cast<int>(center - radius + 0.5f));
+            const int last = std::min(srcLen, static_cast<int>(center + radius + 0.5f)); // Exclusive
+            float* w = t.weights.data() + static_cast<std::size_t>(i) * t.taps;
+
+            int n = std::min(std::max(last - first, 1), t.taps);
+            float sum = 0.0f;
+            for (int k = 0; k < n; ++k) {
+                w[k] = FilterWeight(filter, (float(first + k) + 0.5f - center) / stretch);
+                sum += w[k];
+            }
+            if (sum != 0.0f) {
+                for (int k = 0; k < n; ++k) w[k] /= sum;
+            }
+            else {
+                n = 1; // Degenerate footprint, take the nearest pixel
+                w[0] = 1.0f;
+            }
+            t.start[i] = std::min(first, srcLen - n);
+            t.count[i] = n;
+        }
+    }
+
+    // Icons come in a handful of sizes, so the last few tables are kept per thread
+    std::shared_ptr<const FilterTable> FilterTableFor(IconKernels::Filter filter, int srcLen, int dstLen)
+    {
+        thread_local std::vector<std::shared_ptr<const FilterTable>> cache;
+        for (const auto& t : cache) {
+            if (t->filter == filter && t->srcLen == srcLen && t->dstLen == dstLen) return t;
+        }
+        auto table = std::make_shared<FilterTable>();
+        BuildFilterTable(*table, filter, srcLen, dstLen);
+        if (cache.size() >= 8) cache.erase(cache.begin());
+        cache.push_back(table);
+        return table;
+    }
+}
+
+void IconKernels::Resample(const std::uint32_t* src, int srcWidth, int srcHeight, int srcStride,
+    std::uint32_t* dst, int dstWidth, int dstHeight, int dstStride, Filter filter)
+{
+    if (!src || !dst || srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) return;
+
+    const RowKernels& k = Active();
+    const auto horzTable = FilterTableFor(filter, srcWidth, dstWidth);
+    const auto vertTable = FilterTableFor(filter, srcHeight, dstHeight);
+    const FilterTable& horz = *horzTable;
+    const FilterTable& vert = *vertTable;
+
+    thread_local std::vector<float> line, mid, acc;
+    line.resize(static_cast<std::size_t>(srcWidth) * 4);
+    mid.resize(static_cast<std::size_t>(srcHeight) * dstWidth * 4);
+    acc.resize(static_cast<std::size_t>(dstWidth) * 4);
+
+    // Horizontal pass, one premultiplied source row at a time
+    for (int y = 0; y < srcHeight; ++y) {
+        const std::uint32_t* r = src + static_cast<std::ptrdiff_t>(y) * srcStride;
+        for (int x = 0; x < srcWidth; ++x) {
+            const std::uint32_t p = r[x];
+            const float a = float(p >> 24);
+            const float f = a / 255.0f;
+            float* o = line.data() + x * 4;
+            o[0] = float((p >> 16) & 0xFF) * f;
+            o[1] = float((p >> 8) & 0xFF) * f;
+            o[2] = float(p & 0xFF) * f;
+            o[3] = a;
+        }
+        k.convolve(line.data(), mid.data() + static_cast<std::size_t>(y) * dstWidth * 4, horz);
+    }
+
+    // Vertical pass, then back to straight alpha
+    const int rowFloats = dstWidth * 4;
+    for (int y = 0; y < dstHeight; ++y) {
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        const float* w = vert.weights.data() + static_cast<std::size_t>(y) * vert.taps;
+        for (int t = 0; t < vert.count[y]; ++t) {
+            k.accumulate(acc.data(), mid.data() + static_cast<std::size_t>(vert.start[y] + t) * rowFloats,
+                w[t], rowFloats);
+        }
+
+        PackRow(acc.data(), 1.0f, dst + static_cast<std::ptrdiff_t>(y) * dstStride, dstWidth);
+    }
+}
+
+IconKernels::AreaScaler::AreaScaler(int srcWidth, int srcHeight, std::uint32_t* dst, int dstWidth, int dstHeight,
+    int dstStride)
+    : srcWidth_(srcWidth), srcHeight_(srcHeight), dst_(dst), dstWidth_(dstWidth), dstHeight_(dstHeight),
+      dstStride_(dstStride)
+{
+    if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0 ||
+        dstWidth > srcWidth || dstHeight > srcHeight) {
+        srcHeight_ = 0; // Nothing will be accepted
+        return;
+    }
+
+    // Source pixel x spans [x * dstWidth, (x + 1) * dstWidth) and output pixel
+    // o spans [o * srcWidth, (o + 1) * srcWidth); when reducing, a source
+    // pixel overlaps at most two outputs
+    firstOut_.resize(srcWidth);
+    firstWeight_.resize(srcWidth);
+    for (int x = 0; x < srcWidth; ++x) {
+        const long long start = static_cast<long long>(x) * dstWidth;
+        const long long out = start / srcWidth;
+        const long long boundary = (out + 1) * srcWidth;
+        firstOut_[x] = static_cast<int>(out);
+        firstWeight_[x] = static_cast<float>(std::min<long long>(start + dstWidth, boundary) - start);
+    }
+    line_.assign(static_cast<std::size_t>(dstWidth) * 4, 0.0f);
+    acc_[0].assign(line_.size(), 0.0f);
+    acc_[1].assign(line_.size(), 0.0f);
+}
+
+void IconKernels::AreaScaler::PushRow(const std::uint32_t* row)
+{
+    if (!row || y_ >= srcHeight_) return;
+
+    // Horizontal: premultiply and spread each pixel over its one or two outputs
+    std::fill(line_.begin(), line_.end(), 0.0f);
+    const float full = static_cast<float>(dstWidth_);
+    for (int x = 0; x < srcWidth_; ++x) {
+        const std::uint32_t p = row[x];
+        const float a = float(p >> 24);
+        const float f = a / 255.0f;
+        const float c[4] = { float((p >> 16) & 0xFF) * f, float((p >> 8) & 0xFF) * f, float(p & 0xFF) * f, a };
+        float* o = line_.data() + static_cast<std::size_t>(firstOut_[x]) * 4;
+        const float w0 = firstWeight_[x];
+        for (int i = 0; i < 4; ++i) o[i] += w0 * c[i];
+        if (w0 < full) {
+            for (int i = 0; i < 4; ++i) o[4 + i] += (full - w0) * c[i];
+        }
+    }
+
+    // Vertical: same split between the current output row and the next
+    const RowKernels& k = Active();
+    const int n = dstWidth_ * 4;
+    const long long start = static_cast<long long>(y_) * dstHeight_;
+    const long long end = start + dstHeight_;
+    const long long out = start / srcHeight_;
+    const long long boundary = (out + 1) * srcHeight_;
+    std::vector<float>& current = acc_[out & 1];
+    k.accumulate(current.data(), line_.data(), static_cast<float>(std::min(end, boundary) - start), n);
+    if (end > boundary) {
+        k.accumulate(acc_[(out + 1) & 1].data(), line_.data(), static_cast<float>(end - boundary), n);
+    }
+
+    if (end >= boundary) {
+        // Every source row of this output has arrived
+        const float scale = 1.0f / (static_cast<float>(srcWidth_) * static_cast<float>(srcHeight_));
+        PackRow(current.data(), scale, dst_ + static_cast<std::ptrdiff_t>(out) * dstStride_, dstWidth_);
+        std::fill(current.begin(), current.end(), 0.0f);
+    }
+    ++y_;
+}
+
+bool IconKernels::ConvertToArgb(const SourceBitmap& color, const std::uint8_t* mask, int maskStride,
+    int width, int height, std::uint32_t* dst, int dstStride)
+{
+    if (!color.bits || !dst || width <= 0 || height <= 0) return false;
+
+    const int bpp = color.bitsPerPixel;
+    if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 24 && bpp != 32) return false;
+
+    const RowKernels& k = Active();
+    auto srcRow = [&](int y) { return color.bits + static_cast<std::ptrdiff_t>(y) * color.stride; };
+    auto dstRow = [&](int y) { return dst + static_cast<std::ptrdiff_t>(y) * dstStride; };
+
+    // A 32 bpp image with any alpha set carries its own transparency; one
+    // with all-zero alpha is an old-style icon that relies on the mask
+    bool useMask = mask != nullptr;
+    if (bpp == 32) {
+        std::uint32_t alphaSeen = 0;
+        for (int y = 0; y < height; ++y) {
+            const std::uint8_t* r = srcRow(y);
+            std::copy(r, r + static_cast<std::size_t>(width) * 4, reinterpret_cast<std::uint8_t*>(dstRow(y)));
+            for (int x = 0; x < width && !alphaSeen; ++x) alphaSeen = dstRow(y)[x] & 0xFF000000u;
+        }
+        if (alphaSeen) return true;
+        for (int y = 0; y < height; ++y) {
+            std::uint32_t* r = dstRow(y);
+            for (int x = 0; x < width; ++x) r[x] |= 0xFF000000u;
+        }
+    }
+    else if (bpp == 24) {
+        for (int y = 0; y < height; ++y) k.bgrToArgb(srcRow(y), dstRow(y), width);
+    }
+    else {
+        // Missing palette entries read as opaque black
+        std::uint32_t palette[256];
+        std::fill(palette, palette + 256, 0xFF000000u);
+        const int entries = std::min(color.palette ? color.paletteSize : 0, 1 << bpp);
+        for (int i = 0; i < entries; ++i) palette[i] = 0xFF000000u | (color.palette[i] & 0xFFFFFF);
+
+        thread_local std::vector<std::uint8_t> index;
+        index.resize(width);
+        for (int y = 0; y < height; ++y) {
+            const std::uint8_t* r = srcRow(y);
+            const std::uint8_t* idx = r;
+            if (bpp != 8) {
+                // Unpack to one byte per pixel, most significant bits first
+                const int perByte = 8 / bpp;
+                const int valueMask = (1 << bpp) - 1;
+                for (int x = 0; x < width; ++x) {
+                    const int shift = 8 - bpp * (x % perByte + 1);
+                    index[x] = static_cast<std::uint8_t>((r[x / perByte] >> shift) & valueMask);
+                }
+                idx = index.data();
+            }
+            k.lookup(idx, palette, dstRow(y), width);
+        }
+    }
+
+    if (useMask) {
+        for (int y = 0; y < height; ++y) {
+            k.applyMask(dstRow(y), mask + static_cast<std::ptrdiff_t>(y) * maskStride, width);
+        }
+    }
+    return true;
+}
+
+namespace {
+
+    // 3x5 dot glyphs for the count badge: 0-9, then '+'. Rows top first, three
+    // bits each, leftmost dot in the high bit.
+    const std::uint16_t kBadgeGlyphs[] = {
+        0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF, 0x05D0
+    };
+    const int kBadgePlus = 10;
+
+    const std::uint32_t kBadgeColor = 0xFFD13438;   // Opaque red
+    const std::uint32_t kBadgeText = 0xFFFFFFFF;
+
+    // `color` (opaque) at `coverage` (0-255) over a straight-alpha pixel
+    std::uint32_t BlendOver(std::uint32_t color, int coverage, std::uint32_t dst)
+    {
+        const int dstA = static_cast<int>(dst >> 24);
+        const int outA = coverage + dstA * (255 - coverage) / 255;
+        if (outA == 0) return 0;
+        std::uint32_t out = static_cast<std::uint32_t>(outA) << 24;
+        for (int shift = 0; shift < 24; shift += 8) {
+            const int c = static_cast<int>((color >> shift) & 0xFF);
+            const int d = static_cast<int>((dst >> shift) & 0xFF);
+            const int v = (c * coverage * 255 + d * dstA * (255 - coverage)) / (outA * 255);
+            out |= static_cast<std::uint32_t>(std::min(v, 255)) << shift;
+        }
+        return out;
+    }
+}
+
+void IconKernels::DrawCountBadge(std::uint32_t* pixels, int size, int stride, int count)
+{
+    if (!pixels || size < 16 || count < 1) return;
+
+    int glyphs[3];
+    int n = 0;
+    const int shown = std::min(count, 99);
+    if (shown >= 10) glyphs[n++] = shown / 10;
+    glyphs[n++] = shown % 10;
+    if (count > 99) glyphs[n++] = kBadgePlus;
+
+    // One dot per pixel up to 27 px icons, then scaled with the icon
+    const int dot = std::max(1, (size + 4) / 16);
+    const int textWidth = n * 3 * dot + (n - 1) * dot;
+    const int height = 7 * dot;
+    const int width = std::min(size, std::max(height, textWidth + 4 * dot));
+    const int left = size - width;
+    const int top = size - height;
+
+    // Capsule in the bottom-right corner, edges anti-aliased from 4x4 samples
+    const float r = height * 0.5f;
+    for (int y = 0; y < height; ++y) {
+        std::uint32_t* row = pixels + static_cast<std::ptrdiff_t>(top + y) * stride + left;
+        for (int x = 0; x < width; ++x) {
+            int inside = 0;
+            for (int sy = 0; sy < 4; ++sy) {
+                const float dy = y + (sy + 0.5f) * 0.25f - r;
+                for (int sx = 0; sx < 4; ++sx) {
+                    const float px = x + (sx + 0.5f) * 0.25f;
+                    const float dx = px - std::min(std::max(px, r), width - r);
+                    if (dx * dx + dy * dy <= r * r) inside++;
+                }
+            }
+            if (inside) row[x] = BlendOver(kBadgeColor, inside * 255 / 16, row[x]);
+        }
+    }
+
+    // Digits on whole dots, centered
+    int gx = left + (width - textWidth) / 2;
+    const int gy = top + dot;
+    for (int i = 0; i < n; ++i, gx += 4 * dot) {
+        const std::uint16_t bits = kBadgeGlyphs[glyphs[i]];
+        for (int row = 0; row < 5; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                if (!((bits >> (14 - row * 3 - col)) & 1)) continue;
+                for (int y = 0; y < dot; ++y) {
+                    std::uint32_t* p = pixels + static_cast<std::ptrdiff_t>(gy + row * dot + y) * stride + gx + col * dot;
+                    std::fill(p, p + dot, kBadgeText);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#pragma once
+#ifndef ICONKERNELS_H
+#define ICONKERNELS_H
+
+// Pixel work of the icon background removal and scaling, over raw 32bpp ARGB
+// buffers (0xAARRGGBB per pixel, rows `stride` pixels apart). Platform-neutral.
+//
+// Row scans (alpha tests, background matches, format conversion) and the
+// resampler's inner loops run on SSE2 or AVX2 when the CPU has them, picked
+// once at first use; every path gives identical results.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace IconKernels {
+
+    // Instruction sets the row scans can use, in increasing order.
+    enum class Isa { Scalar, Sse2, Avx2 };
+
+    Isa         BestSupportedIsa();
+    Isa         ActiveIsa();
+    // Switches the row scans (e.g. to compare paths); false if the CPU lacks it.
+    bool        SelectIsa(Isa isa);
+    const char* IsaName(Isa isa);
+
+    // Inclusive bounding box of the visible content.
+    struct Bounds {
+        int left = 0, top = 0, right = -1, bottom = -1;
+
+        bool empty() const { return right < left || bottom < top; }
+        int  width() const { return empty() ? 0 : right - left + 1; }
+        int  height() const { return empty() ? 0 : bottom - top + 1; }
+    };
+
+    // Seed of the span fill: one per run of matching pixels.
+    struct FillSeed {
+        int x, y;
+    };
+
+    // If the top-left pixel is not fully transparent, clears (sets to 0) every
+    // pixel within `tolerance` of that color on each channel (0 = exact match)
+    // and 4-connected to one of the four corners.
+    // `stack` is scratch space; it is reused across calls and only grows when
+    // an icon needs more seeds than any before it. If `clearedMask` is given it
+    // receives width * height bytes, 1 per cleared pixel. Returns the cleared count.
+    std::size_t FloodFillCorners(std::uint32_t* pixels, int width, int height, int stride,
+        std::vector<FillSeed>& stack, std::uint8_t tolerance = 0,
+        std::vector<std::uint8_t>* clearedMask = nullptr);
+
+    // Anti-aliased edges are partly blended with the removed background. For
+    // each visible pixel next to a cleared one, estimates how much of it is
+    // foreground, takes the background share out and stores the result with
+    // that coverage as alpha (`background` is the color the fill removed).
+    // Returns the number of pixels changed.
+    std::size_t DecontaminateEdges(std::uint32_t* pixels, int width, int height, int stride,
+        std::uint32_t background, const std::vector<std::uint8_t>& clearedMask);
+
+    // Bounding box of the pixels whose alpha is above `alphaThreshold`.
+    Bounds AlphaBounds(const std::uint32_t* pixels, int width, int height, int stride,
+        std::uint8_t alphaThreshold = 16);
+
+    // How much to enlarge the content so it fills the icon: at most 3x, never
+    // shrinking, and at most 1.2x when the content already comes within 4 px
+    // of an edge. Returns 1.0 for empty content.
+    double ChooseScale(const Bounds& content, int width, int height);
+
+    // One icon bitmap laid out as GetDIBits returns it for a top-down DIB:
+    // rows `stride` bytes apart; 1/4/8 bpp index `palette` (0x00RRGGBB
+    // entries), 24 bpp is B,G,R and 32 bpp is B,G,R,A.
+    struct SourceBitmap {
+        const std::uint8_t*  bits = nullptr;
+        int                  bitsPerPixel = 0;
+        int                  stride = 0;
+        const std::uint32_t* palette = nullptr;
+        int                  paletteSize = 0;
+    };
+
+    // Converts an icon's color bitmap and AND mask (1 bpp, set bits are
+    // transparent; may be null) into ARGB. Masked pixels become 0, the rest
+    // are opaque, so the result reads the same as straight or premultiplied
+    // alpha. 32 bpp sources that carry alpha keep it and ignore the mask.
+    // Returns false for unsupported depths.
+    bool ConvertToArgb(const SourceBitmap& color, const std::uint8_t* mask, int maskStride,
+        int width, int height, std::uint32_t* dst, int dstStride);
+
+    enum class Filter { Box, Lanczos3 };
+
+    // Scales src to dstWidth x dstHeight with a separable filter. Input and
+    // output are straight alpha; filtering happens on premultiplied values so
+    // transparent pixels don't bleed their color into edges. Filter weights
+    // are computed once per size pair and reused.
+    void Resample(const std::uint32_t* src, int srcWidth, int srcHeight, int srcStride,
+        std::uint32_t* dst, int dstWidth, int dstHeight, int dstStride, Filter filter);
+
+    // Area-average reduction fed one source row at a time, for decoders that
+    // stream scanlines. Each output row is written as soon as its last source
+    // row arrives, so only two accumulator rows are held. Averages are taken
+    // on premultiplied values; output is straight alpha. The output must be
+    // no larger than the source on either axis, otherwise rows are ignored.
+    class AreaScaler {
+    public:
+        AreaScaler(int srcWidth, int srcHeight, std::uint32_t* dst, int dstWidth, int dstHeight, int dstStride);
+
+        // Source rows in order, srcWidth pixels each.
+        void PushRow(const std::uint32_t* row);
+
+    private:
+        int                srcWidth_, srcHeight_;
+        std::uint32_t*     dst_;
+        int                dstWidth_, dstHeight_, dstStride_;
+        int                y_ = 0;             // Next source row
+        std::vector<int>   firstOut_;          // Per source column: first output it touches
+        std::vector<float> firstWeight_;       // ... and its share there (the rest goes to the next)
+        std::vector<float> line_;              // Current source row reduced horizontally
+        std::vector<float> acc_[2];            // Output rows in progress, by parity
+    };
+
+    // Draws `count` on a red badge in the bottom-right corner of a size x size
+    // icon, for a tray icon standing for several windows. Digits come from a
+    // built-in 3x5 dot font scaled with the icon, so they stay legible at
+    // 16 px; counts above 99 read "99+". Icons under 16 px are left alone.
+    void DrawCountBadge(std::uint32_t* pixels, int size, int stride, int count);
+
+} // namespace IconKernels
+
+#endif // ICONKERNELS_H
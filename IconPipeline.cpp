@@ -0,0 +1,594 @@
+#include "IconPipeline.h"
+#include "Resource.h"
+#include "Diagnostics.h"
+#include "WindowMessaging.h"
+#include "UwpIconUtils.h"
+#include "IconKernels.h"
+#include "MappedFile.h"
+#include "PeIcons.h"
+#include "PngDecoder.h"
+#include "IconCache.h"
+#include "HandleAudit.h"
+#include <shellapi.h>
+#include <shlobj.h>
+#include <gdiplus.h>
+#include <vector>
+#include <algorithm>
+#include <system_error>
+
+#pragma comment(lib, "gdiplus.lib")
+
+using namespace Gdiplus;
+
+// Per-channel distance still counted as background, so compression noise and
+// dithering in a solid backdrop go with it
+static const std::uint8_t kBackgroundTolerance = 24;
+
+// Icons are processed on the worker thread too, so the one-time startup must be race free
+static bool EnsureGdiPlus() {
+    static const bool inited = [] {
+        ULONG_PTR token = 0;
+        GdiplusStartupInput si;
+        return GdiplusStartup(&token, &si, nullptr) == Ok;
+    }();
+    return inited;
+}
+
+// Builds an alpha icon from straight ARGB pixels, rows top-down and `width` apart
+static HICON IconFromArgb(const std::uint32_t* pixels, int width, int height) {
+    BITMAPINFO bi{};
+    bi.bmiHeader.biSize = sizeof(bi.bmiHeader);
+    bi.bmiHeader.biWidth = width;
+    bi.bmiHeader.biHeight = -height; // Top-down
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HBITMAP hbmColor = WTT_TRACK(CreateDIBSection(nullptr, &bi, DIB_RGB_COLORS, &bits, nullptr, 0), "HBITMAP");
+    if (!hbmColor) return nullptr;
+    memcpy(bits, pixels, static_cast<size_t>(width) * height * sizeof(std::uint32_t));
+
+    // Alpha carries the shape, so the AND mask is all zeros (WORD-aligned rows)
+    std::vector<BYTE> maskBits(static_cast<size_t>((width + 15) / 16) * 2 * height, 0);
+    ICONINFO ii{};
+    ii.fIcon = TRUE;
+    ii.hbmColor = hbmColor;
+    ii.hbmMask = WTT_TRACK(CreateBitmap(width, height, 1, 1, maskBits.data()), "HBITMAP");
+    HICON hIcon = ii.hbmMask ? WTT_TRACK(CreateIconIndirect(&ii), "HICON") : nullptr;
+    DeleteObject(WTT_UNTRACK(ii.hbmColor));
+    if (ii.hbmMask) DeleteObject(WTT_UNTRACK(ii.hbmMask));
+    return hIcon;
+}
+
+// PNGs stream from the file mapping straight into an area scaler, so a large
+// logo never exists decoded in full. Smaller sources are decoded whole (they
+// are tiny) and enlarged with Lanczos.
+static bool DecodePngScaled(const std::wstring& path, int size, std::vector<std::uint32_t>& scaled) {
+    MappedFile file;
+    PngDecoder::Header header;
+    if (!file.Open(path) || !PngDecoder::ReadHeader(file.data(), file.size(), header) || header.interlaced)
+        return false;
+
+    if (header.width >= size && header.height >= size) {
+        IconKernels::AreaScaler scaler(header.width, header.height, scaled.data(), size, size, size);
+        return PngDecoder::Decode(file.data(), file.size(),
+            [&](int, const std::uint32_t* row) { scaler.PushRow(row); });
+    }
+
+    std::vector<std::uint32_t> full(static_cast<size_t>(header.width) * header.height);
+    if (!PngDecoder::Decode(file.data(), file.size(), [&](int y, const std::uint32_t* row) {
+            std::copy(row, row + header.width, full.data() + static_cast<size_t>(y) * header.width);
+        }))
+        return false;
+    IconKernels::Resample(full.data(), header.width, header.height, header.width,
+        scaled.data(), size, size, size, IconKernels::Filter::Lanczos3);
+    return true;
+}
+
+static HICON LoadPngAsIcon(const std::wstring& path, int size) {
+    if (size <= 0) return nullptr;
+    {
+        std::vector<std::uint32_t> scaled(static_cast<size_t>(size) * size);
+        if (DecodePngScaled(path, size, scaled)) return IconFromArgb(scaled.data(), size, size);
+    }
+
+    // Other formats and interlaced PNGs go through GDI+
+    if (!EnsureGdiPlus()) return nullptr;
+    Bitmap src(path.c_str());
+    if (src.GetLastStatus() != Ok) return nullptr;
+
+    Rect rect(0, 0, src.GetWidth(), src.GetHeight());
+    BitmapData data;
+    if (rect.Width <= 0 || rect.Height <= 0 ||
+        src.LockBits(&rect, ImageLockModeRead, PixelFormat32bppARGB, &data) != Ok) return nullptr;
+
+    // Whole-number reductions (e.g. a 64 px logo to 32 px) are a plain average
+    // of each block; anything else takes Lanczos
+    const bool evenReduction = rect.Width % size == 0 && rect.Height % size == 0;
+    std::vector<std::uint32_t> scaled(static_cast<size_t>(size) * size);
+    IconKernels::Resample(static_cast<const std::uint32_t*>(data.Scan0), rect.Width, rect.Height,
+        data.Stride / 4, scaled.data(), size, size, size,
+        evenReduction ? IconKernels::Filter::Box : IconKernels::Filter::Lanczos3);
+    src.UnlockBits(&data);
+
+    return IconFromArgb(scaled.data(), size, size);
+}
+
+// Reads the image of an exe's icon group closest to `size` px straight from
+// its resources; handles both DIB and PNG entries
+static HICON LoadExeIcon(const std::wstring& path, int index, int size) {
+    MappedFile file;
+    if (!file.Open(path)) return nullptr;
+
+    PeIcons::IconImage image;
+    if (!PeIcons::FindIcon(file.data(), file.size(), index, size, image)) return nullptr;
+
+    return WTT_TRACK(::CreateIconFromResourceEx(const_cast<BYTE*>(image.data), static_cast<DWORD>(image.size),
+        TRUE, 0x00030000, size, size, LR_DEFAULTCOLOR), "HICON");
+}
+
+// Reads an icon's color bitmap and AND mask into ARGB, whatever their depth.
+// Monochrome icons have no color bitmap; their mask holds the AND rows followed by the XOR rows.
+static bool ReadIconPixels(const ICONINFO& info, int& width, int& height, std::vector<std::uint32_t>& pixels)
+{
+    BITMAP bm{};
+    HBITMAP source = info.hbmColor ? info.hbmColor : info.hbmMask;
+    if (!source || !info.hbmMask || ::GetObject(source, sizeof(bm), &bm) == 0) return false;
+    width = bm.bmWidth;
+    height = info.hbmColor ? bm.bmHeight : bm.bmHeight / 2;
+    if (width <= 0 || height <= 0) return false;
+
+    struct DibInfo {
+        BITMAPINFOHEADER header;
+        RGBQUAD          colors[256];
+    };
+
+    HDC dc = ::GetDC(nullptr);
+    if (!dc) return false;
+
+    // Top-down rows in the requested depth; the palette lands in di.colors
+    auto readBits = [&](HBITMAP hbm, int bpp, int rows, std::vector<BYTE>& bits, DibInfo& di) {
+        di = {};
+        di.header.biSize = sizeof(di.header);
+        di.header.biWidth = width;
+        di.header.biHeight = -rows;
+        di.header.biPlanes = 1;
+        di.header.biBitCount = (WORD)bpp;
+        di.header.biCompression = BI_RGB;
+        bits.resize(static_cast<size_t>((width * bpp + 31) / 32) * 4 * rows);
+        return ::GetDIBits(dc, hbm, 0, rows, bits.data(), (BITMAPINFO*)&di, DIB_RGB_COLORS) == rows;
+    };
+
+    const int maskStride = ((width + 31) / 32) * 4;
+    std::vector<BYTE> maskBits, colorBits;
+    DibInfo maskInfo, colorInfo;
+    IconKernels::SourceBitmap color;
+    bool ok = readBits(info.hbmMask, 1, info.hbmColor ? height : height * 2, maskBits, maskInfo);
+
+    if (ok && info.hbmColor) {
+        // Depths the converter doesn't take (16 bpp, device bitmaps) are widened by GDI
+        int bpp = bm.bmBitsPixel;
+        if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 24 && bpp != 32) bpp = 24;
+        ok = readBits(info.hbmColor, bpp, height, colorBits, colorInfo);
+        color.bits = colorBits.data();
+        color.bitsPerPixel = bpp;
+        color.stride = static_cast<int>(colorBits.size() / height);
+        color.palette = reinterpret_cast<const std::uint32_t*>(colorInfo.colors);
+        color.paletteSize = bpp <= 8 ? 1 << bpp : 0;
+    }
+    else if (ok) {
+        color.bits = maskBits.data() + static_cast<size_t>(maskStride) * height;
+        color.bitsPerPixel = 1;
+        color.stride = maskStride;
+        color.palette = reinterpret_cast<const std::uint32_t*>(maskInfo.colors);
+        color.paletteSize = 2;
+    }
+    ::ReleaseDC(nullptr, dc);
+    if (!ok) return false;
+
+    pixels.assign(static_cast<size_t>(width) * height, 0);
+    return IconKernels::ConvertToArgb(color, maskBits.data(), maskStride, width, height, pixels.data(), width);
+}
+
+// Clears the flat background around an icon's content and enlarges the content
+// to fill the icon. An icon that would come out empty is left as it was.
+static void RemoveBackgroundAndScale(std::vector<std::uint32_t>& pixels, int width, int height)
+{
+    // Corner flood fill, edge cleanup, content box and scale decision run on the raw pixels
+    thread_local std::vector<IconKernels::FillSeed> fillStack;
+    thread_local std::vector<std::uint8_t> clearedMask;
+    std::vector<std::uint32_t> work(pixels);
+    const std::uint32_t background = work[0];
+    if (IconKernels::FloodFillCorners(work.data(), width, height, width,
+            fillStack, kBackgroundTolerance, &clearedMask)) {
+        IconKernels::DecontaminateEdges(work.data(), width, height, width,
+            background, clearedMask);
+    }
+
+    const IconKernels::Bounds bounds =
+        IconKernels::AlphaBounds(work.data(), width, height, width);
+    if (bounds.empty()) return;
+
+    int contentWidth = bounds.width();
+    int contentHeight = bounds.height();
+    const double scale = IconKernels::ChooseScale(bounds, width, height);
+
+    if (scale > 1.01) {
+        // Enlarge the content box into a cleared icon-sized buffer, centered
+        int newContentWidth = std::min((int)(contentWidth * scale), width);
+        int newContentHeight = std::min((int)(contentHeight * scale), height);
+        int offsetX = (width - newContentWidth) / 2;
+        int offsetY = (height - newContentHeight) / 2;
+
+        std::fill(pixels.begin(), pixels.end(), 0u);
+        IconKernels::Resample(work.data() + bounds.top * width + bounds.left,
+            contentWidth, contentHeight, width,
+            pixels.data() + offsetY * width + offsetX, newContentWidth, newContentHeight,
+            width, IconKernels::Filter::Lanczos3);
+        return;
+    }
+    pixels.swap(work);
+}
+
+// ReadIconPixels on an icon handle
+static bool ReadIcon(HICON hIcon, int& width, int& height, std::vector<std::uint32_t>& pixels)
+{
+    ICONINFO info{};
+    if (!hIcon || !::GetIconInfo(hIcon, &info)) return false;
+    WTT_TRACKED(info.hbmColor, "HBITMAP");
+    WTT_TRACKED(info.hbmMask, "HBITMAP");
+
+    const bool read = ReadIconPixels(info, width, height, pixels);
+    if (info.hbmColor) ::DeleteObject(WTT_UNTRACK(info.hbmColor));
+    if (info.hbmMask) ::DeleteObject(WTT_UNTRACK(info.hbmMask));
+    return read;
+}
+
+// FNV-1a over an icon's source pixels (and size), before any processing
+static std::uint64_t HashPixels(const std::vector<std::uint32_t>& pixels, int width, int height)
+{
+    std::uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](std::uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            h ^= (v >> (i * 8)) & 0xFF;
+            h *= 1099511628211ull;
+        }
+    };
+    mix(static_cast<std::uint32_t>(width));
+    mix(static_cast<std::uint32_t>(height));
+    for (std::uint32_t px : pixels) mix(px);
+    return h;
+}
+
+// Removes the background of an icon's pixels (from ReadIcon; they are
+// consumed) and renders it at every size in kIconSizes, concatenated smallest
+// first. Whole-number reductions are a plain block average, anything else
+// takes Lanczos.
+static void RenderSizes(std::vector<std::uint32_t>& pixels, int width, int height, std::vector<std::uint32_t>& out)
+{
+    RemoveBackgroundAndScale(pixels, width, height);
+
+    out.assign(IconCache::PixelCount(), 0);
+    std::uint32_t* dst = out.data();
+    for (int size : IconPipeline::kIconSizes) {
+        if (size == width && size == height) {
+            std::copy(pixels.begin(), pixels.end(), dst);
+        }
+        else {
+            const bool evenReduction = width % size == 0 && height % size == 0;
+            IconKernels::Resample(pixels.data(), width, height, width, dst, size, size, size,
+                evenReduction ? IconKernels::Filter::Box : IconKernels::Filter::Lanczos3);
+        }
+        dst += static_cast<size_t>(size) * size;
+    }
+}
+
+// Icons for the renditions laid out by RenderSizes
+static bool ImageSetFromPixels(const std::vector<std::uint32_t>& pixels, IconStore::ImageSet& images)
+{
+    images.clear();
+    if (pixels.size() != IconCache::PixelCount()) return false;
+
+    const std::uint32_t* src = pixels.data();
+    for (int size : IconPipeline::kIconSizes) {
+        HICON icon = IconFromArgb(src, size, size);
+        if (!icon) {
+            IconStore::Destroy(images);
+            return false;
+        }
+        images.push_back(IconStore::Image{ size, icon });
+        src += static_cast<size_t>(size) * size;
+    }
+    return true;
+}
+
+HICON RemoveIconBackground_FloodFillAndScale(HICON hIcon, bool& outOwnsNewIcon)
+{
+    outOwnsNewIcon = false;
+    if (!hIcon) return nullptr;
+
+    ICONINFO info{};
+    if (!::GetIconInfo(hIcon, &info)) return nullptr;
+    WTT_TRACKED(info.hbmColor, "HBITMAP");
+    WTT_TRACKED(info.hbmMask, "HBITMAP");
+
+    int width = 0, height = 0;
+    std::vector<std::uint32_t> pixels;
+    const bool read = ReadIconPixels(info, width, height, pixels);
+    if (info.hbmColor) ::DeleteObject(WTT_UNTRACK(info.hbmColor));
+    if (info.hbmMask) ::DeleteObject(WTT_UNTRACK(info.hbmMask));
+    if (!read) return nullptr;
+
+    RemoveBackgroundAndScale(pixels, width, height);
+    HICON hNewIcon = IconFromArgb(pixels.data(), width, height);
+    outOwnsNewIcon = hNewIcon != nullptr; // A new icon that we must manage
+    return hNewIcon;
+}
+
+HICON IconPipeline::BadgedIcon(HICON icon, int size, int count)
+{
+    ICONINFO info{};
+    if (!icon || size <= 0 || !::GetIconInfo(icon, &info)) return nullptr;
+    WTT_TRACKED(info.hbmColor, "HBITMAP");
+    WTT_TRACKED(info.hbmMask, "HBITMAP");
+
+    int width = 0, height = 0;
+    std::vector<std::uint32_t> pixels;
+    const bool read = ReadIconPixels(info, width, height, pixels);
+    if (info.hbmColor) ::DeleteObject(WTT_UNTRACK(info.hbmColor));
+    if (info.hbmMask) ::DeleteObject(WTT_UNTRACK(info.hbmMask));
+    if (!read) return nullptr;
+
+    std::vector<std::uint32_t> out(static_cast<size_t>(size) * size);
+    if (width == size && height == size) {
+        out.swap(pixels);
+    }
+    else {
+        IconKernels::Resample(pixels.data(), width, height, width, out.data(), size, size, size,
+            IconKernels::Filter::Lanczos3);
+    }
+    IconKernels::DrawCountBadge(out.data(), size, size, count);
+    return IconFromArgb(out.data(), size, size);
+}
+
+IconPipeline::Result IconPipeline::Resolve(const WindowCapture& capture, const IconStore& store,
+    IconCache* cache, const std::atomic<bool>& cancelled)
+{
+    HWND hwnd = capture.hwnd;
+    HICON originalIcon = nullptr;
+    bool originalOwns = false;
+    Result result;
+
+    // Processed pixels from an earlier run, valid while the source file is unchanged
+    IconCache::Stamp stamp;
+    auto cached = [&](const std::wstring& key, const std::wstring& file) {
+        std::vector<std::uint32_t> pixels;
+        if (!cache || !IconCache::StampFile(file, stamp) ||
+            !cache->Find(key + L"|" + file, stamp, pixels) || !ImageSetFromPixels(pixels, result.images))
+            return false;
+        result.key = key;
+        result.owns = true;
+        return true;
+        };
+
+    // --- Helper lambdas to process and clean up icons ---
+    // `file` is the source file behind the icon, if any; the result is cached
+    // under it. `read` tells whether `source` holds the icon's pixels (ReadIcon)
+    auto processPixels = [&](HICON hIn, bool inOwns, const std::wstring& key, const std::wstring& file,
+        bool read, std::vector<std::uint32_t>& source, int width, int height) -> Result& {
+        result.key = key;
+        std::vector<std::uint32_t> pixels;
+        if (read) RenderSizes(source, width, height, pixels);
+        if (read && ImageSetFromPixels(pixels, result.images)) {
+            if (cache && !file.empty() && IconCache::StampFile(file, stamp)) {
+                cache->Put(key + L"|" + file, stamp, pixels);
+            }
+            if (inOwns) {
+                ::DestroyIcon(WTT_UNTRACK(hIn)); // Destroy original if we owned it
+            }
+            result.owns = true;
+            return result;
+        }
+
+        // Processing failed, keep the original
+        result.images.assign(1, IconStore::Image{ 0, hIn });
+        result.owns = inOwns;
+        return result;
+        };
+    auto processIcon = [&](HICON hIn, bool inOwns, const std::wstring& key,
+        const std::wstring& file = std::wstring()) -> Result& {
+        int width = 0, height = 0;
+        std::vector<std::uint32_t> source;
+        const bool read = ReadIcon(hIn, width, height, source);
+        return processPixels(hIn, inOwns, key, file, read, source, width, height);
+        };
+
+    // Another window of the same app already produced this icon
+    auto shared = [&](const std::wstring& key) {
+        if (!store.Contains(key)) return false;
+        result.key = key;
+        return true;
+        };
+
+    // 1. UWP icon retrieval (AUMID resolved during capture)
+    const int sz = kSourceSize;
+    if (!capture.icon.aumid.empty())
+    {
+        const std::wstring key = IconStore::KeyForAumid(capture.icon.aumid, sz);
+        if (shared(key)) return result;
+
+        // Package manifest first; the shell lookup below is slower and may need COM
+        std::wstring logoPath;
+        if (UwpIconUtils::GetLogoPathForAumid(capture.icon.aumid, sz, logoPath))
+        {
+            if (cached(key, logoPath)) return result;
+            if ((originalIcon = LoadPngAsIcon(logoPath, sz)) != nullptr)
+                return processIcon(originalIcon, true, key, logoPath);
+        }
+        if (UwpIconUtils::GetIconForAumid(capture.icon.aumid, sz, originalIcon, originalOwns) && originalIcon)
+        {
+            return processIcon(originalIcon, originalOwns, key);
+        }
+    }
+    if (cancelled) return result;
+
+    // 2. Traditional Win32 icon retrieval (WM_GETICON with a deadline, then class
+    // icons); the big icon is the better source for the larger sizes
+    originalIcon = WindowMessaging::GetIcon(hwnd, true);
+    if (originalIcon)
+    {
+        // We don't own icons from SendMessage/GetClassLongPtr. Handles are
+        // per run and may be reused, so the key is the exe plus a hash of the
+        // source pixels: windows with an icon of their own (documents,
+        // profiles) keep it, and the processed result is cached against the
+        // exe's stamp like step 4
+        int width = 0, height = 0;
+        std::vector<std::uint32_t> source;
+        const bool read = ReadIcon(originalIcon, width, height, source);
+        const std::wstring key = read ? IconStore::KeyForWindowIcon(capture.icon.exePath,
+            HashPixels(source, width, height)) : std::wstring();
+        if (read && (shared(key) || cached(key, capture.icon.exePath))) return result;
+        return processPixels(originalIcon, false, key, capture.icon.exePath, read, source, width, height);
+    }
+    if (cancelled) return result;
+
+    // 3. Shell properties (modern apps), resolved during capture
+    if (!capture.icon.relaunchIcon.empty())
+    {
+        const int iconSize = kSourceSize;
+        const std::wstring key = IconStore::KeyForFile(capture.icon.relaunchIcon, iconSize);
+        if (shared(key) || cached(key, capture.icon.relaunchIcon)) return result;
+        originalIcon = LoadPngAsIcon(capture.icon.relaunchIcon, iconSize);
+        if (originalIcon) {
+            // LoadPngAsIcon creates an icon we must destroy.
+            return processIcon(originalIcon, true, key, capture.icon.relaunchIcon);
+        }
+    }
+    if (cancelled) return result;
+
+    // 4. Fallback: extract from the host executable
+    if (!capture.icon.exePath.empty())
+    {
+        const std::wstring key = IconStore::KeyForExe(capture.icon.exePath, 0);
+        if (shared(key) || cached(key, capture.icon.exePath)) return result;
+
+        // Mapped resource read first: the group's image nearest the largest size we render
+        originalIcon = LoadExeIcon(capture.icon.exePath, 0, kSourceSize);
+        if (originalIcon) {
+            return processIcon(originalIcon, true, key, capture.icon.exePath);
+        }
+
+        Diagnostics::CountCall(L"ExtractIconExW");
+        UINT extracted = ::ExtractIconExW(capture.icon.exePath.c_str(), 0, &originalIcon, nullptr, 1);
+        if (extracted > 0 && originalIcon && originalIcon != (HICON)1)
+        {
+            WTT_TRACKED(originalIcon, "HICON");
+            // ExtractIconExW gives us an icon we must destroy.
+            return processIcon(originalIcon, true, key, capture.icon.exePath);
+        }
+        originalIcon = nullptr;
+    }
+
+    // 5. Absolute fallback: generic application icon
+    const std::wstring stockKey = L"stock:application";
+    if (shared(stockKey)) return result;
+    SHSTOCKICONINFO sii{ sizeof(sii) };
+    if (SUCCEEDED(::SHGetStockIconInfo(SIID_APPLICATION, SHGSI_ICON | SHGSI_LARGEICON, &sii)))
+    {
+        // sii.hIcon is a copy that we must destroy.
+        WTT_TRACKED(sii.hIcon, "HICON");
+        return processIcon(sii.hIcon, true, stockKey);
+    }
+
+    // 6. Last resort: load from our own resources. Without LR_SHARED this is a
+    // copy, so the store destroys it like any other owned icon
+    result.key = L"resource:tray";
+    HICON own = (HICON)WTT_TRACK(::LoadImageW(
+        GetModuleHandleW(nullptr),
+        MAKEINTRESOURCE(IDI_TRAY_ICON),
+        IMAGE_ICON,
+        ::GetSystemMetrics(SM_CXSMICON),
+        ::GetSystemMetrics(SM_CYSMICON),
+        LR_DEFAULTCOLOR), "HICON");
+    if (own) result.images.assign(1, IconStore::Image{ 0, own });
+    result.owns = own != nullptr;
+    return result;
+}
+
+IconPipeline::Worker::Worker(HWND notifyWindow, UINT notifyMessage, const IconStore& store, IconCache* cache)
+    : notifyWindow_(notifyWindow), notifyMessage_(notifyMessage), store_(store), cache_(cache)
+{
+    try {
+        thread_ = std::thread(&Worker::Run, this);
+        running_ = true;
+    }
+    catch (const std::system_error&) {
+        running_ = false; // Icons get resolved on the caller's thread
+    }
+}
+
+IconPipeline::Worker::~Worker()
+{
+    Stop();
+}
+
+void IconPipeline::Worker::Stop()
+{
+    if (!running_) return;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stopping_ = true;
+        jobs_.clear();
+    }
+    wake_.notify_one();
+    thread_.join();
+    running_ = false;
+}
+
+bool IconPipeline::Worker::Submit(UINT entryId, const WindowCapture& capture, CancelToken cancelled)
+{
+    if (!running_) return false;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        jobs_.push_back(Job{ entryId, capture, std::move(cancelled) });
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void IconPipeline::Worker::Discard(LPARAM lParam)
+{
+    std::unique_ptr<Result> result(reinterpret_cast<Result*>(lParam));
+    if (result && result->owns) IconStore::Destroy(result->images);
+}
+
+void IconPipeline::Worker::Run()
+{
+    // Shell icon APIs want an STA
+    HRESULT hrInit = ::CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            wake_.wait(guard, [this] { return stopping_ || !jobs_.empty(); });
+            if (stopping_) break;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        if (*job.cancelled) continue; // Restored before we got to it
+
+        auto result = std::make_unique<Result>(Resolve(job.capture, store_, cache_, *job.cancelled));
+        result->entryId = job.entryId;
+
+        if (*job.cancelled || !::PostMessageW(notifyWindow_, notifyMessage_, 0,
+            reinterpret_cast<LPARAM>(result.get()))) {
+            Discard(reinterpret_cast<LPARAM>(result.release()));
+            continue;
+        }
+        result.release(); // Owned by the receiver now
+    }
+
+    if (SUCCEEDED(hrInit)) ::CoUninitialize();
+}
@@ -0,0 +1,103 @@
+#pragma once
+#ifndef ICONPIPELINE_H
+#define ICONPIPELINE_H
+
+// Avoid min/max macro conflicts from <windows.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "WindowCapture.h"
+#include "IconStore.h"
+
+class IconCache;
+
+// Removes a flat background from an icon and scales its content up to fill it.
+HICON RemoveIconBackground_FloodFillAndScale(HICON hIcon, bool& outOwnsNewIcon);
+
+namespace IconPipeline {
+
+    using CancelToken = std::shared_ptr<std::atomic<bool>>;
+
+    // Sizes every resolved icon is rendered at. Tray icons, the collection list
+    // and DPI changes pick the nearest one instead of extracting again.
+    constexpr int kIconSizes[] = { 16, 20, 24, 32, 40, 48 };
+
+    // Size requested from sources that offer several: the largest rendition.
+    constexpr int kSourceSize = 48;
+
+    // Outcome of the icon cascade for one tray entry.
+    struct Result {
+        UINT                entryId{ 0 };
+        std::wstring        key;       // Source key of the step that produced the icon
+        IconStore::ImageSet images;    // Empty: the store already holds an icon for `key`
+        bool                owns{ false };
+    };
+
+    // Runs the icon cascade (AUMID, WM_GETICON, relaunch icon, exe, stock icon)
+    // and renders the chosen icon at every size in kIconSizes from one read of
+    // its pixels. A step whose key is already in the store ends the walk
+    // without extracting or processing anything. File-backed steps (package
+    // logo, relaunch icon, exe) are looked up in `cache` first and stored there
+    // after processing; `cache` may be null. Safe to call from any thread.
+    [[nodiscard]] Result Resolve(const WindowCapture& capture, const IconStore& store,
+        IconCache* cache, const std::atomic<bool>& cancelled);
+
+    // A copy of `icon` at `size` px with `count` drawn on a badge in its
+    // corner (IconKernels::DrawCountBadge). The caller owns the result.
+    [[nodiscard]] HICON BadgedIcon(HICON icon, int size, int count);
+
+    // Background thread running Resolve. Each result is posted to the notify
+    // window as `notifyMessage` with a heap-allocated Result* in lParam, which
+    // the receiver owns.
+    class Worker {
+    public:
+        Worker(HWND notifyWindow, UINT notifyMessage, const IconStore& store, IconCache* cache);
+        ~Worker();
+
+        Worker(const Worker&) = delete;
+        Worker& operator=(const Worker&) = delete;
+
+        // Queues a window; false if the thread is not running (resolve inline then).
+        [[nodiscard]] bool Submit(UINT entryId, const WindowCapture& capture, CancelToken cancelled);
+
+        // Drops the queued jobs and joins the thread; nothing is posted once
+        // it returns. Results already posted are left in the message queue.
+        void Stop();
+
+        // Frees a posted result that nobody is going to apply.
+        static void Discard(LPARAM lParam);
+
+    private:
+        struct Job {
+            UINT          entryId;
+            WindowCapture capture;
+            CancelToken   cancelled;
+        };
+
+        void Run();
+
+        HWND                    notifyWindow_;
+        UINT                    notifyMessage_;
+        const IconStore&        store_;
+        IconCache*              cache_;
+
+        std::mutex              lock_;
+        std::condition_variable wake_;
+        std::deque<Job>         jobs_;
+        bool                    stopping_ = false;
+        bool                    running_ = false;
+        std::thread             thread_;
+    };
+
+} // namespace IconPipeline
+
+#endif // ICONPIPELINE_H
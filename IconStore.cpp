@@ -0,0 +1,261 @@
+#include "IconStore.h"
+#include "HandleAudit.h"
+#include <cwctype>
+#include <cstdio>
+
+IconStore::~IconStore()
+{
+    Clear();
+}
+
+bool IconStore::Contains(const std::wstring& key) const
+{
+    std::lock_guard<std::mutex> guard(keysLock_);
+    return byKey_.count(key) != 0;
+}
+
+IconStore::Slot IconStore::Acquire(const std::wstring& key)
+{
+    if (key.empty()) return kNone;
+    auto it = byKey_.find(key);
+    if (it == byKey_.end()) return kNone;
+
+    entries_[it->second - 1].refs++;
+    return it->second;
+}
+
+// FNV-1a over the icon's 32bpp pixels (and size). Empty key if unreadable.
+static std::wstring ContentKey(HICON icon, size_t& bytes)
+{
+    bytes = 0;
+    ICONINFO info{};
+    if (!::GetIconInfo(icon, &info)) return std::wstring();
+    WTT_TRACKED(info.hbmColor, "HBITMAP");
+    WTT_TRACKED(info.hbmMask, "HBITMAP");
+
+    std::wstring key;
+    HBITMAP hbm = info.hbmColor ? info.hbmColor : info.hbmMask;
+    BITMAP bm{};
+    if (hbm && ::GetObjectW(hbm, sizeof(bm), &bm) && bm.bmWidth > 0 && bm.bmHeight > 0)
+    {
+        BITMAPINFO bi{};
+        bi.bmiHeader.biSize = sizeof(bi.bmiHeader);
+        bi.bmiHeader.biWidth = bm.bmWidth;
+        bi.bmiHeader.biHeight = -bm.bmHeight;
+        bi.bmiHeader.biPlanes = 1;
+        bi.bmiHeader.biBitCount = 32;
+        bi.bmiHeader.biCompression = BI_RGB;
+
+        std::vector<std::uint32_t> pixels(static_cast<size_t>(bm.bmWidth) * bm.bmHeight);
+        HDC dc = ::GetDC(nullptr);
+        const int rows = ::GetDIBits(dc, hbm, 0, bm.bmHeight, pixels.data(), &bi, DIB_RGB_COLORS);
+        ::ReleaseDC(nullptr, dc);
+
+        if (rows == bm.bmHeight)
+        {
+            std::uint64_t h = 1469598103934665603ull;
+            auto mix = [&h](std::uint32_t v) {
+                for (int i = 0; i < 4; ++i) {
+                    h ^= (v >> (i * 8)) & 0xFF;
+                    h *= 1099511628211ull;
+                }
+            };
+            mix(static_cast<std::uint32_t>(bm.bmWidth));
+            mix(static_cast<std::uint32_t>(bm.bmHeight));
+            mix(info.hbmColor ? 1u : 0u);
+            for (std::uint32_t px : pixels) mix(px);
+
+            wchar_t buf[40];
+            swprintf_s(buf, L"px:%016llx", static_cast<unsigned long long>(h));
+            key = buf;
+            // Color bitmap plus the 1bpp AND mask
+            bytes = pixels.size() * 4 + static_cast<size_t>(bm.bmWidth) * bm.bmHeight / 8;
+        }
+    }
+
+    if (info.hbmColor) ::DeleteObject(WTT_UNTRACK(info.hbmColor));
+    if (info.hbmMask) ::DeleteObject(WTT_UNTRACK(info.hbmMask));
+    return key;
+}
+
+IconStore::Slot IconStore::Add(ImageSet images, bool owns, const std::wstring& key)
+{
+    if (images.empty() || !images.back().icon) return kNone;
+
+    // The largest rendition identifies the content; the others only count toward memory
+    size_t bytes = 0;
+    const std::wstring content = ContentKey(images.back().icon, bytes);
+    for (size_t i = 0; i + 1 < images.size(); ++i) {
+        const size_t px = static_cast<size_t>(images[i].size) * images[i].size;
+        bytes += px * 4 + px / 8;
+    }
+
+    auto same = content.empty() ? byKey_.end() : byKey_.find(content);
+    if (same != byKey_.end())
+    {
+        // Pixel-identical to a stored icon: share it, remember the source as an alias
+        Entry& e = entries_[same->second - 1];
+        if (owns && images.back().icon != e.images.back().icon) {
+            // Prefer holding icons we own over borrowing one from a window,
+            // and more sizes over fewer
+            if (!e.owns || images.size() > e.images.size()) {
+                if (e.owns) Destroy(e.images);
+                e.images = std::move(images);
+                e.owns = true;
+                e.bytes = bytes;
+            }
+            else Destroy(images);
+        }
+        e.refs++;
+        std::lock_guard<std::mutex> guard(keysLock_);
+        if (!key.empty() && byKey_.emplace(key, same->second).second)
+            e.keys.push_back(key);
+        contentHits_++;
+        return same->second;
+    }
+
+    const Slot slot = NewSlot();
+    Entry& e = entries_[slot - 1];
+    e = Entry{ std::move(images), owns, 1, bytes, {} };
+    std::lock_guard<std::mutex> guard(keysLock_);
+    for (const std::wstring* k : { &key, &content }) {
+        if (!k->empty() && byKey_.emplace(*k, slot).second)
+            e.keys.push_back(*k);
+    }
+    return slot;
+}
+
+IconStore::Slot IconStore::AddBorrowed(HICON icon, const std::wstring& key)
+{
+    if (!icon) return kNone;
+    if (Slot shared = Acquire(key)) return shared;
+
+    const Slot slot = NewSlot();
+    Entry& e = entries_[slot - 1];
+    e = Entry{ ImageSet{ Image{ 0, icon } }, false, 1, 0, {} };
+    std::lock_guard<std::mutex> guard(keysLock_);
+    if (!key.empty() && byKey_.emplace(key, slot).second)
+        e.keys.push_back(key);
+    return slot;
+}
+
+IconStore::Slot IconStore::NewSlot()
+{
+    if (!freeSlots_.empty()) {
+        const Slot slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        return slot;
+    }
+    entries_.emplace_back();
+    return static_cast<Slot>(entries_.size());
+}
+
+HICON IconStore::Get(Slot slot, int size) const
+{
+    if (slot == kNone || slot > entries_.size()) return nullptr;
+    const Entry& e = entries_[slot - 1];
+    const ImageSet& images = e.images;
+    if (images.empty()) return nullptr;
+    e.lastShown = ++shownClock_;
+    for (const Image& image : images) {
+        if (image.size >= size) return image.icon;
+    }
+    return images.back().icon;
+}
+
+std::uint64_t IconStore::LastShown(Slot slot) const
+{
+    if (slot == kNone || slot > entries_.size()) return 0;
+    return entries_[slot - 1].lastShown;
+}
+
+void IconStore::Destroy(ImageSet& images)
+{
+    for (const Image& image : images) {
+        if (image.icon) ::DestroyIcon(WTT_UNTRACK(image.icon));
+    }
+    images.clear();
+}
+
+void IconStore::Release(Slot slot)
+{
+    if (slot == kNone || slot > entries_.size()) return;
+
+    Entry& e = entries_[slot - 1];
+    if (e.images.empty() || --e.refs > 0) return;
+
+    if (e.owns) Destroy(e.images);
+    {
+        std::lock_guard<std::mutex> guard(keysLock_);
+        for (const auto& k : e.keys) byKey_.erase(k);
+    }
+    e = Entry{};
+    freeSlots_.push_back(slot);
+}
+
+void IconStore::Clear()
+{
+    for (Entry& e : entries_) {
+        if (e.owns) Destroy(e.images);
+    }
+    entries_.clear();
+    freeSlots_.clear();
+    std::lock_guard<std::mutex> guard(keysLock_);
+    byKey_.clear();
+}
+
+IconStore::Stats IconStore::GetStats() const
+{
+    Stats s;
+    for (const Entry& e : entries_) {
+        if (e.images.empty()) continue;
+        s.icons++;
+        s.handles += e.images.size();
+        if (e.owns) {
+            s.userObjects += e.images.size();
+            s.gdiObjects += e.images.size() * 2;
+        }
+        s.references += e.refs;
+        s.bytesHeld += e.bytes;
+        s.bytesSaved += (e.refs - 1) * e.bytes;
+    }
+    s.contentHits = contentHits_;
+    return s;
+}
+
+// Paths are compared case-insensitively, like the file system does
+static std::wstring Lower(const std::wstring& s)
+{
+    std::wstring out(s);
+    for (auto& c : out) c = static_cast<wchar_t>(std::towlower(c));
+    return out;
+}
+
+std::wstring IconStore::KeyForExe(const std::wstring& path, int index)
+{
+    return L"exe:" + Lower(path) + L"," + std::to_wstring(index);
+}
+
+std::wstring IconStore::KeyForAumid(const std::wstring& aumid, int size)
+{
+    return L"aumid:" + aumid + L"@" + std::to_wstring(size);
+}
+
+std::wstring IconStore::KeyForFile(const std::wstring& path, int size)
+{
+    return L"file:" + Lower(path) + L"@" + std::to_wstring(size);
+}
+
+std::wstring IconStore::KeyForWindowIcon(const std::wstring& exePath, std::uint64_t pixelHash)
+{
+    wchar_t buf[24];
+    swprintf_s(buf, L"#%016llx", static_cast<unsigned long long>(pixelHash));
+    return L"wicon:" + Lower(exePath) + buf;
+}
+
+std::wstring IconStore::KeyForHandle(HICON icon)
+{
+    wchar_t buf[32];
+    swprintf_s(buf, L"hicon:%p", static_cast<void*>(icon));
+    return buf;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef ICONSTORE_H
+#define ICONSTORE_H
+
+#include <windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+
+// Owns the processed icons shown for hidden windows. Tray entries refer to an
+// icon by a small slot number. A slot holds the icon at several pixel sizes
+// and callers ask for the size they draw at, so DPI changes never
+// re-extract. Icons added under a source key (exe path and index, AUMID and
+// size, exe path and window icon pixels) are shared: every user holds a
+// reference, and the icon is destroyed when the last one is released.
+//
+// Added icons are also hashed on their final ARGB pixels. An icon identical
+// to one already stored is dropped and its source key becomes an alias of the
+// existing slot, so different sources with the same image share one HICON.
+//
+// The store is owned by the UI thread; only Contains may be called from the
+// icon worker.
+class IconStore {
+public:
+    using Slot = std::uint32_t;
+    static constexpr Slot kNone = 0;
+
+    IconStore() = default;
+    ~IconStore();
+
+    IconStore(const IconStore&) = delete;
+    IconStore& operator=(const IconStore&) = delete;
+
+    // Whether an icon is stored under a key. Thread-safe.
+    [[nodiscard]] bool Contains(const std::wstring& key) const;
+
+    // One rendition of an icon
+    struct Image {
+        int   size{ 0 };          // Width in pixels; 0 if unknown
+        HICON icon{ nullptr };
+    };
+    // The renditions of one icon, ascending by size
+    using ImageSet = std::vector<Image>;
+
+    // Takes another reference on the icon stored under a key, or returns kNone.
+    [[nodiscard]] Slot Acquire(const std::wstring& key);
+
+    // Stores an icon set with one reference; when owned its icons are destroyed
+    // on the last Release. An empty key stores it unshared. Identical content
+    // is detected on the largest rendition. Returns kNone for an empty set.
+    [[nodiscard]] Slot Add(ImageSet images, bool owns, const std::wstring& key = std::wstring());
+
+    // Shares a borrowed icon of unknown size under `key`, e.g. a placeholder:
+    // another reference if the key is stored, else a new slot. Its pixels are
+    // not hashed, so it never merges with other icons. Returns kNone for null.
+    [[nodiscard]] Slot AddBorrowed(HICON icon, const std::wstring& key);
+
+    // Rendition of a slot's icon for drawing at `size` px: the smallest one at
+    // least that large, else the largest. nullptr for kNone / released slots.
+    // Marks the icon as displayed.
+    [[nodiscard]] HICON Get(Slot slot, int size) const;
+
+    // Display order of a slot's icon: higher was shown more recently, 0 never.
+    [[nodiscard]] std::uint64_t LastShown(Slot slot) const;
+
+    // Destroys every icon of a set.
+    static void Destroy(ImageSet& images);
+
+    void Release(Slot slot);
+    void Clear();
+
+    struct Stats {
+        size_t    icons = 0;          // Distinct icons held (each may have several sizes)
+        size_t    handles = 0;        // HICONs behind them
+        size_t    userObjects = 0;    // Owned HICONs, i.e. USER objects this process pays for
+        size_t    gdiObjects = 0;     // Their color and mask bitmaps (GDI objects)
+        size_t    references = 0;     // Slots handed out to tray entries
+        size_t    bytesHeld = 0;      // Pixel + mask bytes of the distinct icons, all sizes
+        size_t    bytesSaved = 0;     // Bytes the shared references would have cost
+        long long contentHits = 0;    // Adds resolved by pixel hash (cumulative)
+    };
+    [[nodiscard]] Stats GetStats() const;
+
+    // Source keys
+    static std::wstring KeyForExe(const std::wstring& path, int index);
+    static std::wstring KeyForAumid(const std::wstring& aumid, int size);
+    static std::wstring KeyForFile(const std::wstring& path, int size);
+    static std::wstring KeyForWindowIcon(const std::wstring& exePath, std::uint64_t pixelHash);
+    static std::wstring KeyForHandle(HICON icon);
+
+private:
+    Slot NewSlot();   // A free or appended slot; the caller fills its entry
+
+    struct Entry {
+        ImageSet                  images;
+        bool                      owns{ false };
+        unsigned                  refs{ 0 };
+        size_t                    bytes{ 0 };
+        std::vector<std::wstring> keys;      // Source keys and the content key
+        mutable std::uint64_t     lastShown{ 0 };
+    };
+
+    std::vector<Entry>                      entries_;   // Slot n lives at entries_[n - 1]
+    std::vector<Slot>                       freeSlots_;
+    std::unordered_map<std::wstring, Slot>  byKey_;      // Written under keysLock_
+    mutable std::mutex                      keysLock_;
+    long long                               contentHits_ = 0;
+    mutable std::uint64_t                   shownClock_ = 0;
+};
+
+#endif // ICONSTORE_H
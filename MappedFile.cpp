@@ -0,0 +1,44 @@
+#include "MappedFile.h"
+#include "Diagnostics.h"
+
+bool MappedFile::Open(const std::wstring& path)
+{
+    Close();
+
+    Diagnostics::CountCall(L"MapViewOfFile");
+    file_ = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size{};
+    if (!::GetFileSizeEx(file_, &size) || size.QuadPart <= 0 ||
+        static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX) {
+        Close();
+        return false;
+    }
+
+    mapping_ = ::CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+        Close();
+        return false;
+    }
+
+    view_ = static_cast<const std::uint8_t*>(::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!view_) {
+        Close();
+        return false;
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (view_) ::UnmapViewOfFile(view_);
+    if (mapping_) ::CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) ::CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+    view_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <windows.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file. Other processes may keep the file open
+// (running executables, package files), so it is opened with full sharing.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False if the file can't be opened or is empty.
+    [[nodiscard]] bool Open(const std::wstring& path);
+    void Close();
+
+    const std::uint8_t* data() const { return view_; }
+    std::size_t size() const { return size_; }
+
+private:
+    HANDLE              file_ = INVALID_HANDLE_VALUE;
+    HANDLE              mapping_ = nullptr;
+    const std::uint8_t* view_ = nullptr;
+    std::size_t         size_ = 0;
+};
+
+#endif // MAPPEDFILE_H
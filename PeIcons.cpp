@@ -0,0 +1,264 @@
+#include "PeIcons.h"
+#include <cstring>
+
+namespace {
+
+    const std::uint32_t kRtIcon = 3;
+    const std::uint32_t kRtGroupIcon = 14;
+
+    // Little-endian reads that fail instead of running off the buffer
+    class Reader {
+    public:
+        Reader(const std::uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+        bool Has(std::size_t offset, std::size_t n) const
+        {
+            return offset <= size_ && n <= size_ - offset;
+        }
+
+        bool U16(std::size_t offset, std::uint32_t& v) const
+        {
+            if (!Has(offset, 2)) return false;
+            v = data_[offset] | (std::uint32_t(data_[offset + 1]) << 8);
+            return true;
+        }
+
+        bool U32(std::size_t offset, std::uint32_t& v) const
+        {
+            if (!Has(offset, 4)) return false;
+            v = data_[offset] | (std::uint32_t(data_[offset + 1]) << 8) |
+                (std::uint32_t(data_[offset + 2]) << 16) | (std::uint32_t(data_[offset + 3]) << 24);
+            return true;
+        }
+
+        const std::uint8_t* At(std::size_t offset) const { return data_ + offset; }
+
+    private:
+        const std::uint8_t* data_;
+        std::size_t         size_;
+    };
+
+    struct Section {
+        std::uint32_t virtualAddress, virtualSize, rawOffset, rawSize;
+    };
+
+    // The parts of the image the resource walk needs
+    struct Image {
+        Reader        file;
+        std::size_t   sectionTable = 0;
+        std::uint32_t sectionCount = 0;
+        std::size_t   resourceBase = 0;  // File offset of the resource directory
+        std::size_t   resourceSize = 0;
+
+        explicit Image(const Reader& r) : file(r) {}
+
+        bool GetSection(std::uint32_t index, Section& s) const
+        {
+            const std::size_t at = sectionTable + std::size_t(index) * 40;
+            return file.U32(at + 8, s.virtualSize) && file.U32(at + 12, s.virtualAddress) &&
+                file.U32(at + 16, s.rawSize) && file.U32(at + 20, s.rawOffset);
+        }
+
+        // File offset of `n` bytes at an RVA, if they are all backed by the file
+        bool RvaToOffset(std::uint32_t rva, std::size_t n, std::size_t& offset) const
+        {
+            for (std::uint32_t i = 0; i < sectionCount; ++i) {
+                Section s;
+                if (!GetSection(i, s)) return false;
+                if (rva < s.virtualAddress) continue;
+                const std::size_t delta = rva - s.virtualAddress;
+                if (delta >= s.rawSize || n > s.rawSize - delta) continue;
+                offset = s.rawOffset + delta;
+                return file.Has(offset, n);
+            }
+            return false;
+        }
+    };
+
+    bool ParseHeaders(Image& img)
+    {
+        const Reader& f = img.file;
+        std::uint32_t magic, peOffset, signature;
+        if (!f.U16(0, magic) || magic != 0x5A4D) return false;                 // "MZ"
+        if (!f.U32(0x3C, peOffset)) return false;
+        if (!f.U32(peOffset, signature) || signature != 0x00004550) return false; // "PE\0\0"
+
+        const std::size_t coff = std::size_t(peOffset) + 4;
+        std::uint32_t optionalSize, optMagic;
+        if (!f.U16(coff + 2, img.sectionCount) || !f.U16(coff + 16, optionalSize)) return false;
+        const std::size_t opt = coff + 20;
+        if (!f.U16(opt, optMagic)) return false;
+
+        // PE32 and PE32+ differ only in where the data directories start
+        std::size_t dirCountAt, dirsAt;
+        if (optMagic == 0x10B) { dirCountAt = opt + 92; dirsAt = opt + 96; }
+        else if (optMagic == 0x20B) { dirCountAt = opt + 108; dirsAt = opt + 112; }
+        else return false;
+
+        std::uint32_t dirCount, rva, size;
+        if (!f.U32(dirCountAt, dirCount) || dirCount <= 2) return false;
+        if (dirsAt + 3 * 8 > opt + optionalSize) return false;
+        if (!f.U32(dirsAt + 2 * 8, rva) || !f.U32(dirsAt + 2 * 8 + 4, size) || !rva || !size) return false;
+
+        img.sectionTable = opt + optionalSize;
+        if (!img.file.Has(img.sectionTable, std::size_t(img.sectionCount) * 40)) return false;
+
+        // Size may exceed what the file backs (padding); keep what is there
+        std::size_t base;
+        if (!img.RvaToOffset(rva, 16, base)) return false;
+        img.resourceBase = base;
+        img.resourceSize = size;
+        return true;
+    }
+
+    // One level of the resource tree: entry `index` in directory order
+    // (named entries first, then ids ascending)
+    struct DirEntry {
+        bool          named;
+        std::uint32_t id;
+        std::uint32_t offset;  // Relative to the resource base
+        bool          subdirectory;
+    };
+
+    bool DirCount(const Image& img, std::uint32_t dir, std::uint32_t& count)
+    {
+        std::uint32_t named, ids;
+        if (!img.file.U16(img.resourceBase + dir + 12, named) ||
+            !img.file.U16(img.resourceBase + dir + 14, ids)) return false;
+        count = named + ids;
+        return true;
+    }
+
+    bool DirEntryAt(const Image& img, std::uint32_t dir, std::uint32_t index, DirEntry& e)
+    {
+        const std::size_t at = img.resourceBase + dir + 16 + std::size_t(index) * 8;
+        std::uint32_t name, target;
+        if (!img.file.U32(at, name) || !img.file.U32(at + 4, target)) return false;
+        e.named = (name & 0x80000000u) != 0;
+        e.id = name & 0xFFFF;
+        e.subdirectory = (target & 0x80000000u) != 0;
+        e.offset = target & 0x7FFFFFFFu;
+        return e.offset < img.resourceSize;
+    }
+
+    // Subdirectory under `dir` for a numeric id
+    bool FindById(const Image& img, std::uint32_t dir, std::uint32_t id, DirEntry& e)
+    {
+        std::uint32_t count;
+        if (!DirCount(img, dir, count)) return false;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            if (DirEntryAt(img, dir, i, e) && !e.named && e.id == id) return true;
+        }
+        return false;
+    }
+
+    // Data of the first language under a name-level entry
+    bool FirstLanguageData(const Image& img, const DirEntry& nameEntry, const std::uint8_t*& data,
+        std::size_t& size)
+    {
+        if (!nameEntry.subdirectory) return false;
+        std::uint32_t count;
+        DirEntry lang;
+        if (!DirCount(img, nameEntry.offset, count) || count == 0) return false;
+        if (!DirEntryAt(img, nameEntry.offset, 0, lang) || lang.subdirectory) return false;
+
+        std::uint32_t rva, length;
+        std::size_t offset;
+        const std::size_t leaf = img.resourceBase + lang.offset;
+        if (!img.file.U32(leaf, rva) || !img.file.U32(leaf + 4, length)) return false;
+        if (!img.RvaToOffset(rva, length, offset)) return false;
+        data = img.file.At(offset);
+        size = length;
+        return true;
+    }
+
+    // Real pixel size and depth from the image data; the group directory
+    // stores 0 for 256 and is not always accurate
+    bool DescribeImage(PeIcons::IconImage& image)
+    {
+        static const std::uint8_t kPngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        const Reader r(image.data, image.size);
+        std::uint32_t a, b, c;
+
+        if (image.size >= 8 && std::memcmp(image.data, kPngSignature, 8) == 0) {
+            // IHDR comes first: width and height big-endian at 16 and 20, depth at 24
+            if (!r.Has(16, 10)) return false;
+            const std::uint8_t* p = image.data;
+            image.png = true;
+            image.width = int((std::uint32_t(p[16]) << 24) | (p[17] << 16) | (p[18] << 8) | p[19]);
+            image.height = int((std::uint32_t(p[20]) << 24) | (p[21] << 16) | (p[22] << 8) | p[23]);
+            image.bitCount = 32;
+            return image.width > 0 && image.height > 0;
+        }
+
+        if (!r.U32(0, a) || a < 40 || !r.U32(4, b) || !r.U32(8, c) || !r.U16(14, a)) return false;
+        image.png = false;
+        image.width = int(b);
+        image.height = int(c) / 2; // XOR and AND rows stacked
+        image.bitCount = int(a);
+        return image.width > 0 && image.height > 0;
+    }
+
+    // Lower is better: exact size, then smallest larger, then largest smaller
+    long long SizeRank(int size, int target)
+    {
+        if (size == target) return 0;
+        if (size > target) return size - target;
+        return 1000000LL + (target - size);
+    }
+}
+
+bool PeIcons::FindIcon(const std::uint8_t* file, std::size_t size, int groupIndex, int targetSize,
+    IconImage& out)
+{
+    if (!file || targetSize <= 0) return false;
+
+    Image img{ Reader(file, size) };
+    if (!ParseHeaders(img)) return false;
+
+    DirEntry groups, icons;
+    if (!FindById(img, 0, kRtGroupIcon, groups) || !groups.subdirectory) return false;
+    if (!FindById(img, 0, kRtIcon, icons) || !icons.subdirectory) return false;
+
+    // Pick the group
+    DirEntry group{};
+    if (groupIndex >= 0) {
+        std::uint32_t count;
+        if (!DirCount(img, groups.offset, count) || std::uint32_t(groupIndex) >= count) return false;
+        if (!DirEntryAt(img, groups.offset, std::uint32_t(groupIndex), group)) return false;
+    }
+    else if (!FindById(img, groups.offset, std::uint32_t(-groupIndex), group)) {
+        return false;
+    }
+
+    const std::uint8_t* dir;
+    std::size_t dirSize;
+    if (!FirstLanguageData(img, group, dir, dirSize)) return false;
+
+    // GRPICONDIR: reserved, type (1 = icon), count, then 14-byte entries
+    const Reader g(dir, dirSize);
+    std::uint32_t type, count;
+    if (!g.U16(2, type) || type != 1 || !g.U16(4, count)) return false;
+
+    bool found = false;
+    long long bestRank = 0;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const std::size_t at = 6 + std::size_t(i) * 14;
+        std::uint32_t id;
+        if (!g.U16(at + 12, id)) break;
+
+        DirEntry entry;
+        IconImage image;
+        if (!FindById(img, icons.offset, id, entry)) continue;
+        if (!FirstLanguageData(img, entry, image.data, image.size)) continue;
+        if (!DescribeImage(image)) continue;
+
+        const long long rank = SizeRank(image.width, targetSize) * 64 - image.bitCount;
+        if (!found || rank < bestRank) {
+            found = true;
+            bestRank = rank;
+            out = image;
+        }
+    }
+    return found;
+}
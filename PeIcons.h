@@ -0,0 +1,34 @@
+#pragma once
+#ifndef PEICONS_H
+#define PEICONS_H
+
+// Reads icons straight out of a PE file's resource section (RT_GROUP_ICON /
+// RT_ICON) held in memory, e.g. a read-only mapping of an exe. Platform-neutral;
+// every offset is bounds-checked, so damaged files just yield no icon.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PeIcons {
+
+    // One RT_ICON image: a PNG stream or a DIB (BITMAPINFOHEADER, XOR and AND
+    // rows), exactly what CreateIconFromResourceEx takes. Points into the file.
+    struct IconImage {
+        const std::uint8_t* data = nullptr;
+        std::size_t         size = 0;
+        int                 width = 0;
+        int                 height = 0;
+        int                 bitCount = 0;
+        bool                png = false;
+    };
+
+    // Picks the image of an icon group closest to `targetSize` px: an exact
+    // size first, then the smallest larger one, then the largest smaller one;
+    // ties go to the deeper color. Like ExtractIconEx, `groupIndex` >= 0 counts
+    // groups in resource order and a negative value is a resource id.
+    bool FindIcon(const std::uint8_t* file, std::size_t size, int groupIndex, int targetSize,
+        IconImage& out);
+
+} // namespace PeIcons
+
+#endif // PEICONS_H
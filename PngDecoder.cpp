@@ -0,0 +1,545 @@
+#include "PngDecoder.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+    std::uint32_t BigEndian32(const std::uint8_t* p)
+    {
+        return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+    }
+
+    // Walks the chunk list: length, type, data, CRC. CRCs are not verified;
+    // a corrupt payload still has to survive the inflate and bounds checks.
+    struct Chunk {
+        std::size_t   data = 0;  // Offset of the payload
+        std::uint32_t length = 0;
+        char          type[5] = {};
+    };
+
+    bool ChunkAt(const std::uint8_t* file, std::size_t size, std::size_t offset, Chunk& c)
+    {
+        if (offset > size || size - offset < 12) return false;
+        c.length = BigEndian32(file + offset);
+        if (c.length > 0x7FFFFFFFu || size - offset - 12 < c.length) return false;
+        std::memcpy(c.type, file + offset + 4, 4);
+        c.data = offset + 8;
+        return true;
+    }
+
+    std::size_t NextChunk(const Chunk& c) { return c.data + c.length + 4; }
+
+    // The zlib stream spread over consecutive IDAT chunks, one byte at a time
+    class IdatStream {
+    public:
+        IdatStream(const std::uint8_t* file, std::size_t size, const Chunk& first)
+            : file_(file), size_(size), chunk_(first), pos_(first.data) {}
+
+        bool Next(std::uint8_t& b)
+        {
+            while (pos_ == chunk_.data + chunk_.length) {
+                Chunk next;
+                if (!ChunkAt(file_, size_, NextChunk(chunk_), next) || std::memcmp(next.type, "IDAT", 4) != 0)
+                    return false;
+                chunk_ = next;
+                pos_ = next.data;
+            }
+            b = file_[pos_++];
+            return true;
+        }
+
+    private:
+        const std::uint8_t* file_;
+        std::size_t         size_;
+        Chunk               chunk_;
+        std::size_t         pos_;
+    };
+
+    // Canonical Huffman code. Codes up to kFastBits long resolve with one
+    // table lookup; longer ones walk the per-length counts.
+    constexpr int kMaxBits = 15;
+    constexpr int kFastBits = 9;
+
+    struct Huffman {
+        std::uint16_t fast[1 << kFastBits];  // (symbol << 4) | length, 0 if longer
+        std::uint16_t counts[kMaxBits + 1];
+        std::uint16_t symbols[288];
+
+        bool Build(const std::uint8_t* lengths, int n)
+        {
+            std::memset(fast, 0, sizeof(fast));
+            std::memset(counts, 0, sizeof(counts));
+            for (int i = 0; i < n; ++i) ++counts[lengths[i]];
+            counts[0] = 0;
+
+            // Over-subscribed codes are invalid; incomplete ones are allowed
+            int left = 1;
+            for (int len = 1; len <= kMaxBits; ++len) {
+                left = (left << 1) - counts[len];
+                if (left < 0) return false;
+            }
+
+            std::uint16_t offsets[kMaxBits + 2] = {};
+            for (int len = 1; len <= kMaxBits; ++len) offsets[len + 1] = offsets[len] + counts[len];
+            for (int i = 0; i < n; ++i) {
+                if (lengths[i]) symbols[offsets[lengths[i]]++] = static_cast<std::uint16_t>(i);
+            }
+
+            // Fast table: deflate sends codes most significant bit first, so
+            // the index is the bit-reversed code
+            int code = 0, index = 0;
+            for (int len = 1; len <= kFastBits; ++len) {
+                for (int k = 0; k < counts[len]; ++k, ++code, ++index) {
+                    int reversed = 0;
+                    for (int b = 0; b < len; ++b) reversed |= ((code >> b) & 1) << (len - 1 - b);
+                    for (int fill = reversed; fill < (1 << kFastBits); fill += 1 << len) {
+                        fast[fill] = static_cast<std::uint16_t>((symbols[index] << 4) | len);
+                    }
+                }
+                code <<= 1;
+            }
+            return true;
+        }
+    };
+
+    const std::uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const std::uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const std::uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const std::uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    const std::uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    // Pull-style inflate: Read(n) produces exactly n bytes, keeping any
+    // unfinished back-reference for the next call
+    class Inflater {
+    public:
+        explicit Inflater(IdatStream& in) : in_(in), window_(kWindow) {}
+
+        bool Start()
+        {
+            std::uint32_t cmf, flg;
+            if (!Bits(8, cmf) || !Bits(8, flg)) return false;
+            if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7) return false; // Deflate, window <= 32 KB
+            if (((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) return false; // Check bits, no preset dictionary
+            return true;
+        }
+
+        bool Read(std::uint8_t* dst, std::size_t n)
+        {
+            std::size_t produced = 0;
+            while (produced < n) {
+                if (copyLength_) {
+                    // Back-reference; may overlap the bytes it produces
+                    const std::size_t count = std::min<std::size_t>(copyLength_, n - produced);
+                    for (std::size_t i = 0; i < count; ++i) {
+                        Emit(window_[(total_ - copyDistance_) & kWindowMask], dst, produced);
+                    }
+                    copyLength_ -= static_cast<std::uint32_t>(count);
+                    continue;
+                }
+
+                if (!inBlock_ && !BeginBlock()) return false;
+
+                if (blockType_ == 0) {
+                    if (storedLeft_ == 0) { inBlock_ = false; continue; }
+                    std::uint32_t b;
+                    if (!Bits(8, b)) return false;
+                    Emit(static_cast<std::uint8_t>(b), dst, produced);
+                    --storedLeft_;
+                    continue;
+                }
+
+                int sym;
+                if (!Decode(*litLen_, sym)) return false;
+                if (sym < 256) {
+                    Emit(static_cast<std::uint8_t>(sym), dst, produced);
+                    continue;
+                }
+                if (sym == 256) { inBlock_ = false; continue; }
+
+                sym -= 257;
+                if (sym >= 29) return false;
+                std::uint32_t extra;
+                if (!Bits(kLengthExtra[sym], extra)) return false;
+                const std::uint32_t length = kLengthBase[sym] + extra;
+
+                int d;
+                if (!Decode(*dist_, d) || d >= 30) return false;
+                if (!Bits(kDistExtra[d], extra)) return false;
+                const std::uint32_t distance = kDistBase[d] + extra;
+                if (distance > total_) return false; // Reaches before the start of the stream
+
+                copyLength_ = length;
+                copyDistance_ = distance;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr std::size_t kWindow = 32768;
+        static constexpr std::size_t kWindowMask = kWindow - 1;
+
+        void Emit(std::uint8_t b, std::uint8_t* dst, std::size_t& produced)
+        {
+            window_[total_ & kWindowMask] = b;
+            ++total_;
+            dst[produced++] = b;
+        }
+
+        // Bits arrive least significant first. Past the end of the input the
+        // buffer is padded with zeros so lookahead works, but consuming any
+        // padding is an error.
+        void Fill(int need)
+        {
+            while (count_ < need) {
+                std::uint8_t b = 0;
+                if (!in_.Next(b)) padding_ += 8;
+                bits_ |= std::uint64_t(b) << count_;
+                count_ += 8;
+            }
+        }
+
+        bool Consume(int n)
+        {
+            bits_ >>= n;
+            count_ -= n;
+            return count_ >= padding_;
+        }
+
+        bool Bits(int n, std::uint32_t& v)
+        {
+            if (n == 0) { v = 0; return true; }
+            Fill(n);
+            v = static_cast<std::uint32_t>(bits_ & ((std::uint64_t(1) << n) - 1));
+            return Consume(n);
+        }
+
+        bool Decode(const Huffman& h, int& sym)
+        {
+            Fill(kMaxBits);
+            const std::uint16_t e = h.fast[bits_ & ((1u << kFastBits) - 1)];
+            if (e) {
+                sym = e >> 4;
+                return Consume(e & 15);
+            }
+
+            int code = 0, first = 0, index = 0;
+            for (int len = 1; len <= kMaxBits; ++len) {
+                code |= static_cast<int>((bits_ >> (len - 1)) & 1);
+                const int count = h.counts[len];
+                if (code - first < count) {
+                    sym = h.symbols[index + code - first];
+                    return Consume(len);
+                }
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+            return false;
+        }
+
+        bool BeginBlock()
+        {
+            if (lastBlock_) return false; // Stream ended before the image did
+
+            std::uint32_t final, type;
+            if (!Bits(1, final) || !Bits(2, type)) return false;
+            lastBlock_ = final != 0;
+            blockType_ = static_cast<int>(type);
+
+            if (type == 0) {
+                // Stored: skip to a byte boundary, then LEN and its complement
+                std::uint32_t skip, len, nlen;
+                if (!Bits(count_ % 8, skip) || !Bits(16, len) || !Bits(16, nlen)) return false;
+                if ((len ^ 0xFFFF) != nlen) return false;
+                storedLeft_ = len;
+            }
+            else if (type == 1) {
+                if (!fixedBuilt_) {
+                    std::uint8_t lengths[288 + 30];
+                    std::fill(lengths, lengths + 144, 8);
+                    std::fill(lengths + 144, lengths + 256, 9);
+                    std::fill(lengths + 256, lengths + 280, 7);
+                    std::fill(lengths + 280, lengths + 288, 8);
+                    std::fill(lengths + 288, lengths + 318, 5);
+                    fixedLitLen_.Build(lengths, 288);
+                    fixedDist_.Build(lengths + 288, 30);
+                    fixedBuilt_ = true;
+                }
+                litLen_ = &fixedLitLen_;
+                dist_ = &fixedDist_;
+            }
+            else if (type == 2) {
+                if (!ReadDynamicTables()) return false;
+                litLen_ = &dynLitLen_;
+                dist_ = &dynDist_;
+            }
+            else {
+                return false;
+            }
+            inBlock_ = true;
+            return true;
+        }
+
+        bool ReadDynamicTables()
+        {
+            std::uint32_t hlit, hdist, hclen;
+            if (!Bits(5, hlit) || !Bits(5, hdist) || !Bits(4, hclen)) return false;
+            hlit += 257;
+            hdist += 1;
+            hclen += 4;
+            if (hlit > 286 || hdist > 30) return false;
+
+            std::uint8_t clLengths[19] = {};
+            for (std::uint32_t i = 0; i < hclen; ++i) {
+                std::uint32_t v;
+                if (!Bits(3, v)) return false;
+                clLengths[kCodeLengthOrder[i]] = static_cast<std::uint8_t>(v);
+            }
+            Huffman cl;
+            if (!cl.Build(clLengths, 19)) return false;
+
+            std::uint8_t lengths[286 + 30] = {};
+            std::uint32_t i = 0;
+            while (i < hlit + hdist) {
+                int sym;
+                if (!Decode(cl, sym)) return false;
+                if (sym < 16) { lengths[i++] = static_cast<std::uint8_t>(sym); continue; }
+
+                std::uint32_t repeat, value = 0;
+                if (sym == 16) {
+                    if (i == 0 || !Bits(2, repeat)) return false;
+                    value = lengths[i - 1];
+                    repeat += 3;
+                }
+                else if (sym == 17) {
+                    if (!Bits(3, repeat)) return false;
+                    repeat += 3;
+                }
+                else {
+                    if (!Bits(7, repeat)) return false;
+                    repeat += 11;
+                }
+                if (i + repeat > hlit + hdist) return false;
+                while (repeat--) lengths[i++] = static_cast<std::uint8_t>(value);
+            }
+            if (lengths[256] == 0) return false; // No end-of-block code
+
+            return dynLitLen_.Build(lengths, static_cast<int>(hlit)) &&
+                dynDist_.Build(lengths + hlit, static_cast<int>(hdist));
+        }
+
+        IdatStream&               in_;
+        std::uint64_t             bits_ = 0;
+        int                       count_ = 0;
+        int                       padding_ = 0;
+
+        std::vector<std::uint8_t> window_;
+        std::size_t               total_ = 0;      // Bytes produced so far
+        std::uint32_t             copyLength_ = 0;
+        std::uint32_t             copyDistance_ = 0;
+
+        bool                      inBlock_ = false;
+        bool                      lastBlock_ = false;
+        int                       blockType_ = 0;
+        std::uint32_t             storedLeft_ = 0;
+        const Huffman*            litLen_ = nullptr;
+        const Huffman*            dist_ = nullptr;
+        bool                      fixedBuilt_ = false;
+        Huffman                   fixedLitLen_, fixedDist_, dynLitLen_, dynDist_;
+    };
+
+    std::uint8_t Paeth(int a, int b, int c)
+    {
+        const int p = a + b - c;
+        const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return static_cast<std::uint8_t>(a);
+        return static_cast<std::uint8_t>(pb <= pc ? b : c);
+    }
+
+    bool Unfilter(int filter, std::uint8_t* cur, const std::uint8_t* prev, std::size_t n, std::size_t bpp)
+    {
+        switch (filter) {
+        case 0:
+            return true;
+        case 1:
+            for (std::size_t i = bpp; i < n; ++i) cur[i] = static_cast<std::uint8_t>(cur[i] + cur[i - bpp]);
+            return true;
+        case 2:
+            for (std::size_t i = 0; i < n; ++i) cur[i] = static_cast<std::uint8_t>(cur[i] + prev[i]);
+            return true;
+        case 3:
+            for (std::size_t i = 0; i < n; ++i) {
+                const int left = i >= bpp ? cur[i - bpp] : 0;
+                cur[i] = static_cast<std::uint8_t>(cur[i] + ((left + prev[i]) >> 1));
+            }
+            return true;
+        case 4:
+            for (std::size_t i = 0; i < n; ++i) {
+                const int left = i >= bpp ? cur[i - bpp] : 0;
+                const int upLeft = i >= bpp ? prev[i - bpp] : 0;
+                cur[i] = static_cast<std::uint8_t>(cur[i] + Paeth(left, prev[i], upLeft));
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    int Channels(int colorType)
+    {
+        switch (colorType) {
+        case 0: return 1; // Gray
+        case 2: return 3; // RGB
+        case 3: return 1; // Palette
+        case 4: return 2; // Gray + alpha
+        case 6: return 4; // RGBA
+        default: return 0;
+        }
+    }
+
+    bool ValidDepth(int colorType, int depth)
+    {
+        switch (colorType) {
+        case 0: return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+        case 3: return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+        case 2: case 4: case 6: return depth == 8 || depth == 16;
+        default: return false;
+        }
+    }
+}
+
+bool PngDecoder::ReadHeader(const std::uint8_t* data, std::size_t size, Header& header)
+{
+    static const std::uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (!data || size < 8 || std::memcmp(data, kSignature, 8) != 0) return false;
+
+    Chunk ihdr;
+    if (!ChunkAt(data, size, 8, ihdr) || std::memcmp(ihdr.type, "IHDR", 4) != 0 || ihdr.length != 13) return false;
+    const std::uint8_t* p = data + ihdr.data;
+    const std::uint32_t w = BigEndian32(p), h = BigEndian32(p + 4);
+    if (w == 0 || h == 0 || w > kMaxDimension || h > kMaxDimension) return false;
+    if (p[10] != 0 || p[11] != 0 || p[12] > 1) return false; // Compression, filter, interlace methods
+
+    header.width = static_cast<int>(w);
+    header.height = static_cast<int>(h);
+    header.bitDepth = p[8];
+    header.colorType = p[9];
+    header.interlaced = p[12] == 1;
+    return ValidDepth(header.colorType, header.bitDepth);
+}
+
+bool PngDecoder::Decode(const std::uint8_t* data, std::size_t size, const RowCallback& row)
+{
+    Header hdr;
+    if (!ReadHeader(data, size, hdr) || hdr.interlaced) return false;
+
+    const int channels = Channels(hdr.colorType);
+    const int depth = hdr.bitDepth;
+    const std::size_t rowBytes = (static_cast<std::size_t>(hdr.width) * channels * depth + 7) / 8;
+    const std::size_t bpp = std::max<std::size_t>(1, static_cast<std::size_t>(channels) * depth / 8);
+
+    // Ancillary chunks before the image data: palette and transparency
+    std::uint32_t palette[256];
+    std::fill(palette, palette + 256, 0xFF000000u);
+    int paletteSize = 0;
+    bool hasKey = false;
+    std::uint16_t key[3] = {}; // Transparent gray or RGB sample, full precision
+
+    Chunk c;
+    std::size_t offset = 8;
+    for (;;) {
+        if (!ChunkAt(data, size, offset, c)) return false;
+        const std::uint8_t* p = data + c.data;
+        if (std::memcmp(c.type, "IDAT", 4) == 0) break;
+        if (std::memcmp(c.type, "IEND", 4) == 0) return false;
+
+        if (std::memcmp(c.type, "PLTE", 4) == 0) {
+            if (c.length % 3 != 0 || c.length / 3 > 256) return false;
+            paletteSize = static_cast<int>(c.length / 3);
+            for (int i = 0; i < paletteSize; ++i) {
+                palette[i] = 0xFF000000u | (std::uint32_t(p[i * 3]) << 16) | (std::uint32_t(p[i * 3 + 1]) << 8) | p[i * 3 + 2];
+            }
+        }
+        else if (std::memcmp(c.type, "tRNS", 4) == 0) {
+            if (hdr.colorType == 3) {
+                const std::uint32_t n = std::min<std::uint32_t>(c.length, 256);
+                for (std::uint32_t i = 0; i < n; ++i) palette[i] = (palette[i] & 0xFFFFFF) | (std::uint32_t(p[i]) << 24);
+            }
+            else if (hdr.colorType == 0 && c.length >= 2) {
+                hasKey = true;
+                key[0] = static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+            }
+            else if (hdr.colorType == 2 && c.length >= 6) {
+                hasKey = true;
+                for (int i = 0; i < 3; ++i) key[i] = static_cast<std::uint16_t>((p[i * 2] << 8) | p[i * 2 + 1]);
+            }
+        }
+        offset = NextChunk(c);
+    }
+    if (hdr.colorType == 3 && paletteSize == 0) return false;
+
+    IdatStream stream(data, size, c);
+    Inflater inflater(stream);
+    if (!inflater.Start()) return false;
+
+    std::vector<std::uint8_t> cur(rowBytes), prev(rowBytes, 0);
+    std::vector<std::uint32_t> argb(hdr.width);
+    const int maxSample = (1 << depth) - 1;
+
+    for (int y = 0; y < hdr.height; ++y) {
+        std::uint8_t filter;
+        if (!inflater.Read(&filter, 1) || !inflater.Read(cur.data(), rowBytes)) return false;
+        if (!Unfilter(filter, cur.data(), prev.data(), rowBytes, bpp)) return false;
+
+        const std::uint8_t* s = cur.data();
+        // Sample x of channel ch at full precision
+        auto sample = [&](int x, int ch) -> int {
+            if (depth == 8) return s[x * channels + ch];
+            if (depth == 16) return (s[(x * channels + ch) * 2] << 8) | s[(x * channels + ch) * 2 + 1];
+            const int bit = x * depth; // Sub-byte depths only occur with one channel
+            return (s[bit >> 3] >> (8 - depth - (bit & 7))) & maxSample;
+        };
+        auto to8 = [&](int v) -> std::uint32_t {
+            return depth == 16 ? std::uint32_t(v >> 8) : std::uint32_t(v * 255 / maxSample);
+        };
+
+        for (int x = 0; x < hdr.width; ++x) {
+            std::uint32_t px;
+            switch (hdr.colorType) {
+            case 0: {
+                const int v = sample(x, 0);
+                const std::uint32_t g = to8(v);
+                px = (hasKey && v == key[0] ? 0u : 0xFF000000u) | (g << 16) | (g << 8) | g;
+                break;
+            }
+            case 2: {
+                const int r = sample(x, 0), g = sample(x, 1), b = sample(x, 2);
+                const bool clear = hasKey && r == key[0] && g == key[1] && b == key[2];
+                px = (clear ? 0u : 0xFF000000u) | (to8(r) << 16) | (to8(g) << 8) | to8(b);
+                break;
+            }
+            case 3:
+                px = palette[sample(x, 0)];
+                break;
+            case 4: {
+                const std::uint32_t g = to8(sample(x, 0));
+                px = (to8(sample(x, 1)) << 24) | (g << 16) | (g << 8) | g;
+                break;
+            }
+            default:
+                px = (to8(sample(x, 3)) << 24) | (to8(sample(x, 0)) << 16) | (to8(sample(x, 1)) << 8) | to8(sample(x, 2));
+                break;
+            }
+            argb[x] = px;
+        }
+        row(y, argb.data());
+        cur.swap(prev);
+    }
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef PNGDECODER_H
+#define PNGDECODER_H
+
+// Streaming PNG decoder for app logos. Scanlines are inflated and unfiltered
+// one at a time and handed out as straight ARGB, so memory stays at two rows
+// plus the 32 KB inflate window whatever the image size. Platform-neutral.
+//
+// Input is untrusted: every length, code and distance is checked and a
+// damaged file fails cleanly. Interlaced images are not supported (they
+// can't be streamed row by row); callers fall back to another decoder.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace PngDecoder {
+
+    // Largest width or height accepted.
+    constexpr int kMaxDimension = 16384;
+
+    struct Header {
+        int  width = 0;
+        int  height = 0;
+        int  bitDepth = 0;
+        int  colorType = 0;
+        bool interlaced = false;
+    };
+
+    // Parses the signature and IHDR.
+    bool ReadHeader(const std::uint8_t* data, std::size_t size, Header& header);
+
+    // Called once per row, top to bottom, with `width` pixels valid for the call only.
+    using RowCallback = std::function<void(int y, const std::uint32_t* argb)>;
+
+    // Decodes every row. Returns false (possibly after some rows were
+    // delivered) for anything malformed or unsupported.
+    bool Decode(const std::uint8_t* data, std::size_t size, const RowCallback& row);
+
+} // namespace PngDecoder
+
+#endif // PNGDECODER_H
@@ -8,9 +8,12 @@
 #define IDM_RESTORE_ALL     1002
 #define IDM_ABOUT           1003
 #define IDM_SETTINGS        1004
+#define IDM_DIAGNOSTICS     1005
 
 #define WM_TRAY_CALLBACK    (WM_USER + 1)
 #define WM_RESTORE_WINDOW   (WM_USER + 2)
+#define WM_RESTORE_CONTINUE (WM_USER + 3) // Next slice of an incremental restore-all
+#define WM_ICON_READY       (WM_USER + 4) // lParam: IconPipeline::Result*
 
 // Settings dialog controls (pure-code dialog, still need IDs)
 #define IDC_CHK_USEVD                   2001
@@ -27,6 +30,11 @@
 #define IDC_CHK_USE_COLLECTION_MODE     2012
 #define IDC_HOTKEY_SHOW_COLLECTION      2013
 #define IDC_LABEL_HK_SHOW_COLLECTION    2014
+#define IDC_EDIT_CLOAK_APPS             2015
+#define IDC_LABEL_CLOAK_APPS            2016
+#define IDC_EDIT_ICON_BUDGET            2017
+#define IDC_LABEL_ICON_BUDGET           2018
+#define IDC_CHK_GROUP_TRAY_ICONS        2019
 
 // Collection Window controls
 #define IDC_LIST_WINDOWS                3001
@@ -40,4 +48,7 @@
 #define ID_HOTKEY_HIDE_ALL      0x2002
 #define ID_HOTKEY_SHOW_COLLECTION 0x2003
 
+// Timer IDs (main window)
+#define IDT_ICON_IDLE           1 // Collection-mode icons: idle materialization, memory checks
+
 #endif
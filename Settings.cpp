@@ -33,12 +33,20 @@ bool SettingsManager::FromIniBool(const wchar_t* section, const wchar_t* key, bo
     ::GetPrivateProfileStringW(section, key, def ? L"1" : L"0", buf, ARRAYSIZE(buf), path.c_str());
     return (buf[0] == L'1' || buf[0] == L'Y' || buf[0] == L'y' || _wcsicmp(buf, L"true") == 0);
 }
+std::wstring SettingsManager::FromIniString(const wchar_t* section, const wchar_t* key, const std::wstring& def, const std::wstring& path) {
+    wchar_t buf[1024] = { 0 };
+    ::GetPrivateProfileStringW(section, key, def.c_str(), buf, ARRAYSIZE(buf), path.c_str());
+    return buf;
+}
 void SettingsManager::WriteIniInt(const wchar_t* section, const wchar_t* key, UINT val, const std::wstring& path) {
     ::WritePrivateProfileStringW(section, key, ToW(val).c_str(), path.c_str());
 }
 void SettingsManager::WriteIniBool(const wchar_t* section, const wchar_t* key, bool val, const std::wstring& path) {
     ::WritePrivateProfileStringW(section, key, val ? L"1" : L"0", path.c_str());
 }
+void SettingsManager::WriteIniString(const wchar_t* section, const wchar_t* key, const std::wstring& val, const std::wstring& path) {
+    ::WritePrivateProfileStringW(section, key, val.c_str(), path.c_str());
+}
 
 bool SettingsManager::Load() {
     const auto path = GetSettingsPathW();
@@ -50,6 +58,9 @@ bool SettingsManager::Load() {
     UINT langNum = FromIniInt(L"General", L"Language", (UINT)s.language, path);
     s.language = (langNum == 1) ? I18N::Language::English : I18N::Language::Chinese;
     s.useCollectionMode = FromIniBool(L"General", L"UseCollectionMode", s.useCollectionMode, path); // --- NEW ---
+    s.cloakApps = FromIniString(L"General", L"CloakApps", s.cloakApps, path);
+    s.iconHandleBudget = FromIniInt(L"General", L"IconHandleBudget", s.iconHandleBudget, path);
+    s.groupTrayIcons = FromIniBool(L"General", L"GroupTrayIcons", s.groupTrayIcons, path);
 
     // [Hotkeys]
     s.hkMinTop.modifiers = FromIniInt(L"Hotkeys", L"MinTop_Mod", s.hkMinTop.modifiers, path);
@@ -74,6 +85,9 @@ bool SettingsManager::Save() const {
     WriteIniBool(L"General", L"UseVirtualDesktop", s.useVirtualDesktop, path);
     WriteIniInt(L"General", L"Language", (UINT)s.language, path);
     WriteIniBool(L"General", L"UseCollectionMode", s.useCollectionMode, path); // --- NEW ---
+    WriteIniString(L"General", L"CloakApps", s.cloakApps, path);
+    WriteIniInt(L"General", L"IconHandleBudget", s.iconHandleBudget, path);
+    WriteIniBool(L"General", L"GroupTrayIcons", s.groupTrayIcons, path);
 
     // [Hotkeys]
     WriteIniInt(L"Hotkeys", L"MinTop_Mod", s.hkMinTop.modifiers, path);
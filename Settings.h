@@ -19,6 +19,9 @@ struct Settings {
     // --- NEW ---
     bool                useCollectionMode = false;
     Hotkey              hkShowCollection{ MOD_CONTROL | MOD_ALT, 'C' }; // Ctrl+Alt+C
+    std::wstring        cloakApps;          // ';' separated exe names hidden via DWM cloaking
+    UINT                iconHandleBudget = 3000; // USER + GDI objects held by icons before eviction
+    bool                groupTrayIcons = false;  // One tray icon per application, with a window count
 };
 
 class SettingsManager {
@@ -40,8 +43,10 @@ private:
     static std::wstring ToW(UINT v);
     static UINT FromIniInt(const wchar_t* section, const wchar_t* key, UINT def, const std::wstring& path);
     static bool FromIniBool(const wchar_t* section, const wchar_t* key, bool def, const std::wstring& path);
+    static std::wstring FromIniString(const wchar_t* section, const wchar_t* key, const std::wstring& def, const std::wstring& path);
     static void WriteIniInt(const wchar_t* section, const wchar_t* key, UINT val, const std::wstring& path);
     static void WriteIniBool(const wchar_t* section, const wchar_t* key, bool val, const std::wstring& path);
+    static void WriteIniString(const wchar_t* section, const wchar_t* key, const std::wstring& val, const std::wstring& path);
 };
 
 #endif
\ No newline at end of file
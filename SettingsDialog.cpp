@@ -34,6 +34,9 @@ SettingsDialog::SettingsDialog(HWND parent, const Settings& current)
     , hBtnCancel_(nullptr)
     , hChkUseCollection_(nullptr) // --- NEW ---
     , hHkShowCollection_(nullptr) // --- NEW ---
+    , hEditCloakApps_(nullptr)
+    , hEditIconBudget_(nullptr)
+    , hChkGroupIcons_(nullptr)
 {
 }
 
@@ -89,7 +92,7 @@ bool SettingsDialog::Create()
 
     // --- MODIFIED: Increased height for better spacing ---
     int baseW = 560;
-    int baseH = 440; // Increased height
+    int baseH = 569; // Increased height
     int winW = Scale(baseW);
     int winH = Scale(baseH);
 
@@ -105,7 +108,7 @@ bool SettingsDialog::Create()
     if (winW > workW - margin) winW = workW - margin;
     if (winH > workH - margin) winH = workH - margin;
     winW = max(winW, Scale(420));
-    winH = max(winH, Scale(380)); // Increased min height
+    winH = max(winH, Scale(509)); // Increased min height
 
     DWORD style = WS_CAPTION | WS_SYSMENU | WS_POPUPWINDOW;
 
@@ -215,6 +218,14 @@ void SettingsDialog::BuildUi()
         margin, y, cw - 2 * margin, rowH,
         hWnd_, (HMENU)IDC_CHK_USE_COLLECTION_MODE,
         nullptr, nullptr);
+    y += rowH + SX(8);
+
+    // One tray icon per application
+    hChkGroupIcons_ = CreateWindowExW(0, L"BUTTON", L"",
+        WS_CHILD | WS_VISIBLE | BS_AUTOCHECKBOX,
+        margin, y, cw - 2 * margin, rowH,
+        hWnd_, (HMENU)IDC_CHK_GROUP_TRAY_ICONS,
+        nullptr, nullptr);
     y += rowH + SX(24);
 
 
@@ -254,6 +265,30 @@ void SettingsDialog::BuildUi()
         hkX, y, hkW, rowH,
         hWnd_, (HMENU)IDC_HOTKEY_SHOW_COLLECTION,
         nullptr, nullptr);
+    y += rowH + gap;
+
+    // Apps hidden via DWM cloaking
+    CreateWindowExW(0, L"STATIC", L"", WS_CHILD | WS_VISIBLE,
+        margin, y + SX(4), labelW, SX(20),
+        hWnd_, (HMENU)IDC_LABEL_CLOAK_APPS, nullptr, nullptr);
+
+    hEditCloakApps_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
+        WS_CHILD | WS_VISIBLE | WS_TABSTOP | ES_AUTOHSCROLL,
+        hkX, y, hkW, rowH,
+        hWnd_, (HMENU)IDC_EDIT_CLOAK_APPS,
+        nullptr, nullptr);
+    y += rowH + gap;
+
+    // Icon handle budget
+    CreateWindowExW(0, L"STATIC", L"", WS_CHILD | WS_VISIBLE,
+        margin, y + SX(4), labelW, SX(20),
+        hWnd_, (HMENU)IDC_LABEL_ICON_BUDGET, nullptr, nullptr);
+
+    hEditIconBudget_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
+        WS_CHILD | WS_VISIBLE | WS_TABSTOP | ES_NUMBER | ES_AUTOHSCROLL,
+        hkX, y, hkW, rowH,
+        hWnd_, (HMENU)IDC_EDIT_ICON_BUDGET,
+        nullptr, nullptr);
     y += rowH + gap + SX(8);
 
 
@@ -291,7 +326,12 @@ void SettingsDialog::BuildUi()
     setFont(GetDlgItem(hWnd_, IDC_LABEL_HK_TIP));
     setFont(hBtnSave_); setFont(hBtnCancel_);
     setFont(hChkUseCollection_); setFont(hHkShowCollection_);
+    setFont(hChkGroupIcons_);
     setFont(GetDlgItem(hWnd_, IDC_LABEL_HK_SHOW_COLLECTION));
+    setFont(hEditCloakApps_);
+    setFont(GetDlgItem(hWnd_, IDC_LABEL_CLOAK_APPS));
+    setFont(hEditIconBudget_);
+    setFont(GetDlgItem(hWnd_, IDC_LABEL_ICON_BUDGET));
 
     // Theming for more modern visuals
     ::SetWindowTheme(hComboLang_, L"Explorer", nullptr);
@@ -312,8 +352,13 @@ void SettingsDialog::BuildUi()
 
     SendMessageW(hChkUseCollection_, BM_SETCHECK,
         cur_.useCollectionMode ? BST_CHECKED : BST_UNCHECKED, 0);
+    SendMessageW(hChkGroupIcons_, BM_SETCHECK,
+        cur_.groupTrayIcons ? BST_CHECKED : BST_UNCHECKED, 0);
     SendMessageW(hHkShowCollection_, HKM_SETHOTKEY,
         MakeHotkeyWord(cur_.hkShowCollection), 0);
+
+    SetWindowTextW(hEditCloakApps_, cur_.cloakApps.c_str());
+    SetDlgItemInt(hWnd_, IDC_EDIT_ICON_BUDGET, cur_.iconHandleBudget, FALSE);
 }
 void SettingsDialog::ApplyLocalization()
 {
@@ -331,8 +376,13 @@ void SettingsDialog::ApplyLocalization()
     SetWindowTextW(hBtnCancel_, S("settings_btn_cancel"));
 
     SetWindowTextW(hChkUseCollection_, S("settings_use_collection_mode"));
+    SetWindowTextW(hChkGroupIcons_, S("settings_group_tray_icons"));
     SetWindowTextW(GetDlgItem(hWnd_, IDC_LABEL_HK_SHOW_COLLECTION),
         S("settings_hotkey_show_collection"));
+    SetWindowTextW(GetDlgItem(hWnd_, IDC_LABEL_CLOAK_APPS),
+        S("settings_cloak_apps"));
+    SetWindowTextW(GetDlgItem(hWnd_, IDC_LABEL_ICON_BUDGET),
+        S("settings_icon_budget"));
 }
 
 void SettingsDialog::CenterToParent()
@@ -435,9 +485,21 @@ void SettingsDialog::OnSave()
 
     s.useCollectionMode =
         (SendMessageW(hChkUseCollection_, BM_GETCHECK, 0, 0) == BST_CHECKED);
+    s.groupTrayIcons =
+        (SendMessageW(hChkGroupIcons_, BM_GETCHECK, 0, 0) == BST_CHECKED);
     s.hkShowCollection = FromHotkeyWord(
         (WORD)SendMessageW(hHkShowCollection_, HKM_GETHOTKEY, 0, 0));
 
+    int cloakLen = GetWindowTextLengthW(hEditCloakApps_);
+    std::wstring cloakApps(cloakLen + 1, L'\0');
+    GetWindowTextW(hEditCloakApps_, &cloakApps[0], cloakLen + 1);
+    cloakApps.resize(cloakLen);
+    s.cloakApps = cloakApps;
+
+    BOOL budgetOk = FALSE;
+    const UINT budget = GetDlgItemInt(hWnd_, IDC_EDIT_ICON_BUDGET, &budgetOk, FALSE);
+    if (budgetOk) s.iconHandleBudget = budget;
+
     result_ = s;
     saved_ = true;
     Destroy();
@@ -59,6 +59,9 @@ private:
     // --- NEW ---
     HWND hChkUseCollection_;
     HWND hHkShowCollection_;
+    HWND hEditCloakApps_;
+    HWND hEditIconBudget_;
+    HWND hChkGroupIcons_;
 
     bool saved_ = false;
     Settings result_;
@@ -15,6 +15,8 @@ namespace I18N {
         if (std::strcmp(key, "menu_about") == 0)       return L"关于";
         if (std::strcmp(key, "menu_exit") == 0)        return L"退出";
         if (std::strcmp(key, "menu_settings") == 0)    return L"设置…";
+        if (std::strcmp(key, "menu_diagnostics") == 0) return L"诊断信息";
+        if (std::strcmp(key, "diagnostics_title") == 0) return L"诊断信息";
 
         if (std::strcmp(key, "about_title") == 0)      return L"关于";
         if (std::strcmp(key, "about_text") == 0)       return L"Window-To-Tray\n\n左键点击托盘图标即可恢复对应窗口，\n右键点击可显示菜单，\n程序退出时会自动恢复所有窗口并清理虚拟桌面。";
@@ -41,6 +43,11 @@ namespace I18N {
         if (std::strcmp(key, "collection_window_title") == 0) return L"已收纳的窗口";
         // --- NEW ---
         if (std::strcmp(key, "collection_disable_mode_button") == 0) return L"退出收纳模式";
+        if (std::strcmp(key, "settings_cloak_apps") == 0) return L"使用隐身模式隐藏的程序 (exe，以 ; 分隔)";
+        if (std::strcmp(key, "settings_icon_budget") == 0) return L"图标句柄上限 (GDI/USER 对象)";
+        if (std::strcmp(key, "settings_group_tray_icons") == 0) return L"同一程序的窗口共用一个托盘图标 (显示窗口数)";
+        if (std::strcmp(key, "menu_restore_group") == 0) return L"恢复该程序的所有窗口";
+        if (std::strcmp(key, "tray_group_count") == 0) return L"%d 个窗口";
 
         return L"";
     }
@@ -50,6 +57,8 @@ namespace I18N {
         if (std::strcmp(key, "menu_about") == 0)       return L"About";
         if (std::strcmp(key, "menu_exit") == 0)        return L"Exit";
         if (std::strcmp(key, "menu_settings") == 0)    return L"Settings…";
+        if (std::strcmp(key, "menu_diagnostics") == 0) return L"Diagnostics";
+        if (std::strcmp(key, "diagnostics_title") == 0) return L"Diagnostics";
 
         if (std::strcmp(key, "about_title") == 0)      return L"About";
         if (std::strcmp(key, "about_text") == 0)       return L"Window-To-Tray\n\nLeft click a tray icon to restore the window.\nRight click to open the menu.\nAll windows will be restored and hidden desktops cleaned up on exit.";
@@ -76,6 +85,11 @@ namespace I18N {
         if (std::strcmp(key, "collection_window_title") == 0) return L"Collected Windows";
         // --- NEW ---
         if (std::strcmp(key, "collection_disable_mode_button") == 0) return L"Exit Collection Mode";
+        if (std::strcmp(key, "settings_cloak_apps") == 0) return L"Cloak-hide apps (exe names, ';' separated)";
+        if (std::strcmp(key, "settings_icon_budget") == 0) return L"Icon handle budget (GDI/USER objects)";
+        if (std::strcmp(key, "settings_group_tray_icons") == 0) return L"One tray icon per application (shows the window count)";
+        if (std::strcmp(key, "menu_restore_group") == 0) return L"Restore all windows of this application";
+        if (std::strcmp(key, "tray_group_count") == 0) return L"%d windows";
 
         return L"";
     }
@@ -26,7 +26,8 @@ namespace I18N {
     // "settings_hotkey_min_top", "settings_hotkey_hide_all", "settings_btn_save", "settings_btn_cancel", "settings_hotkey_tip"
     // "settings_use_collection_mode", "settings_hotkey_show_collection", "collection_window_title"
     // --- NEW ---
-    // "collection_disable_mode_button"
+    // "collection_disable_mode_button", "settings_cloak_apps", "menu_diagnostics", "diagnostics_title"
+    // "settings_icon_budget", "settings_group_tray_icons", "menu_restore_group", "tray_group_count"
 
 } // namespace I18N
 
@@ -2,313 +2,461 @@
 #include "Resource.h"
 #include "WindowManager.h"
 #include "VirtualDesktopManager.h"
+#include "Diagnostics.h"
+#include "WindowMessaging.h"
+#include "IconKernels.h"
+#include "HandleAudit.h"
 #include <commctrl.h>
 #include <shlwapi.h>
 #include <shlobj.h>
 #include <propsys.h>
 #include <propvarutil.h>
 #include <propkey.h>
-#include <gdiplus.h>
 #include <psapi.h>
 #include "UwpIconUtils.h"
 #include "Strings.h"
 #include <vector>
-#include <queue>
 #include <algorithm>
 
 #pragma comment(lib, "shlwapi.lib")
 #pragma comment(lib, "propsys.lib")
-#pragma comment(lib, "gdiplus.lib")
 #pragma comment(lib, "psapi.lib")
 
-using namespace Gdiplus;
 using namespace I18N;
 
+// Quiet time after the last collection-mode hide before its icons are
+// materialized, then the interval of the memory checks while they are held
+static const UINT kIconIdleDelayMs = 2000;
+static const UINT kIconMemoryCheckMs = 60000;
 
-static bool EnsureGdiPlus() {
-    static bool       inited = false;
-    static ULONG_PTR  token = 0;
-    if (!inited) {
-        GdiplusStartupInput si;
-        if (GdiplusStartup(&token, &si, nullptr) == Ok)
-            inited = true;
-    }
-    return inited;
-}
-
-static HICON LoadPngAsIcon(const std::wstring& path, int size) {
-    if (!EnsureGdiPlus()) return nullptr;
-    Bitmap src(path.c_str());
-    if (src.GetLastStatus() != Ok) return nullptr;
-    Bitmap dst(size, size, PixelFormat32bppARGB);
-    Graphics g(&dst);
-    g.SetInterpolationMode(InterpolationModeHighQualityBicubic);
-    g.DrawImage(&src, 0, 0, size, size);
-    HBITMAP hbmColor = nullptr;
-    if (dst.GetHBITMAP(Color(0, 0, 0, 0), &hbmColor) != Ok) return nullptr;
-    ICONINFO ii{};
-    ii.fIcon = TRUE;
-    ii.hbmColor = hbmColor;
-    ii.hbmMask = CreateBitmap(size, size, 1, 1, nullptr);
-    HICON hIcon = CreateIconIndirect(&ii);
-    DeleteObject(ii.hbmColor);
-    DeleteObject(ii.hbmMask);
-    return hIcon;
-}
-
-struct ContentBounds {
-    int left, top, right, bottom;
-    bool isEmpty;
-
-    ContentBounds() : left(INT_MAX), top(INT_MAX), right(-1), bottom(-1), isEmpty(true) {}
-
-    void addPoint(int x, int y) {
-        if (isEmpty) {
-            left = right = x;
-            top = bottom = y;
-            isEmpty = false;
-        }
-        else {
-            left = std::min(left, x);
-            right = std::max(right, x);
-            top = std::min(top, y);
-            bottom = std::max(bottom, y);
-        }
-    }
+// Accepted icon budgets: below the floor a handful of apps would thrash, above
+// the ceiling the per-process quotas (10,000 each) come too close
+static const size_t kMinIconBudget = 300;
+static const size_t kMaxIconBudget = 9000;
 
-    int width() const { return isEmpty ? 0 : (right - left + 1); }
-    int height() const { return isEmpty ? 0 : (bottom - top + 1); }
+// Group icons take uIDs below the registry's range: registry ids carry a
+// generation in their high bits, so they are never under 1 << kSlotBits
+static const UINT kFirstGroupId = 2;
+static const UINT kGroupIdEnd = 1u << TrayIconRegistry::kSlotBits;
 
-    int getMinDistanceToEdge(int iconWidth, int iconHeight) const {
-        if (isEmpty) return 0;
-        return std::min({ left, top, iconWidth - 1 - right, iconHeight - 1 - bottom });
-    }
-};
-
-// --- OPTIMIZED: Rewritten to use GDI+ for high-quality scaling ---
-HICON RemoveIconBackground_FloodFillAndScale(HICON hIcon, bool& outOwnsNewIcon)
+// Small-icon size the shell draws tray icons at for a DPI
+static int TrayIconSize(UINT dpi)
 {
-    outOwnsNewIcon = false;
-    if (!hIcon || !EnsureGdiPlus()) return nullptr;
+    return ::GetSystemMetricsForDpi(SM_CXSMICON, dpi);
+}
 
-    ICONINFO info{};
-    if (!::GetIconInfo(hIcon, &info)) return nullptr;
+// Application a window is grouped under: its AUMID, else its executable.
+// Empty when neither is known; such a window keeps an icon of its own.
+static std::wstring AppKey(const IconSource& source)
+{
+    if (!source.aumid.empty()) return L"aumid:" + source.aumid;
+    if (source.exePath.empty()) return std::wstring();
+    std::wstring key = L"exe:" + source.exePath;
+    ::CharLowerBuffW(&key[0], static_cast<DWORD>(key.size()));
+    return key;
+}
 
-    auto cleanup = [&]() {
-        if (info.hbmColor) ::DeleteObject(info.hbmColor);
-        if (info.hbmMask) ::DeleteObject(info.hbmMask);
-        };
+// The entry's icon is on screen in the notification area, alone or for its group
+static bool InTray(const TrayIconDetails& details)
+{
+    return details.shellIcon || details.grouped;
+}
 
-    if (!info.hbmColor) {
-        cleanup();
-        return nullptr;
-    }
+// What the icon cascade needs of an entry that is already in the registry
+static WindowCapture IconCapture(const TrayIcon& ti)
+{
+    WindowCapture capture;
+    capture.hwnd = ti.targetWindow;
+    capture.isUwp = ti.isUwp;
+    if (ti.details) capture.icon = ti.details->iconSource;
+    return capture;
+}
 
-    BITMAP bm;
-    if (::GetObject(info.hbmColor, sizeof(bm), &bm) == 0 || bm.bmBitsPixel != 32) {
-        cleanup();
-        return nullptr;
-    }
+TrayManager::TrayManager(HWND mainWindow, ShowCollectionCallback showCollectionCb)
+    : mainWindow(mainWindow),
+    iconWorker_(mainWindow, WM_ICON_READY, icons_, &iconCache_),
+    nextZRank_(1),
+    traySize_(TrayIconSize(mainWindow ? ::GetDpiForWindow(mainWindow) : USER_DEFAULT_SCREEN_DPI)),
+    lowMemory_(::CreateMemoryResourceNotification(LowMemoryResourceNotification)),
+    iconBudget_(3000),
+    iconEvictions_(0),
+    restoreNext_(0),
+    restorePosted_(false),
+    restoreStart_(0),
+    collectionModeActive_(false),
+    showCollectionCallback_(showCollectionCb),
+    groupByApp_(false),
+    nextGroupId_(kFirstGroupId) {
+    iconCache_.Load(IconCache::DefaultPath());
+}
 
-    std::vector<DWORD> pixels(bm.bmWidth * bm.bmHeight);
-    {
-        Bitmap srcBitmap(info.hbmColor, nullptr);
-        if (srcBitmap.GetLastStatus() != Ok) {
-            cleanup();
-            return nullptr;
-        }
-        Rect rect(0, 0, bm.bmWidth, bm.bmHeight);
-        BitmapData data;
-        if (srcBitmap.LockBits(&rect, ImageLockModeRead, PixelFormat32bppARGB, &data) != Ok) {
-            cleanup();
-            return nullptr;
-        }
-        memcpy(pixels.data(), data.Scan0, pixels.size() * sizeof(DWORD));
-        srcBitmap.UnlockBits(&data);
-    }
-
-    DWORD bgColor = pixels[0];
-    if ((bgColor >> 24) != 0) { // If not transparent, flood-fill from corners
-        std::queue<POINT> q;
-        auto AddSeed = [&](int x, int y) {
-            if (x >= 0 && x < bm.bmWidth && y >= 0 && y < bm.bmHeight) {
-                DWORD& pixel = pixels[y * bm.bmWidth + x];
-                if (pixel == bgColor) {
-                    q.push({ x, y });
-                    pixel = 0; // Make transparent
-                }
-            }
-            };
-        AddSeed(0, 0); AddSeed(bm.bmWidth - 1, 0);
-        AddSeed(0, bm.bmHeight - 1); AddSeed(bm.bmWidth - 1, bm.bmHeight - 1);
-        while (!q.empty()) {
-            POINT p = q.front(); q.pop();
-            AddSeed(p.x + 1, p.y); AddSeed(p.x - 1, p.y);
-            AddSeed(p.x, p.y + 1); AddSeed(p.x, p.y - 1);
+TrayManager::~TrayManager()
+{
+    // Stop the worker first: whatever it is resolving bails out at its next
+    // check, and results it already posted are freed here rather than leaked
+    for (auto& pending : pendingIcons_) *pending.second = true;
+    pendingIcons_.clear();
+    iconWorker_.Stop();
+    if (mainWindow) {
+        MSG msg;
+        while (::PeekMessageW(&msg, mainWindow, WM_ICON_READY, WM_ICON_READY, PM_REMOVE)) {
+            IconPipeline::Worker::Discard(msg.lParam);
         }
     }
 
-    ContentBounds bounds;
-    for (int y = 0; y < bm.bmHeight; y++) {
-        for (int x = 0; x < bm.bmWidth; x++) {
-            if ((pixels[y * bm.bmWidth + x] >> 24) > 16) {
-                bounds.addPoint(x, y);
-            }
+    RunRestore(0); // Finish an incremental restore-all that is still in flight
+    RemoveAllTrayIcons();
+    iconCache_.Save();
+    if (mainWindow) ::KillTimer(mainWindow, IDT_ICON_IDLE);
+    if (lowMemory_) ::CloseHandle(lowMemory_);
+}
+
+void TrayManager::SetCollectionMode(bool isEnabled) {
+    collectionModeActive_ = isEnabled;
+}
+
+void TrayManager::SetGroupByApp(bool enabled)
+{
+    if (groupByApp_ == enabled) return;
+    groupByApp_ = enabled;
+
+    // Entries with a tray icon, in hide order so groups list them that way
+    std::vector<std::pair<unsigned, UINT>> shown;
+    for (auto& r : trayIcons) {
+        TrayIconDetails* details = r.entry.details.get();
+        if (!details || !InTray(*details)) continue;
+        shown.emplace_back(r.entry.zRank, r.id);
+        if (details->shellIcon) {
+            ::Shell_NotifyIconW(NIM_DELETE, details->shellIcon.get());
+            details->shellIcon.reset();
         }
     }
+    RemoveAllGroups();
+    std::sort(shown.begin(), shown.end());
 
-    if (bounds.isEmpty) {
-        cleanup();
-        outOwnsNewIcon = true;
-        return CopyIcon(hIcon); // Return a copy as we own it
+    for (const auto& s : shown) {
+        if (TrayIcon* ti = trayIcons.Find(s.second)) (void)ShowInTray(s.second, *ti);
     }
+}
 
-    int contentWidth = bounds.width();
-    int contentHeight = bounds.height();
-    int minDistance = bounds.getMinDistanceToEdge(bm.bmWidth, bm.bmHeight);
-
-    double scale = std::min((double)bm.bmWidth / contentWidth, (double)bm.bmHeight / contentHeight);
-    scale = std::min(scale, 3.0); // Limit max scale
-    scale = std::max(scale, 1.0); // Don't shrink
-    if (minDistance < 4) {
-        scale = std::min(scale, 1.2); // Limit scale if content is already near edge
-    }
+void TrayManager::SetIconChangedCallback(IconChangedCallback cb) {
+    iconChangedCallback_ = std::move(cb);
+}
 
-    HICON hNewIcon = nullptr;
-    if (scale > 1.01) {
-        Bitmap finalBitmap(bm.bmWidth, bm.bmHeight, PixelFormat32bppARGB);
-        Graphics g(&finalBitmap);
-        g.SetInterpolationMode(InterpolationModeHighQualityBicubic);
+bool TrayManager::AddWindowToTray(const WindowCapture& capture, HideMode hideMode, bool createIndividualIcon)
+{
+    HWND hwnd = capture.hwnd;
+    if (!capture.valid || !IsWindow(hwnd)) return false;
+    if (IsWindowInTray(hwnd)) return false;
 
-        // Create a temporary bitmap containing only the icon content
-        Bitmap contentBitmap(contentWidth, contentHeight, bm.bmWidth * 4, PixelFormat32bppARGB,
-            (BYTE*)pixels.data() + (bounds.top * bm.bmWidth + bounds.left) * 4);
+    // Hidden again before a sliced restore-all got to show it
+    DropQueuedRestore(hwnd);
 
-        int newContentWidth = (int)(contentWidth * scale);
-        int newContentHeight = (int)(contentHeight * scale);
-        int offsetX = (bm.bmWidth - newContentWidth) / 2;
-        int offsetY = (bm.bmHeight - newContentHeight) / 2;
+    TrayIcon ti{};
+    ti.targetWindow = hwnd;
+    ti.details = std::make_unique<TrayIconDetails>();
+    ti.details->windowTitle = !capture.title.empty() ? capture.title : I18N::S("untitled_window");
+    ti.details->appKey = AppKey(capture.icon);
+    // Kept for every entry: an evicted icon is resolved from it again
+    ti.details->iconSource = capture.icon;
+    bool iconFinal = false;
+    // Collection mode shows nothing of the entry yet, so it gets no icon until then
+    if (createIndividualIcon) ti.icon = AcquirePlaceholderIcon(capture, iconFinal);
+    ti.wasMaximized = capture.wasMaximized;
+    ti.originalDesktop = capture.desktop;
+    ti.isUwp = capture.isUwp;
+    ti.hideMode = hideMode;
+    ti.zRank = nextZRank_++;
+
+    const IconStore::Slot slot = ti.icon;
+    const UINT id = trayIcons.Insert(std::move(ti));
+    if (id == 0) {
+        icons_.Release(slot);
+        return false;
+    }
 
-        g.DrawImage(&contentBitmap, offsetX, offsetY, newContentWidth, newContentHeight);
-        finalBitmap.GetHICON(&hNewIcon);
+    // Collection mode never shows a per-window icon, so it never pays for one
+    if (createIndividualIcon && !ShowInTray(id, *trayIcons.Find(id))) {
+        TrayIcon removed;
+        trayIcons.Remove(id, &removed);
+        ReleaseEntry(id, removed);
+        return false;
     }
 
-    if (!hNewIcon) {
-        // If no scaling was performed or failed, create icon from (potentially modified) pixel buffer
-        Bitmap finalBitmap(bm.bmWidth, bm.bmHeight, bm.bmWidth * 4, PixelFormat32bppARGB, (BYTE*)pixels.data());
-        finalBitmap.GetHICON(&hNewIcon);
+    // The real icon is extracted and processed off the UI thread
+    if (createIndividualIcon) {
+        if (!iconFinal) RequestIcon(id, capture);
+    }
+    else {
+        // Restarted by every hide, so a burst is materialized once it is over
+        ::SetTimer(mainWindow, IDT_ICON_IDLE, kIconIdleDelayMs, nullptr);
     }
+    return true;
+}
 
-    cleanup();
+// Puts an entry in the notification area: under its application's group icon
+// when grouping, otherwise as an icon of its own
+bool TrayManager::ShowInTray(UINT id, TrayIcon& ti)
+{
+    TrayIconDetails& details = *ti.details;
+    if (groupByApp_ && !details.appKey.empty()) return JoinGroup(id, ti);
+
+    auto nid = std::make_unique<NOTIFYICONDATAW>();
+    nid->cbSize = sizeof(NOTIFYICONDATAW);
+    nid->hWnd = mainWindow;
+    nid->uID = id;
+    nid->uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
+    nid->uCallbackMessage = WM_TRAY_CALLBACK;
+    nid->hIcon = icons_.Get(ti.icon, traySize_);
+    ::wcsncpy_s(nid->szTip, details.windowTitle.c_str(), _TRUNCATE);
+
+    if (!::Shell_NotifyIconW(NIM_ADD, nid.get())) return false;
+    details.shellIcon = std::move(nid);
+    return true;
+}
 
-    if (hNewIcon) {
-        outOwnsNewIcon = true; // GDI+ GetHICON creates a new icon that we must manage
+// Cheap stand-in shown until the icon worker delivers: an icon this app
+// already has in the store, else the window's class icon, else the stock one.
+IconStore::Slot TrayManager::AcquirePlaceholderIcon(const WindowCapture& capture, bool& isFinal)
+{
+    isFinal = false;
+    if (!capture.icon.aumid.empty()) {
+        // The AUMID icon is the cascade's first choice, nothing better will come
+        const int sz = IconPipeline::kSourceSize;
+        if (IconStore::Slot shared = icons_.Acquire(IconStore::KeyForAumid(capture.icon.aumid, sz))) {
+            isFinal = true;
+            return shared;
+        }
+    }
+    if (!capture.icon.exePath.empty()) {
+        if (IconStore::Slot shared = icons_.Acquire(IconStore::KeyForExe(capture.icon.exePath, 0)))
+            return shared;
     }
-    return hNewIcon;
+    // Borrowed and keyed by handle: no pixel hash on the UI thread per hide
+    if (HICON cls = WindowMessaging::GetClassIcon(capture.hwnd))
+        return icons_.AddBorrowed(cls, IconStore::KeyForHandle(cls));
+    return icons_.AddBorrowed(::LoadIconW(nullptr, IDI_APPLICATION), L"stock:placeholder");
 }
 
-TrayManager::TrayManager(HWND mainWindow, ShowCollectionCallback showCollectionCb)
-    : mainWindow(mainWindow),
-    nextIconId(1000),
-    collectionModeActive_(false),
-    showCollectionCallback_(showCollectionCb) {
-}
+void TrayManager::RequestIcon(UINT id, const WindowCapture& capture)
+{
+    auto token = std::make_shared<std::atomic<bool>>(false);
+    if (iconWorker_.Submit(id, capture, token)) {
+        pendingIcons_[id] = std::move(token);
+        return;
+    }
 
-TrayManager::~TrayManager() { RemoveAllTrayIcons(); }
+    // No worker thread, resolve on this one
+    IconPipeline::Result result = IconPipeline::Resolve(capture, icons_, &iconCache_, *token);
+    result.entryId = id;
+    ApplyIcon(result);
+}
 
-void TrayManager::SetCollectionMode(bool isEnabled) {
-    collectionModeActive_ = isEnabled;
+void TrayManager::OnIconReady(LPARAM lParam)
+{
+    std::unique_ptr<IconPipeline::Result> result(reinterpret_cast<IconPipeline::Result*>(lParam));
+    if (!result) return;
+
+    auto it = pendingIcons_.find(result->entryId);
+    if (it == pendingIcons_.end() || *it->second) {
+        // The window was restored meanwhile
+        IconPipeline::Worker::Discard(reinterpret_cast<LPARAM>(result.release()));
+        return;
+    }
+    pendingIcons_.erase(it);
+    ApplyIcon(*result);
 }
 
-bool TrayManager::AddWindowToTray(HWND hwnd, int originalDesktop, bool createIndividualIcon)
+// Swaps the placeholder of an entry for the resolved icon
+void TrayManager::ApplyIcon(IconPipeline::Result& result)
 {
-    if (!IsWindow(hwnd)) return false;
-    if (IsWindowInTray(hwnd)) return false;
+    TrayIcon* ti = trayIcons.Find(result.entryId);
+    if (!ti) {
+        if (result.owns) IconStore::Destroy(result.images);
+        return;
+    }
 
-    TrayIcon ti{};
-    ti.targetWindow = hwnd;
-    ti.windowTitle = GetWindowTitle(hwnd);
-    ti.originalIcon = GetWindowIcon(hwnd, ti.ownsIcon);
-    ti.wasMaximized = ::IsZoomed(hwnd) ? true : false;
-    ti.originalDesktop = originalDesktop;
-    ti.isUwp = WindowManager::IsUWPApplication(hwnd);
-
-    ti.nid.cbSize = sizeof(NOTIFYICONDATA);
-    ti.nid.hWnd = mainWindow;
-    ti.nid.uID = nextIconId;
-    ti.nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
-    ti.nid.uCallbackMessage = WM_TRAY_CALLBACK;
-    ti.nid.hIcon = ti.originalIcon;
-    ::wcscpy_s(ti.nid.szTip, ti.windowTitle.c_str());
-
-    bool addedSuccessfully = true;
-    if (createIndividualIcon) {
-        addedSuccessfully = ::Shell_NotifyIconW(NIM_ADD, &ti.nid);
+    IconStore::Slot slot = icons_.Acquire(result.key);
+    if (slot) {
+        if (result.owns) IconStore::Destroy(result.images);
+    }
+    else {
+        slot = icons_.Add(std::move(result.images), result.owns, result.key);
+    }
+    // The worker found the icon shared, but its last user has released it
+    // since: resolve again, this time the worker extracts it
+    if (!slot) {
+        RequestIcon(result.entryId, IconCapture(*ti));
+        return;
     }
 
-    if (addedSuccessfully) {
-        trayIcons[nextIconId++] = ti;
-        return true;
+    icons_.Release(ti->icon);
+    ti->icon = slot;
+
+    if (ti->details->shellIcon) {
+        NOTIFYICONDATAW& nid = *ti->details->shellIcon;
+        const UINT flags = nid.uFlags;
+        nid.hIcon = icons_.Get(slot, traySize_);
+        nid.uFlags = NIF_ICON;
+        ::Shell_NotifyIconW(NIM_MODIFY, &nid);
+        nid.uFlags = flags;
+    }
+    else if (ti->details->grouped) {
+        auto group = groups_.find(ti->details->appKey);
+        if (group != groups_.end() && group->second.members.front() == result.entryId)
+            UpdateGroupIcon(group->second);
     }
 
-    if (ti.ownsIcon && ti.originalIcon) ::DestroyIcon(ti.originalIcon);
-    return false;
+    if (iconChangedCallback_) iconChangedCallback_(result.entryId);
+    EnforceIconBudget(result.entryId);
+}
+
+// Drops the shell icon and the icon slot of an entry that left the registry,
+// and cancels its icon work if that is still pending
+void TrayManager::ReleaseEntry(UINT id, TrayIcon& ti)
+{
+    auto pending = pendingIcons_.find(id);
+    if (pending != pendingIcons_.end()) {
+        *pending->second = true;
+        pendingIcons_.erase(pending);
+    }
+
+    if (ti.details && ti.details->shellIcon) {
+        ::Shell_NotifyIconW(NIM_DELETE, ti.details->shellIcon.get());
+    }
+    else if (ti.details && ti.details->grouped) {
+        LeaveGroup(id, ti.details->appKey);
+    }
+    icons_.Release(ti.icon);
+    ti.icon = IconStore::kNone;
+    ti.details.reset();
 }
 
 bool TrayManager::RestoreWindowFromTray(UINT iconId)
 {
-    auto it = trayIcons.find(iconId);
-    if (it == trayIcons.end()) return false;
+    TrayIcon ti;
+    if (!trayIcons.Remove(iconId, &ti)) return false;
 
-    HWND hwnd = it->second.targetWindow;
+    HWND hwnd = ti.targetWindow;
     if (IsWindow(hwnd)) {
-        WindowManager::ShowWindowInTaskbar(hwnd, it->second.originalDesktop);
-        ::ShowWindow(hwnd,
-            it->second.wasMaximized ? SW_SHOWMAXIMIZED : SW_RESTORE);
-        ::SetForegroundWindow(hwnd);
-    }
+        Diagnostics::ScopedLatency latency(
+            ti.hideMode == HideMode::Cloak ? L"restore.cloak" : L"restore.traditional");
 
-    if (it->second.nid.uFlags != 0) {
-        ::Shell_NotifyIconW(NIM_DELETE, &it->second.nid);
+        RestoreState state{ ti.hideMode, ti.originalDesktop, ti.wasMaximized };
+        (void)WindowManager::RestoreWindow(hwnd, state);
     }
 
-    if (it->second.ownsIcon && it->second.originalIcon)
-        ::DestroyIcon(it->second.originalIcon);
+    ReleaseEntry(iconId, ti);
+
+    // Removed once nothing is parked on it, cloaked windows included
+    WindowManager::TryRemoveHiddenDesktopIfUnused();
+
+    return true;
+}
 
-    trayIcons.erase(it);
+// Half a 60 Hz frame; the rest is left for the message loop
+static const long long kRestoreSliceMicros = 8000;
 
-    // Check if any UWP windows are left in the tray
-    bool anyUwpLeft = false;
-    for (const auto& kv : trayIcons) {
-        if (kv.second.isUwp) { anyUwpLeft = true; break; }
+void TrayManager::RestoreAllWindows(bool incremental)
+{
+    if (trayIcons.Empty() && restoreQueue_.empty()) return;
+    if (restoreQueue_.empty()) restoreStart_ = Diagnostics::NowMicros();
+
+    // One pass over the registry: drop the shell icons and queue what to restore.
+    // Groups go first, so they aren't redrawn for every member that leaves
+    RemoveAllGroups();
+    restoreQueue_.reserve(restoreQueue_.size() + trayIcons.Size());
+
+    for (auto& r : trayIcons) {
+        TrayIcon& ti = r.entry;
+        ReleaseEntry(r.id, ti);
+
+        if (IsWindow(ti.targetWindow)) {
+            restoreQueue_.push_back({ ti.targetWindow,
+                RestoreState{ ti.hideMode, ti.originalDesktop, ti.wasMaximized },
+                ti.zRank, false });
+        }
     }
-    if (!anyUwpLeft) {
-        WindowManager::TryRemoveHiddenDesktopIfUnused();
+    trayIcons.Clear();
+
+    // A slice is already scheduled, it will pick up the new entries
+    if (incremental && restorePosted_) return;
+    RunRestore(incremental ? kRestoreSliceMicros : 0);
+}
+
+void TrayManager::ContinueRestore()
+{
+    restorePosted_ = false;
+    RunRestore(kRestoreSliceMicros);
+}
+
+// Prepares queued windows until the budget (0 = none) runs out, then either
+// schedules the next slice or shows everything in one batch.
+void TrayManager::RunRestore(long long budgetMicros)
+{
+    if (restoreQueue_.empty()) return;
+
+    const long long start = Diagnostics::NowMicros();
+    while (restoreNext_ < restoreQueue_.size()) {
+        PendingRestore& p = restoreQueue_[restoreNext_++];
+        p.prepared = WindowManager::PrepareRestore(p.hwnd, p.state);
+
+        if (budgetMicros > 0 && restoreNext_ < restoreQueue_.size() &&
+            Diagnostics::NowMicros() - start >= budgetMicros) {
+            restorePosted_ = ::PostMessageW(mainWindow, WM_RESTORE_CONTINUE, 0, 0) != FALSE;
+            if (restorePosted_) return;
+        }
     }
 
-    return true;
+    FinishRestore();
 }
 
-void TrayManager::RestoreAllWindows()
+void TrayManager::DropQueuedRestore(HWND hwnd)
 {
-    auto copy = trayIcons;
-    for (auto& p : copy) RestoreWindowFromTray(p.first);
+    for (size_t i = 0; i < restoreQueue_.size(); ++i) {
+        if (restoreQueue_[i].hwnd != hwnd) continue;
+        restoreQueue_.erase(restoreQueue_.begin() + i);
+        if (i < restoreNext_) --restoreNext_;
+        if (restoreQueue_.empty()) restoreNext_ = 0;
+        return;
+    }
+}
+
+void TrayManager::FinishRestore()
+{
+    // Later hides were stacked higher, so they go back on top
+    std::sort(restoreQueue_.begin(), restoreQueue_.end(),
+        [](const PendingRestore& a, const PendingRestore& b) { return a.zRank > b.zRank; });
+
+    std::vector<ZOrderedWindow> order;
+    order.reserve(restoreQueue_.size());
+    for (const auto& p : restoreQueue_) {
+        if (p.prepared) order.push_back({ p.hwnd, p.state.wasMaximized });
+    }
+    WindowManager::ShowInZOrder(order);
+
+    // Hidden desktop cleanup once, after every parked window has moved back
+    WindowManager::TryRemoveHiddenDesktopIfUnused();
+
+    Diagnostics::RecordLatency(L"restore.all", Diagnostics::NowMicros() - restoreStart_);
+    restoreQueue_.clear();
+    restoreNext_ = 0;
 }
 
 void TrayManager::RemoveAllTrayIcons()
 {
-    for (auto& p : trayIcons) {
-        if (p.second.nid.uFlags != 0) {
-            ::Shell_NotifyIconW(NIM_DELETE, &p.second.nid);
-        }
-        if (p.second.ownsIcon && p.second.originalIcon)
-            ::DestroyIcon(p.second.originalIcon);
+    RemoveAllGroups();
+    for (auto& r : trayIcons) {
+        ReleaseEntry(r.id, r.entry);
     }
-    trayIcons.clear();
+    trayIcons.Clear();
 }
 
 bool TrayManager::HandleTrayMessage(WPARAM wParam, LPARAM lParam)
 {
+    // Click-to-visible starts when the tray message arrives, on the same
+    // clock as everything after it
+    const long long arrived = Diagnostics::NowMicros();
     UINT id = static_cast<UINT>(wParam);
     UINT msg = LOWORD(lParam);
 
@@ -321,7 +469,22 @@ bool TrayManager::HandleTrayMessage(WPARAM wParam, LPARAM lParam)
         }
         else {
             if (id != 1) { // Ignore clicks on the main app icon
-                return RestoreWindowFromTray(id);
+                if (TrayGroup* group = FindGroup(id)) {
+                    // Several windows: let the user pick; one: restore it right away
+                    if (group->members.size() > 1) {
+                        POINT pt;
+                        ::GetCursorPos(&pt);
+                        ShowGroupMenu(id, pt);
+                        return true;
+                    }
+                    id = group->members.front();
+                }
+                // The window is shown by the time the restore returns
+                const bool restored = RestoreWindowFromTray(id);
+                if (restored) {
+                    Diagnostics::RecordLatency(L"restore.click_to_visible", Diagnostics::NowMicros() - arrived);
+                }
+                return restored;
             }
         }
     }
@@ -336,142 +499,333 @@ bool TrayManager::HandleTrayMessage(WPARAM wParam, LPARAM lParam)
 
 bool TrayManager::IsWindowInTray(HWND hwnd) const
 {
-    for (const auto& kv : trayIcons) {
-        if (kv.second.targetWindow == hwnd) return true;
-    }
-    return false;
+    return trayIcons.Contains(hwnd);
 }
 
-const std::map<UINT, TrayIcon>& TrayManager::GetTrayIcons() const
+const TrayIconRegistry& TrayManager::GetTrayIcons() const
 {
     return trayIcons;
 }
 
-// --- OPTIMIZED: Fixed HICON resource leaks ---
-HICON TrayManager::GetWindowIcon(HWND hwnd, bool& owns)
+bool TrayManager::HasPendingIcons() const
 {
-    owns = false;
-    HICON originalIcon = nullptr;
-    bool originalOwns = false;
+    return !pendingIcons_.empty();
+}
 
-    // --- Helper lambda to process and clean up icons ---
-    auto processIcon = [&](HICON hIn, bool inOwns) -> HICON {
-        bool processedOwns = false;
-        HICON hProcessed = RemoveIconBackground_FloodFillAndScale(hIn, processedOwns);
+HICON TrayManager::GetIcon(const TrayIcon& ti, int size) const
+{
+    return icons_.Get(ti.icon, size);
+}
 
-        if (hProcessed) {
-            if (inOwns) {
-                ::DestroyIcon(hIn); // Destroy original if we owned it
-            }
-            owns = processedOwns; // We now own the new processed icon
-            return hProcessed;
-        }
+void TrayManager::MaterializeIcons()
+{
+    for (auto& r : trayIcons) MaterializeIcon(r.id, r.entry);
+}
 
-        // Processing failed, return original
-        owns = inOwns;
-        return hIn;
-        };
-
-    // 1. UWP icon retrieval
-    int sz = ::GetSystemMetrics(SM_CXICON);
-    if (UwpIconUtils::GetUwpWindowIcon(hwnd, sz, originalIcon, originalOwns) && originalIcon)
-    {
-        return processIcon(originalIcon, originalOwns);
-    }
-
-    // 2. Traditional Win32 icon retrieval
-    originalIcon = (HICON)::SendMessage(hwnd, WM_GETICON, ICON_SMALL2, 0);
-    if (!originalIcon) originalIcon = (HICON)::SendMessage(hwnd, WM_GETICON, ICON_SMALL, 0);
-    if (!originalIcon) originalIcon = (HICON)::SendMessage(hwnd, WM_GETICON, ICON_BIG, 0);
-    if (!originalIcon) originalIcon = (HICON)::GetClassLongPtr(hwnd, GCLP_HICONSM);
-    if (!originalIcon) originalIcon = (HICON)::GetClassLongPtr(hwnd, GCLP_HICON);
-    if (originalIcon)
-    {
-        // We don't own icons from SendMessage/GetClassLongPtr
-        return processIcon(originalIcon, false);
-    }
-
-    // 3. Shell properties (modern apps)
-    IPropertyStore* store = nullptr;
-    if (SUCCEEDED(::SHGetPropertyStoreForWindow(hwnd, IID_PPV_ARGS(&store))))
-    {
-        PROPVARIANT var; PropVariantInit(&var);
-        if (SUCCEEDED(store->GetValue(PKEY_AppUserModel_RelaunchIconResource, &var)) &&
-            var.vt == VT_LPWSTR && var.pwszVal && *var.pwszVal)
-        {
-            wchar_t resolved[MAX_PATH]{};
-            if (SUCCEEDED(::SHLoadIndirectString(var.pwszVal, resolved, ARRAYSIZE(resolved), nullptr)) &&
-                ::PathFileExistsW(resolved))
-            {
-                int iconSize = ::GetSystemMetrics(SM_CXSMICON);
-                originalIcon = LoadPngAsIcon(resolved, iconSize);
-                if (originalIcon) {
-                    // LoadPngAsIcon creates an icon we must destroy.
-                    originalOwns = true;
-                }
-            }
-        }
-        PropVariantClear(&var);
-        store->Release();
-        if (originalIcon) {
-            return processIcon(originalIcon, originalOwns);
-        }
+void TrayManager::MaterializeIcon(UINT id, TrayIcon& ti)
+{
+    if (ti.icon != IconStore::kNone || !ti.details || pendingIcons_.count(id)) return;
+
+    const WindowCapture capture = IconCapture(ti);
+    bool iconFinal = false;
+    ti.icon = AcquirePlaceholderIcon(capture, iconFinal);
+    if (!iconFinal) RequestIcon(id, capture);
+}
+
+// Whether nothing in the notification area shows an entry's icon: it has no
+// tray icon of its own and isn't the member its group is drawn from
+bool TrayManager::CanEvictIcon(UINT id, const TrayIcon& ti) const
+{
+    if (!ti.details || ti.icon == IconStore::kNone || ti.details->shellIcon) return false;
+    if (!ti.details->grouped) return true;
+    auto group = groups_.find(ti.details->appKey);
+    return group == groups_.end() || group->second.members.front() != id;
+}
+
+// Sends an entry without a tray icon back to its icon source
+void TrayManager::EvictIcon(UINT id, TrayIcon& ti)
+{
+    auto pending = pendingIcons_.find(id);
+    if (pending != pendingIcons_.end()) {
+        *pending->second = true;
+        pendingIcons_.erase(pending);
     }
+    icons_.Release(ti.icon);
+    ti.icon = IconStore::kNone;
+}
 
-    // 4. Fallback: extract from the host executable
-    DWORD pid = 0; ::GetWindowThreadProcessId(hwnd, &pid);
-    if (pid)
-    {
-        HANDLE hProc = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-        if (hProc)
-        {
-            wchar_t exe[MAX_PATH]{}; DWORD len = ARRAYSIZE(exe);
-            if (::QueryFullProcessImageNameW(hProc, 0, exe, &len))
-            {
-                UINT extracted = ::ExtractIconExW(exe, 0, nullptr, &originalIcon, 1);
-                if (extracted > 0 && originalIcon && originalIcon != (HICON)1)
-                {
-                    // ExtractIconExW gives us an icon we must destroy.
-                    originalOwns = true;
-                }
-                else {
-                    originalIcon = nullptr;
-                }
-            }
-            ::CloseHandle(hProc);
-            if (originalIcon) {
-                return processIcon(originalIcon, originalOwns);
-            }
+void TrayManager::ReleaseLazyIcons()
+{
+    for (auto& r : trayIcons) {
+        if (CanEvictIcon(r.id, r.entry)) EvictIcon(r.id, r.entry);
+    }
+}
+
+void TrayManager::SetIconBudget(UINT handles)
+{
+    iconBudget_ = std::min(std::max(static_cast<size_t>(handles), kMinIconBudget), kMaxIconBudget);
+    EnforceIconBudget(0);
+}
+
+size_t TrayManager::IconHandles() const
+{
+    const IconStore::Stats s = icons_.GetStats();
+    return s.userObjects + s.gdiObjects;
+}
+
+// Evicts the icons nothing shows (all but `keepId`'s), least recently
+// displayed first, until the icons fit the budget again. Shared icons only go
+// with their last user.
+void TrayManager::EnforceIconBudget(UINT keepId)
+{
+    if (IconHandles() <= iconBudget_) return;
+
+    std::vector<std::pair<std::uint64_t, UINT>> candidates;
+    for (const auto& r : trayIcons) {
+        if (r.id == keepId || !CanEvictIcon(r.id, r.entry)) continue;
+        candidates.emplace_back(icons_.LastShown(r.entry.icon), r.id);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& c : candidates) {
+        if (IconHandles() <= iconBudget_) break;
+        if (TrayIcon* ti = trayIcons.Find(c.second)) {
+            EvictIcon(c.second, *ti);
+            iconEvictions_++;
         }
     }
+}
+
+void TrayManager::OnIdleTimer()
+{
+    // Background materialization only while all of it would fit the budget,
+    // so it doesn't fight the eviction
+    size_t missing = 0;
+    for (const auto& r : trayIcons) {
+        if (r.entry.icon == IconStore::kNone) missing++;
+    }
+    const size_t perIcon = 3 * (sizeof(IconPipeline::kIconSizes) / sizeof(IconPipeline::kIconSizes[0]));
+
+    BOOL low = FALSE;
+    if (lowMemory_ && ::QueryMemoryResourceNotification(lowMemory_, &low) && low) {
+        ReleaseLazyIcons();
+    }
+    else if (IconHandles() + missing * perIcon <= iconBudget_) {
+        MaterializeIcons();
+    }
+
+    // Keep checking memory only while some of the icons could be released
+    bool holding = false;
+    for (const auto& r : trayIcons) {
+        if (CanEvictIcon(r.id, r.entry)) { holding = true; break; }
+    }
+    if (holding) ::SetTimer(mainWindow, IDT_ICON_IDLE, kIconMemoryCheckMs, nullptr);
+    else ::KillTimer(mainWindow, IDT_ICON_IDLE);
+}
+
+void TrayManager::OnDpiChanged(UINT dpi)
+{
+    const int size = TrayIconSize(dpi);
+    if (size == traySize_) return;
+    traySize_ = size;
+
+    for (auto& r : trayIcons) {
+        TrayIconDetails* details = r.entry.details.get();
+        if (!details || !details->shellIcon) continue;
+
+        NOTIFYICONDATAW& nid = *details->shellIcon;
+        const UINT flags = nid.uFlags;
+        nid.hIcon = icons_.Get(r.entry.icon, traySize_);
+        nid.uFlags = NIF_ICON;
+        ::Shell_NotifyIconW(NIM_MODIFY, &nid);
+        nid.uFlags = flags;
+    }
+    for (auto& kv : groups_) {
+        UpdateGroupIcon(kv.second);
+    }
+}
+
+std::wstring TrayManager::FormatIconReport() const
+{
+    const IconStore::Stats s = icons_.GetStats();
+    const IconCache::Stats c = iconCache_.GetStats();
+    size_t lazy = 0, shellIcons = groups_.size(), evictable = 0, pinned = 0;
+    for (const auto& r : trayIcons) {
+        if (r.entry.icon == IconStore::kNone) lazy++;
+        else if (CanEvictIcon(r.id, r.entry)) evictable++;
+        else pinned++;
+        if (r.entry.details && r.entry.details->shellIcon) shellIcons++;
+    }
+    const size_t handles = s.userObjects + s.gdiObjects;
+    wchar_t buf[768];
+    swprintf_s(buf,
+        L"Hidden windows: %zu (%zu icons not materialized)\nTray icons: %zu (%zu application groups)\n"
+        L"Icons: %zu distinct (%zu handles over all sizes), %zu references\n"
+        L"Icon memory: %zu bytes held, %zu bytes saved by sharing\nPixel-identical merges: %lld\n"
+        L"Icon handles: %zu USER + %zu GDI objects, budget %zu%s, %lld evicted\n"
+        L"Icon holders: %zu evictable, %zu not evictable (shown in the tray)\n"
+        L"Icon cache: %zu entries, %zu bytes, %lld hits, %lld misses\n"
+        L"Icon kernels: %hs\n",
+        trayIcons.Size(), lazy, shellIcons, groups_.size(), s.icons, s.handles, s.references, s.bytesHeld, s.bytesSaved, s.contentHits,
+        s.userObjects, s.gdiObjects, iconBudget_, handles > iconBudget_ ? L" (over budget)" : L"", iconEvictions_,
+        evictable, pinned,
+        c.entries, c.bytes, c.hits, c.misses,
+        IconKernels::IsaName(IconKernels::ActiveIsa()));
+    return buf;
+}
 
-    // 5. Absolute fallback: generic application icon
-    SHSTOCKICONINFO sii{ sizeof(sii) };
-    if (SUCCEEDED(::SHGetStockIconInfo(SIID_APPLICATION, SHGSI_ICON | SHGSI_SMALLICON, &sii)))
-    {
-        // sii.hIcon is a copy that we must destroy.
-        return processIcon(sii.hIcon, true);
+TrayManager::TrayGroup* TrayManager::FindGroup(UINT groupId)
+{
+    for (auto& kv : groups_) {
+        if (kv.second.nid.uID == groupId) return &kv.second;
     }
+    return nullptr;
+}
 
-    // 6. Last resort: load from our own resources (we don't own this one)
-    return (HICON)::LoadImageW(
-        GetModuleHandleW(nullptr),
-        MAKEINTRESOURCE(IDI_TRAY_ICON),
-        IMAGE_ICON,
-        ::GetSystemMetrics(SM_CXSMICON),
-        ::GetSystemMetrics(SM_CYSMICON),
-        LR_DEFAULTCOLOR);
+UINT TrayManager::NextGroupId()
+{
+    for (;;) {
+        const UINT id = nextGroupId_;
+        nextGroupId_ = (nextGroupId_ + 1 < kGroupIdEnd) ? nextGroupId_ + 1 : kFirstGroupId;
+        if (!FindGroup(id)) return id;
+    }
 }
 
-std::wstring TrayManager::GetWindowTitle(HWND hwnd)
+bool TrayManager::JoinGroup(UINT id, TrayIcon& ti)
 {
-    wchar_t buf[256]{}; ::GetWindowTextW(hwnd, buf, (int)std::size(buf));
-    return *buf ? buf : I18N::S("untitled_window");
+    TrayIconDetails& details = *ti.details;
+    auto it = groups_.find(details.appKey);
+    if (it != groups_.end()) {
+        it->second.members.push_back(id);
+        UpdateGroupIcon(it->second);
+        details.grouped = true;
+        return true;
+    }
+
+    TrayGroup group{};
+    group.nid.cbSize = sizeof(NOTIFYICONDATAW);
+    group.nid.hWnd = mainWindow;
+    group.nid.uID = NextGroupId();
+    group.nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
+    group.nid.uCallbackMessage = WM_TRAY_CALLBACK;
+    group.nid.hIcon = icons_.Get(ti.icon, traySize_);
+    ::wcsncpy_s(group.nid.szTip, details.windowTitle.c_str(), _TRUNCATE);
+    if (!::Shell_NotifyIconW(NIM_ADD, &group.nid)) return false;
+
+    group.members.push_back(id);
+    groups_.emplace(details.appKey, std::move(group));
+    details.grouped = true;
+    return true;
+}
+
+void TrayManager::LeaveGroup(UINT id, const std::wstring& appKey)
+{
+    auto it = groups_.find(appKey);
+    if (it == groups_.end()) return;
+
+    TrayGroup& group = it->second;
+    group.members.erase(std::remove(group.members.begin(), group.members.end(), id), group.members.end());
+    if (!group.members.empty()) {
+        UpdateGroupIcon(group);
+        return;
+    }
+    ::Shell_NotifyIconW(NIM_DELETE, &group.nid);
+    if (group.badged) ::DestroyIcon(WTT_UNTRACK(group.badged));
+    groups_.erase(it);
+}
+
+// Shows the first member's icon, badged with the count while there are
+// several windows, and the newest window's title as the tip
+void TrayManager::UpdateGroupIcon(TrayGroup& group)
+{
+    TrayIcon* first = trayIcons.Find(group.members.front());
+    const TrayIcon* newest = trayIcons.Find(group.members.back());
+    if (!first || !newest) return;
+
+    // A member promoted to the front may have had its icon evicted
+    MaterializeIcon(group.members.front(), *first);
+
+    const int count = static_cast<int>(group.members.size());
+    HICON icon = icons_.Get(first->icon, traySize_);
+    HICON badged = (count > 1 && icon) ? IconPipeline::BadgedIcon(icon, traySize_, count) : nullptr;
+
+    std::wstring tip = newest->details ? newest->details->windowTitle : std::wstring();
+    if (count > 1) {
+        wchar_t line[64];
+        swprintf_s(line, S("tray_group_count"), count);
+        tip = tip.substr(0, ARRAYSIZE(group.nid.szTip) - 1 - wcslen(line) - 1) + L"\n" + line;
+    }
+    ::wcsncpy_s(group.nid.szTip, tip.c_str(), _TRUNCATE);
+
+    const UINT flags = group.nid.uFlags;
+    group.nid.hIcon = badged ? badged : icon;
+    group.nid.uFlags = NIF_ICON | NIF_TIP;
+    ::Shell_NotifyIconW(NIM_MODIFY, &group.nid);
+    group.nid.uFlags = flags;
+
+    // The shell has its own copy by now
+    if (group.badged) ::DestroyIcon(WTT_UNTRACK(group.badged));
+    group.badged = badged;
+}
+
+void TrayManager::RemoveAllGroups()
+{
+    for (auto& kv : groups_) {
+        TrayGroup& group = kv.second;
+        ::Shell_NotifyIconW(NIM_DELETE, &group.nid);
+        if (group.badged) ::DestroyIcon(WTT_UNTRACK(group.badged));
+        for (UINT id : group.members) {
+            TrayIcon* ti = trayIcons.Find(id);
+            if (ti && ti->details) ti->details->grouped = false;
+        }
+    }
+    groups_.clear();
+}
+
+// Lists a group's windows (oldest first) plus "restore all of them"; the
+// pick is handled here rather than as WM_COMMAND
+void TrayManager::ShowGroupMenu(UINT groupId, POINT pt)
+{
+    TrayGroup* group = FindGroup(groupId);
+    if (!group) return;
+
+    // Copies: the menu loop dispatches messages that may change the group
+    const std::vector<UINT> members = group->members;
+    std::vector<std::wstring> titles;
+    titles.reserve(members.size());
+    for (UINT id : members) {
+        const TrayIcon* ti = trayIcons.Find(id);
+        titles.push_back(ti && ti->details ? ti->details->windowTitle : std::wstring(S("untitled_window")));
+    }
+
+    HMENU m = WTT_TRACK(::CreatePopupMenu(), "HMENU");
+    if (!m) return;
+
+    const UINT ID_MENU_SEPARATOR = (UINT)-1;
+    const UINT restoreAllCmd = static_cast<UINT>(members.size()) + 1;
+    for (size_t i = 0; i < titles.size(); ++i) {
+        ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, i + 1, titles[i].c_str());
+    }
+    ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, ID_MENU_SEPARATOR, nullptr);
+    ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, restoreAllCmd, S("menu_restore_group"));
+
+    ::SetForegroundWindow(mainWindow);
+    const UINT cmd = static_cast<UINT>(::TrackPopupMenu(m, TPM_RIGHTBUTTON | TPM_RETURNCMD | TPM_NONOTIFY,
+        pt.x, pt.y, 0, mainWindow, nullptr));
+    ::DestroyMenu(WTT_UNTRACK(m));
+
+    if (cmd >= 1 && cmd <= members.size()) {
+        (void)RestoreWindowFromTray(members[cmd - 1]);
+    }
+    else if (cmd == restoreAllCmd) {
+        // Oldest first, so the newest ends up on top
+        for (UINT id : members) (void)RestoreWindowFromTray(id);
+    }
 }
 
 void TrayManager::ShowContextMenu(POINT pt)
 {
-    HMENU m = ::CreatePopupMenu();
+    HMENU m = WTT_TRACK(::CreatePopupMenu(), "HMENU");
     if (!m) return;
 
     const UINT ID_MENU_SEPARATOR = (UINT)-1;
@@ -479,14 +833,15 @@ void TrayManager::ShowContextMenu(POINT pt)
     ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, IDM_RESTORE_ALL, I18N::S("menu_restore_all"));
     ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, IDM_SETTINGS, I18N::S("menu_settings"));
     ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, ID_MENU_SEPARATOR, nullptr);
+    ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, IDM_DIAGNOSTICS, I18N::S("menu_diagnostics"));
     ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, IDM_ABOUT, I18N::S("menu_about"));
     ::AppendMenuW(m, MF_OWNERDRAW | MF_STRING, IDM_EXIT, I18N::S("menu_exit"));
 
-    if (trayIcons.empty()) {
+    if (trayIcons.Empty()) {
         ::EnableMenuItem(m, IDM_RESTORE_ALL, MF_BYCOMMAND | MF_GRAYED);
     }
 
     ::SetForegroundWindow(mainWindow);
     ::TrackPopupMenu(m, TPM_RIGHTBUTTON, pt.x, pt.y, 0, mainWindow, nullptr);
-    ::DestroyMenu(m);
+    ::DestroyMenu(WTT_UNTRACK(m));
 }
\ No newline at end of file
@@ -9,31 +9,60 @@
 
 #include <windows.h>
 #include <shellapi.h>
-#include <map>
 #include <string>
 #include <functional>
+#include <vector>
+#include <memory>
+#include "HideMode.h"
+#include "WindowCapture.h"
+#include "TrayRegistry.h"
+#include "WindowManager.h"
+#include "IconStore.h"
+#include "IconPipeline.h"
+#include "IconCache.h"
+#include <unordered_map>
 
+// Cold part of a tray entry: only read when an icon is added/removed or the
+// collection list is built.
+struct TrayIconDetails {
+    std::wstring                     windowTitle{};
+    std::unique_ptr<NOTIFYICONDATAW> shellIcon{}; // Only when an individual tray icon exists
+    IconSource                       iconSource{}; // Where the icon comes from, again after an eviction
+    std::wstring                     appKey{};     // Application the entry is grouped under (may be empty)
+    bool                             grouped{ false }; // Shown through its application's group icon
+};
+
+// Hot part of a tray entry, stored contiguously in the registry. Everything the
+// lookup, restore and z-order paths read fits in 32 bytes on x64.
 struct TrayIcon {
-    NOTIFYICONDATA nid{};
-    HWND           targetWindow{ nullptr };
-    std::wstring   windowTitle{};
-    HICON          originalIcon{ nullptr };
-    bool           wasMaximized{ false };
-    bool           ownsIcon{ false };
-    bool           isUwp{ false };
-    int            originalDesktop{ 0 };
+    HWND                             targetWindow{ nullptr };
+    std::unique_ptr<TrayIconDetails> details{};
+    unsigned                         zRank{ 0 };    // Higher was hidden later, i.e. stacked higher
+    int                              originalDesktop{ 0 };
+    IconStore::Slot                  icon{ IconStore::kNone };
+    HideMode                         hideMode{ HideMode::Traditional };
+    bool                             isUwp{ false };
+    bool                             wasMaximized{ false };
 };
 
+// Icon ids are the registry ids: generation-checked, never 0 or 1 (main icon)
+using TrayIconRegistry = TrayRegistry<TrayIcon, HWND>;
+
 class TrayManager {
 public:
     using ShowCollectionCallback = std::function<void()>;
+    using IconChangedCallback = std::function<void(UINT iconId)>;
 
     explicit TrayManager(HWND mainWindow, ShowCollectionCallback showCollectionCb);
     ~TrayManager();
 
-    [[nodiscard]] bool AddWindowToTray(HWND hwnd, int originalDesktop, bool createIndividualIcon);
+    [[nodiscard]] bool AddWindowToTray(const WindowCapture& capture, HideMode hideMode, bool createIndividualIcon);
     [[nodiscard]] bool RestoreWindowFromTray(UINT iconId);
-    void RestoreAllWindows();
+    // Restores every window in its original stacking order. When incremental,
+    // the work is sliced by a per-frame budget and continued through
+    // WM_RESTORE_CONTINUE so the UI stays responsive.
+    void RestoreAllWindows(bool incremental = false);
+    void ContinueRestore();
     void RemoveAllTrayIcons();
 
     // The central handler for all tray icon messages
@@ -41,23 +70,118 @@ public:
 
     void SetCollectionMode(bool isEnabled);
 
+    // One tray icon per application instead of one per window: the icon
+    // carries the window count and a click lists the windows to pick from.
+    // Icons already in the tray move to the new layout.
+    void SetGroupByApp(bool enabled);
+
+    // Called after an entry's placeholder icon was replaced by the real one.
+    void SetIconChangedCallback(IconChangedCallback cb);
+
+    // Applies an icon posted by the worker as WM_ICON_READY.
+    void OnIconReady(LPARAM lParam);
+
+    // The notification area moved to another DPI: show every entry at the
+    // matching stored size. Nothing is extracted again.
+    void OnDpiChanged(UINT dpi);
+
+    // Entries hidden in collection mode have no tray icon and hold only an
+    // icon source until an icon is needed, as do entries whose icon was
+    // evicted. This gives every such entry its icon: shared from the store
+    // when possible, otherwise resolved on the worker. Called when the
+    // collection window opens and when idle.
+    void MaterializeIcons();
+
+    // Drops the icons nothing in the notification area shows: entries without
+    // a tray icon and group members behind the first. They are materialized
+    // again when next needed.
+    void ReleaseLazyIcons();
+
+    // IDT_ICON_IDLE: materializes in the background, or releases the lazy
+    // icons while the system reports low memory.
+    void OnIdleTimer();
+
+    // Caps the USER + GDI objects held by icons. Over the budget, entries
+    // without a tray icon fall back to their icon source, least recently
+    // displayed first; icons on screen in the tray are never evicted.
+    void SetIconBudget(UINT handles);
+
     // Check if a window is already in the tray.
     [[nodiscard]] bool IsWindowInTray(HWND hwnd) const;
 
-    // Get a constant reference to the tray icons map.
-    const std::map<UINT, TrayIcon>& GetTrayIcons() const;
+    // Get a constant reference to the tray icon registry.
+    const TrayIconRegistry& GetTrayIcons() const;
+
+    // Icons still being resolved on the worker.
+    [[nodiscard]] bool HasPendingIcons() const;
+
+    // Icon of an entry for drawing at `size` px (may be nullptr).
+    [[nodiscard]] HICON GetIcon(const TrayIcon& ti, int size) const;
+
+    // Icon store summary for the diagnostics view.
+    [[nodiscard]] std::wstring FormatIconReport() const;
 
 private:
     HWND                     mainWindow;
-    std::map<UINT, TrayIcon> trayIcons;
-    UINT                     nextIconId;
+    TrayIconRegistry         trayIcons;
+    IconStore                icons_;
+    IconCache                iconCache_;       // Processed icons kept across runs
+    IconPipeline::Worker     iconWorker_;      // After icons_ and iconCache_: it uses both until joined
+    std::unordered_map<UINT, IconPipeline::CancelToken> pendingIcons_;
+    IconChangedCallback      iconChangedCallback_;
+    unsigned                 nextZRank_;
+    int                      traySize_;        // Small-icon size at the tray's DPI
+    HANDLE                   lowMemory_;       // Low-memory resource notification
+    size_t                   iconBudget_;      // USER + GDI objects, see SetIconBudget
+    long long                iconEvictions_;
+
+    // Restore-all in progress: windows leave the registry up front and are
+    // prepared in slices, then shown together.
+    struct PendingRestore {
+        HWND         hwnd;
+        RestoreState state;
+        unsigned     zRank;
+        bool         prepared;
+    };
+    std::vector<PendingRestore> restoreQueue_;
+    size_t                   restoreNext_;
+    bool                     restorePosted_;
+    long long                restoreStart_;
 
     bool                     collectionModeActive_;
     ShowCollectionCallback   showCollectionCallback_;
 
-    HICON        GetWindowIcon(HWND hwnd, bool& owns);
-    std::wstring GetWindowTitle(HWND hwnd);
+    // Tray icon standing for every hidden window of one application
+    struct TrayGroup {
+        NOTIFYICONDATAW      nid;
+        std::vector<UINT>    members;          // Entry ids, in hide order; the first one's icon is shown
+        HICON                badged;           // Owned: the icon with the count, while there are several
+    };
+    std::unordered_map<std::wstring, TrayGroup> groups_; // By application key
+    bool                     groupByApp_;
+    UINT                     nextGroupId_;
+
+    IconStore::Slot AcquirePlaceholderIcon(const WindowCapture& capture, bool& isFinal);
+    void         RequestIcon(UINT id, const WindowCapture& capture);
+    void         ApplyIcon(IconPipeline::Result& result);
     void         ShowContextMenu(POINT pt);
+    void         ShowGroupMenu(UINT groupId, POINT pt);
+    [[nodiscard]] bool ShowInTray(UINT id, TrayIcon& ti);
+    [[nodiscard]] bool JoinGroup(UINT id, TrayIcon& ti);
+    void         LeaveGroup(UINT id, const std::wstring& appKey);
+    void         UpdateGroupIcon(TrayGroup& group);
+    void         RemoveAllGroups();
+    TrayGroup*   FindGroup(UINT groupId);
+    UINT         NextGroupId();
+    void         RunRestore(long long budgetMicros);
+    void         DropQueuedRestore(HWND hwnd);
+    void         ReleaseEntry(UINT id, TrayIcon& ti);
+    void         MaterializeIcon(UINT id, TrayIcon& ti);
+    [[nodiscard]] bool CanEvictIcon(UINT id, const TrayIcon& ti) const;
+    void         EvictIcon(UINT id, TrayIcon& ti);
+    void         EnforceIconBudget(UINT keepId);
+    size_t       IconHandles() const;
+    void         FinishRestore();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+#ifndef TRAYREGISTRY_H
+#define TRAYREGISTRY_H
+
+// Slot-map registry for hidden windows. Platform-neutral and header-only.
+//
+// - Ids are stable and generation-checked: an id handed out for a removed
+//   entry never resolves to the entry that later reuses its slot.
+// - Entries live in one dense array, so iteration is a linear walk and
+//   removal is a swap with the last element (iteration order is not stable).
+// - A handle -> slot hash index makes "is this window in the tray" O(1).
+// - The number of UWP entries is maintained on insert/remove.
+//
+// Entry must expose `targetWindow` (of type Handle) and `isUwp` (bool); both
+// are read on insert and must not change while the entry is registered.
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+template <typename Entry, typename Handle>
+class TrayRegistry {
+public:
+    using Id = std::uint32_t;
+
+    struct Record {
+        Id    id;
+        Entry entry;
+    };
+
+    // Layout of an id: generation in the high bits, slot index in the low bits.
+    // The generation is never 0, so ids are never 0 and never collide with
+    // small reserved ids such as the main tray icon's uID (1).
+    static constexpr unsigned    kSlotBits = 20;
+    static constexpr std::uint32_t kSlotMask = (1u << kSlotBits) - 1;
+    static constexpr std::uint32_t kMaxGeneration = (1u << (32 - kSlotBits)) - 1;
+
+    // Registers an entry for its window. Returns 0 if the window is already
+    // registered or the registry is full.
+    Id Insert(Entry entry)
+    {
+        Handle handle = entry.targetWindow;
+        if (byHandle_.count(handle)) return 0;
+
+        std::uint32_t slot;
+        if (!freeSlots_.empty()) {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        else {
+            if (slots_.size() > kSlotMask) return 0;
+            slot = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back(Slot{ 1, 0 });
+        }
+
+        const Id id = MakeId(slots_[slot].generation, slot);
+        slots_[slot].dense = static_cast<std::uint32_t>(dense_.size());
+        if (entry.isUwp) ++uwpCount_;
+        dense_.push_back(Record{ id, std::move(entry) });
+        byHandle_.emplace(handle, slot);
+        return id;
+    }
+
+    // Generation-checked lookup. The pointer is invalidated by Insert/Remove.
+    Entry* Find(Id id)
+    {
+        Record* r = Resolve(id);
+        return r ? &r->entry : nullptr;
+    }
+    const Entry* Find(Id id) const
+    {
+        return const_cast<TrayRegistry*>(this)->Find(id);
+    }
+
+    // Id registered for a window, or 0.
+    Id FindByHandle(Handle handle) const
+    {
+        auto it = byHandle_.find(handle);
+        return it == byHandle_.end() ? 0 : dense_[slots_[it->second].dense].id;
+    }
+
+    bool Contains(Handle handle) const { return byHandle_.count(handle) != 0; }
+
+    // Removes an entry, optionally moving it out to the caller.
+    bool Remove(Id id, Entry* out = nullptr)
+    {
+        Record* r = Resolve(id);
+        if (!r) return false;
+
+        const std::uint32_t slot = id & kSlotMask;
+        const std::uint32_t index = slots_[slot].dense;
+
+        if (r->entry.isUwp) --uwpCount_;
+        byHandle_.erase(r->entry.targetWindow);
+        if (out) *out = std::move(r->entry);
+
+        // Swap-remove: the last record takes the freed dense position
+        if (index + 1 != dense_.size()) {
+            dense_[index] = std::move(dense_.back());
+            slots_[dense_[index].id & kSlotMask].dense = index;
+        }
+        dense_.pop_back();
+
+        Slot& s = slots_[slot];
+        s.generation = (s.generation == kMaxGeneration) ? 1 : s.generation + 1;
+        freeSlots_.push_back(slot);
+        return true;
+    }
+
+    void Clear()
+    {
+        // Bump every live slot's generation so outstanding ids go stale
+        for (const Record& r : dense_) {
+            Slot& s = slots_[r.id & kSlotMask];
+            s.generation = (s.generation == kMaxGeneration) ? 1 : s.generation + 1;
+            freeSlots_.push_back(r.id & kSlotMask);
+        }
+        dense_.clear();
+        byHandle_.clear();
+        uwpCount_ = 0;
+    }
+
+    std::size_t Size() const { return dense_.size(); }
+    bool Empty() const { return dense_.empty(); }
+    std::size_t UwpCount() const { return uwpCount_; }
+
+    void Reserve(std::size_t n)
+    {
+        dense_.reserve(n);
+        slots_.reserve(n);
+        byHandle_.reserve(n);
+    }
+
+    // Dense iteration over live records
+    typename std::vector<Record>::const_iterator begin() const { return dense_.begin(); }
+    typename std::vector<Record>::const_iterator end() const { return dense_.end(); }
+    typename std::vector<Record>::iterator begin() { return dense_.begin(); }
+    typename std::vector<Record>::iterator end() { return dense_.end(); }
+
+private:
+    struct Slot {
+        std::uint32_t generation;
+        std::uint32_t dense;      // Index into dense_ while the slot is live
+    };
+
+    static Id MakeId(std::uint32_t generation, std::uint32_t slot)
+    {
+        return (generation << kSlotBits) | slot;
+    }
+
+    Record* Resolve(Id id)
+    {
+        const std::uint32_t slot = id & kSlotMask;
+        const std::uint32_t generation = id >> kSlotBits;
+        if (generation == 0 || slot >= slots_.size()) return nullptr;
+
+        const Slot& s = slots_[slot];
+        if (s.generation != generation || s.dense >= dense_.size()) return nullptr;
+
+        Record& r = dense_[s.dense];
+        return r.id == id ? &r : nullptr;
+    }
+
+    std::vector<Record>                   dense_;
+    std::vector<Slot>                     slots_;
+    std::vector<std::uint32_t>            freeSlots_;
+    std::unordered_map<Handle, std::uint32_t> byHandle_;
+    std::size_t                           uwpCount_ = 0;
+};
+
+#endif // TRAYREGISTRY_H
@@ -1,4 +1,8 @@
 #include "UwpIconUtils.h"
+#include "Diagnostics.h"
+#include "MappedFile.h"
+#include "AppxManifest.h"
+#include "HandleAudit.h"
 #include <appmodel.h>
 #include <shlwapi.h>
 #include <shlobj.h>
@@ -15,19 +19,15 @@
 
 using std::wstring;
 
-static bool AumidFromProcess(DWORD pid, wstring& aumid)
+bool UwpIconUtils::GetAumidFromProcess(HANDLE h, wstring& aumid)
 {
-    HANDLE h = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-    if (!h) return false;
-
+    Diagnostics::CountCall(L"GetApplicationUserModelId");
     UINT32 len = 0;
     LONG rc = ::GetApplicationUserModelId(h, &len, nullptr);
-    if (rc != ERROR_INSUFFICIENT_BUFFER) {
-        ::CloseHandle(h); return false;
-    }
+    if (rc != ERROR_INSUFFICIENT_BUFFER) return false;
+
     std::vector<wchar_t> buf(len);
     rc = ::GetApplicationUserModelId(h, &len, buf.data());
-    ::CloseHandle(h);
     if (rc == ERROR_SUCCESS && len > 1) {
         aumid.assign(buf.data(), len - 1);
         return true;
@@ -35,8 +35,20 @@ static bool AumidFromProcess(DWORD pid, wstring& aumid)
     return false;
 }
 
+static bool AumidFromProcess(DWORD pid, wstring& aumid)
+{
+    Diagnostics::CountCall(L"OpenProcess");
+    HANDLE h = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!h) return false;
+
+    bool ok = UwpIconUtils::GetAumidFromProcess(h, aumid);
+    ::CloseHandle(h);
+    return ok;
+}
+
 static bool AumidFromWindow(HWND hwnd, wstring& aumid)
 {
+    Diagnostics::CountCall(L"SHGetPropertyStoreForWindow");
     IPropertyStore* store = nullptr;
     if (FAILED(::SHGetPropertyStoreForWindow(hwnd, IID_PPV_ARGS(&store))))
         return false;
@@ -84,6 +96,7 @@ static HICON IconFromAumid(const wstring& aumid, int sizePx, bool& owns)
     wchar_t moniker[MAX_PATH * 2];
     swprintf_s(moniker, L"shell:AppsFolder\\%s", aumid.c_str());
 
+    Diagnostics::CountCall(L"SHParseDisplayName");
     PIDLIST_ABSOLUTE pidl = nullptr;
     HRESULT hr = ::SHParseDisplayName(moniker, nullptr, &pidl, 0, nullptr);
     if (FAILED(hr)) {
@@ -102,14 +115,15 @@ static HICON IconFromAumid(const wstring& aumid, int sizePx, bool& owns)
     factory->Release();
 
     if (FAILED(hr) || !hbm) return nullptr;
+    WTT_TRACKED(hbm, "HBITMAP");
 
     ICONINFO ii{};
     ii.fIcon = TRUE;
     ii.hbmColor = hbm;
-    ii.hbmMask = ::CreateBitmap(sizePx, sizePx, 1, 1, nullptr);
-    HICON hIcon = ::CreateIconIndirect(&ii);
-    ::DeleteObject(ii.hbmMask);
-    ::DeleteObject(hbm);
+    ii.hbmMask = WTT_TRACK(::CreateBitmap(sizePx, sizePx, 1, 1, nullptr), "HBITMAP");
+    HICON hIcon = WTT_TRACK(::CreateIconIndirect(&ii), "HICON");
+    ::DeleteObject(WTT_UNTRACK(ii.hbmMask));
+    ::DeleteObject(WTT_UNTRACK(hbm));
 
     if (hIcon) owns = true;
     return hIcon;
@@ -140,6 +154,118 @@ bool UwpIconUtils::GetUwpWindowIcon(HWND hwnd, int sizePx,
     if (!aumid.empty())
         outIcon = IconFromAumid(aumid, sizePx, owns);
 
+    if (needUninit)
+        ::CoUninitialize();
+
+    return outIcon != nullptr;
+}
+
+bool UwpIconUtils::GetAumidFromChildWindows(HWND hwnd, wstring& aumid)
+{
+    Diagnostics::CountCall(L"EnumChildWindows");
+    EnumCtx ctx;
+    ::EnumChildWindows(hwnd, EnumChild, reinterpret_cast<LPARAM>(&ctx));
+    aumid = ctx.aumid;
+    return !aumid.empty();
+}
+
+static std::string ToUtf8(const wstring& s)
+{
+    int len = ::WideCharToMultiByte(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0, nullptr, nullptr);
+    std::string out(len > 0 ? len : 0, '\0');
+    if (len > 0) ::WideCharToMultiByte(CP_UTF8, 0, s.c_str(), (int)s.size(), &out[0], len, nullptr, nullptr);
+    return out;
+}
+
+static wstring FromUtf8(const std::string& s)
+{
+    int len = ::MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), nullptr, 0);
+    wstring out(len > 0 ? len : 0, L'\0');
+    if (len > 0) ::MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int)s.size(), &out[0], len);
+    return out;
+}
+
+// Install folder of the first package registered for a family
+static bool PackageRootForFamily(const wstring& family, wstring& root)
+{
+    Diagnostics::CountCall(L"GetPackagesByPackageFamily");
+    UINT32 count = 0, bufferLength = 0;
+    if (::GetPackagesByPackageFamily(family.c_str(), &count, nullptr, &bufferLength, nullptr)
+        != ERROR_INSUFFICIENT_BUFFER || count == 0)
+        return false;
+
+    std::vector<PWSTR> fullNames(count);
+    std::vector<wchar_t> buffer(bufferLength);
+    if (::GetPackagesByPackageFamily(family.c_str(), &count, fullNames.data(), &bufferLength, buffer.data())
+        != ERROR_SUCCESS || count == 0)
+        return false;
+
+    UINT32 len = 0;
+    if (::GetPackagePathByFullName(fullNames[0], &len, nullptr) != ERROR_INSUFFICIENT_BUFFER) return false;
+    std::vector<wchar_t> path(len);
+    if (::GetPackagePathByFullName(fullNames[0], &len, path.data()) != ERROR_SUCCESS) return false;
+    root = path.data();
+    return !root.empty();
+}
+
+bool UwpIconUtils::GetLogoPathForAumid(const wstring& aumid, int sizePx, wstring& path)
+{
+    path.clear();
+    const size_t bang = aumid.find(L'!');
+    if (bang == wstring::npos || bang == 0) return false;
+
+    wstring root;
+    if (!PackageRootForFamily(aumid.substr(0, bang), root)) return false;
+
+    MappedFile manifest;
+    if (!manifest.Open(root + L"\\AppxManifest.xml")) return false;
+
+    std::string logo;
+    if (!AppxManifest::FindSquare44x44Logo(reinterpret_cast<const char*>(manifest.data()), manifest.size(),
+        ToUtf8(aumid.substr(bang + 1)), logo))
+        return false;
+
+    // "Assets\Square44x44Logo.png" -> folder and file name
+    wstring relative = FromUtf8(logo);
+    for (wchar_t& c : relative) {
+        if (c == L'/') c = L'\\';
+    }
+    const size_t slash = relative.rfind(L'\\');
+    const wstring folder = root + L"\\" + (slash == wstring::npos ? wstring() : relative.substr(0, slash + 1));
+    const wstring file = relative.substr(slash == wstring::npos ? 0 : slash + 1);
+    const size_t dot = file.rfind(L'.');
+    if (dot == wstring::npos) return false;
+
+    // Only the qualified variants of this logo: "Square44x44Logo*.png"
+    Diagnostics::CountCall(L"FindFirstFileExW");
+    std::vector<wstring> candidates;
+    WIN32_FIND_DATAW fd;
+    const wstring pattern = folder + file.substr(0, dot) + L"*" + file.substr(dot);
+    HANDLE find = ::FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &fd, FindExSearchNameMatch,
+        nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE) return false;
+    do {
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) candidates.push_back(fd.cFileName);
+    } while (::FindNextFileW(find, &fd));
+    ::FindClose(find);
+
+    const wstring pick = AppxManifest::PickLogoVariant(file, candidates, sizePx);
+    if (pick.empty()) return false;
+    path = folder + pick;
+    return true;
+}
+
+bool UwpIconUtils::GetIconForAumid(const wstring& aumid, int sizePx,
+    HICON& outIcon, bool& owns)
+{
+    outIcon = nullptr; owns = false;
+    if (aumid.empty()) return false;
+
+    HRESULT hrInit = ::CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+    bool    needUninit = SUCCEEDED(hrInit);
+
+    outIcon = IconFromAumid(aumid, sizePx, owns);
+
     if (needUninit)
         ::CoUninitialize();
 
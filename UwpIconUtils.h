@@ -3,6 +3,7 @@
 #define UWP_ICON_UTILS_H
 
 #include <windows.h>
+#include <string>
 
 namespace UwpIconUtils
 {
@@ -10,6 +11,22 @@ namespace UwpIconUtils
     // ָߴ (sizePx)  HICON
     // owns==true ʱ÷ DestroyIcon
     bool GetUwpWindowIcon(HWND hwnd, int sizePx, HICON& outIcon, bool& owns);
+
+    // AUMID of the process behind an already opened handle
+    // (PROCESS_QUERY_LIMITED_INFORMATION is enough).
+    bool GetAumidFromProcess(HANDLE hProcess, std::wstring& aumid);
+
+    // AUMID of the first child window (from another process) that has one.
+    // This is how ApplicationFrameHost windows reveal the app they host.
+    bool GetAumidFromChildWindows(HWND hwnd, std::wstring& aumid);
+
+    // Package logo for a known AUMID at sizePx. owns==true: caller must DestroyIcon.
+    bool GetIconForAumid(const std::wstring& aumid, int sizePx, HICON& outIcon, bool& owns);
+
+    // Logo file for a packaged AUMID ("Family!AppId") found through the
+    // package's AppxManifest.xml, picking the asset variant closest to sizePx.
+    // No shell or COM involved; false for unpackaged apps or missing assets.
+    bool GetLogoPathForAumid(const std::wstring& aumid, int sizePx, std::wstring& path);
 }
 
 #endif // UWP_ICON_UTILS_H
\ No newline at end of file
@@ -432,6 +432,14 @@ int VirtualDesktopManager::GetUwpWindowCount() const
     return n;
 }
 
+bool VirtualDesktopManager::IsUwpWindowHidden(HWND hwnd) const
+{
+    ::EnterCriticalSection(const_cast<CRITICAL_SECTION*>(&countLock));
+    const bool hidden = uwpHiddenWindows.count(hwnd) != 0;
+    ::LeaveCriticalSection(const_cast<CRITICAL_SECTION*>(&countLock));
+    return hidden;
+}
+
 int VirtualDesktopManager::GetCurrentDesktopNumber()
 {
     return (dllLoaded && pGetCurrentDesktopNumber) ? pGetCurrentDesktopNumber() : -1;
@@ -34,6 +34,7 @@ public:
     void MarkUwpWindowHidden(HWND hwnd);
     void MarkUwpWindowRestored(HWND hwnd);
     int  GetUwpWindowCount() const;
+    bool IsUwpWindowHidden(HWND hwnd) const;
     bool TryRemoveHiddenDesktopIfEmpty();
 
     // Force removal of the hidden desktop on exit
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef WINDOWCAPTURE_H
+#define WINDOWCAPTURE_H
+
+#include <windows.h>
+#include <string>
+
+// Where the icon pipeline can find an icon for a window without asking the
+// window (or its process) again.
+struct IconSource {
+    std::wstring aumid;        // UWP/MSIX/PWA app id, resolves to the package logo
+    std::wstring relaunchIcon; // Resolved PKEY_AppUserModel_RelaunchIconResource file
+    std::wstring exePath;      // Host executable, used for ExtractIconEx
+};
+
+// Facts about a window gathered once per hide (WindowManager::CaptureWindow)
+// and carried through validation, hiding and tray registration.
+struct WindowCapture {
+    HWND         hwnd{ nullptr };
+    bool         valid{ false };        // Passed IsValidTargetWindow at capture time
+    bool         isUwp{ false };
+    bool         isPackaged{ false };   // Package identity or the UWP frame host; an AUMID alone doesn't count
+    bool         wasMaximized{ false };
+    DWORD        pid{ 0 };
+    int          desktop{ 0 };          // Virtual desktop the window was hidden from
+    std::wstring title;                 // Empty if the window has no title
+    IconSource   icon;
+};
+
+#endif // WINDOWCAPTURE_H
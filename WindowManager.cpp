@@ -1,6 +1,8 @@
 #include "WindowManager.h"
 #include "VirtualDesktopManager.h"
 #include "UwpIconUtils.h"
+#include "WindowMessaging.h"
+#include "Diagnostics.h"
 #include <strsafe.h>
 #include <psapi.h>
 #include <shlwapi.h>
@@ -8,13 +10,16 @@
 #include <shlobj.h>
 #include <propsys.h>
 #include <propkey.h>
+#include <dwmapi.h>
 
 #pragma comment(lib, "psapi.lib")
 #pragma comment(lib, "shlwapi.lib")
+#pragma comment(lib, "dwmapi.lib")
 
 VirtualDesktopManager* WindowManager::virtualDesktopManager = nullptr;
 ITaskbarList3* WindowManager::taskbarList = nullptr;
 bool WindowManager::useVirtualDesktop = true; // Enabled by default
+std::vector<std::wstring> WindowManager::cloakApps;
 
 bool WindowManager::Initialize()
 {
@@ -57,114 +62,94 @@ bool WindowManager::GetUseVirtualDesktop()
     return useVirtualDesktop;
 }
 
-bool WindowManager::EnsureTaskbar()
+void WindowManager::SetCloakApps(const std::wstring& appList)
 {
-    // The instance is now created during Initialize, so we just check for its existence.
-    return taskbarList != nullptr;
+    cloakApps = HideModePolicy::ParseAppList(appList);
 }
 
-bool WindowManager::IsApplicationFrameHostWindow(HWND hwnd)
+bool WindowManager::EnsureTaskbar()
 {
-    DWORD pid = 0;
-    ::GetWindowThreadProcessId(hwnd, &pid);
-    if (!pid) return false;
-
-    HANDLE hProcess = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-    if (!hProcess) return false;
-
-    wchar_t processName[MAX_PATH] = { 0 };
-    DWORD size = MAX_PATH;
-    bool isFrameHost = false;
-
-    if (::QueryFullProcessImageNameW(hProcess, 0, processName, &size))
-    {
-        wchar_t* fileName = ::PathFindFileNameW(processName);
-        isFrameHost = (::_wcsicmp(fileName, L"ApplicationFrameHost.exe") == 0);
-    }
-
-    ::CloseHandle(hProcess);
-    return isFrameHost;
+    // The instance is now created during Initialize, so we just check for its existence.
+    return taskbarList != nullptr;
 }
 
-bool WindowManager::HasValidAUMID(HWND hwnd)
+WindowCapture WindowManager::CaptureWindow(HWND hwnd, int desktop)
 {
-    // Try to get AUMID from window properties
+    WindowCapture c;
+    c.hwnd = hwnd;
+    c.desktop = desktop;
+    c.valid = IsValidTargetWindow(hwnd);
+    if (!c.valid) return c;
+
+    ::GetWindowThreadProcessId(hwnd, &c.pid);
+    c.title = WindowMessaging::GetTitle(hwnd);
+    c.wasMaximized = ::IsZoomed(hwnd) != FALSE;
+
+    // One property store read serves both the AUMID and the relaunch icon
+    Diagnostics::CountCall(L"SHGetPropertyStoreForWindow");
     IPropertyStore* store = nullptr;
-    if (FAILED(::SHGetPropertyStoreForWindow(hwnd, IID_PPV_ARGS(&store))))
-        return false;
-
-    PROPVARIANT var;
-    PropVariantInit(&var);
-    bool hasAumid = false;
-
-    if (SUCCEEDED(store->GetValue(PKEY_AppUserModel_ID, &var)) &&
-        var.vt == VT_LPWSTR && var.pwszVal && *var.pwszVal)
+    if (SUCCEEDED(::SHGetPropertyStoreForWindow(hwnd, IID_PPV_ARGS(&store))))
     {
-        hasAumid = true;
-    }
-
-    PropVariantClear(&var);
-    store->Release();
-
-    if (hasAumid) return true;
-
-    // Try to get AUMID from the process
-    DWORD pid = 0;
-    ::GetWindowThreadProcessId(hwnd, &pid);
-    if (!pid) return false;
-
-    HANDLE hProcess = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-    if (!hProcess) return false;
-
-    UINT32 length = 0;
-    LONG result = ::GetApplicationUserModelId(hProcess, &length, nullptr);
-    ::CloseHandle(hProcess);
-
-    return (result == ERROR_SUCCESS || result == ERROR_INSUFFICIENT_BUFFER);
-}
+        PROPVARIANT var; PropVariantInit(&var);
+        if (SUCCEEDED(store->GetValue(PKEY_AppUserModel_ID, &var)) &&
+            var.vt == VT_LPWSTR && var.pwszVal && *var.pwszVal)
+        {
+            c.icon.aumid = var.pwszVal;
+        }
+        PropVariantClear(&var);
 
-bool WindowManager::IsUWPApplication(HWND hwnd)
-{
-    // Method 1: Try to get UWP icon (most accurate)
-    HICON testIcon = nullptr;
-    bool owns = false;
-    if (UwpIconUtils::GetUwpWindowIcon(hwnd, 32, testIcon, owns))
-    {
-        if (testIcon && owns)
-            ::DestroyIcon(testIcon);
-        return true;
+        if (SUCCEEDED(store->GetValue(PKEY_AppUserModel_RelaunchIconResource, &var)) &&
+            var.vt == VT_LPWSTR && var.pwszVal && *var.pwszVal)
+        {
+            wchar_t resolved[MAX_PATH]{};
+            if (SUCCEEDED(::SHLoadIndirectString(var.pwszVal, resolved, ARRAYSIZE(resolved), nullptr)) &&
+                ::PathFileExistsW(resolved))
+            {
+                c.icon.relaunchIcon = resolved;
+            }
+        }
+        PropVariantClear(&var);
+        store->Release();
     }
 
-    // Method 2: Check if it's an ApplicationFrameHost process
-    if (IsApplicationFrameHostWindow(hwnd))
+    // One process handle serves the image path, the process AUMID and the package check
+    bool hasPackage = false;
+    if (c.pid)
     {
-        return true;
-    }
+        Diagnostics::CountCall(L"OpenProcess");
+        HANDLE hProcess = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, c.pid);
+        if (hProcess)
+        {
+            Diagnostics::CountCall(L"QueryFullProcessImageNameW");
+            wchar_t path[MAX_PATH] = { 0 };
+            DWORD size = MAX_PATH;
+            if (::QueryFullProcessImageNameW(hProcess, 0, path, &size))
+                c.icon.exePath.assign(path, size);
 
-    // Method 3: Check for a valid AUMID
-    if (HasValidAUMID(hwnd))
-    {
-        return true;
-    }
+            if (c.icon.aumid.empty())
+                (void)UwpIconUtils::GetAumidFromProcess(hProcess, c.icon.aumid);
 
-    // Method 4: Traditional package check (fallback)
-    DWORD pid = 0;
-    ::GetWindowThreadProcessId(hwnd, &pid);
-    if (!pid) return false;
+            Diagnostics::CountCall(L"GetPackageFullName");
+            UINT32 length = 0;
+            LONG result = ::GetPackageFullName(hProcess, &length, nullptr);
+            hasPackage = (result == ERROR_SUCCESS || result == ERROR_INSUFFICIENT_BUFFER);
 
-    HANDLE hProcess = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-    if (!hProcess) return false;
+            ::CloseHandle(hProcess);
+        }
+    }
 
-    UINT32 length = 0;
-    LONG result = ::GetPackageFullName(hProcess, &length, nullptr);
-    ::CloseHandle(hProcess);
+    const bool isFrameHost = !c.icon.exePath.empty() &&
+        ::_wcsicmp(::PathFindFileNameW(c.icon.exePath.c_str()), L"ApplicationFrameHost.exe") == 0;
 
-    if (result == ERROR_SUCCESS || result == ERROR_INSUFFICIENT_BUFFER)
-    {
-        return true;
-    }
+    // The frame host process has no identity of its own, the hosted app's child window does
+    if (c.icon.aumid.empty() && isFrameHost)
+        (void)UwpIconUtils::GetAumidFromChildWindows(hwnd, c.icon.aumid);
 
-    return false;
+    // Any app identity gets the UWP treatment; only a package or the frame host
+    // counts as packaged
+    c.isUwp = !c.icon.aumid.empty() || isFrameHost || hasPackage;
+    c.isPackaged = isFrameHost || hasPackage;
+    return c;
 }
 
 bool WindowManager::HideWindowTraditional(HWND hwnd)
@@ -189,10 +174,8 @@ bool WindowManager::HideWindowTraditional(HWND hwnd)
     return true;
 }
 
-bool WindowManager::ShowWindowTraditional(HWND hwnd)
+void WindowManager::UnhideTraditional(HWND hwnd)
 {
-    if (!::IsWindow(hwnd)) return false;
-
     // 1) Restore extended styles
     LONG_PTR exBefore = ::GetWindowLongPtrW(hwnd, GWL_EXSTYLE);
     LONG_PTR exAfter = (exBefore | WS_EX_APPWINDOW) & ~WS_EX_TOOLWINDOW;
@@ -202,16 +185,65 @@ bool WindowManager::ShowWindowTraditional(HWND hwnd)
     ::SetWindowPos(hwnd, nullptr, 0, 0, 0, 0,
         SWP_NOSIZE | SWP_NOMOVE | SWP_NOZORDER | SWP_FRAMECHANGED);
 
-    // 2) Restore the taskbar button
+    // 2) Restore the taskbar button (showing is left to the caller)
     if (EnsureTaskbar())
         taskbarList->AddTab(hwnd);
+}
 
-    // 3) Show the window
-    ::ShowWindow(hwnd, SW_RESTORE);
-    ::SetForegroundWindow(hwnd);
+bool WindowManager::HideWindowCloaked(HWND hwnd)
+{
+    if (!::IsWindow(hwnd)) return false;
+
+    // DWM refuses DWMWA_CLOAK for windows of other processes, so the cloak is
+    // the shell's: a window parked on the hidden desktop stays composed and
+    // keeps its styles and show state. Without the desktop API the caller
+    // falls back to the traditional path.
+    if (!virtualDesktopManager || !virtualDesktopManager->IsAvailable() ||
+        !virtualDesktopManager->HideWindowToVirtualDesktop(hwnd))
+        return false;
+
+    // Counted with the other parked windows, so the hidden desktop is kept
+    virtualDesktopManager->MarkUwpWindowHidden(hwnd);
+
+    // The taskbar may be set to list the windows of all desktops
+    if (EnsureTaskbar())
+        taskbarList->DeleteTab(hwnd);
+
+    // SW_HIDE would have activated the next window for us, parking does not
+    if (::GetForegroundWindow() == hwnd)
+        ActivateNextWindow(hwnd);
     return true;
 }
 
+void WindowManager::UncloakWindow(HWND hwnd)
+{
+    // Back onto the desktop the user is on now, without switching desktops
+    if (virtualDesktopManager)
+    {
+        const int current = virtualDesktopManager->GetCurrentDesktopNumber();
+        (void)virtualDesktopManager->MoveWindowToDesktopNumber(hwnd, current >= 0 ? current : 0);
+        virtualDesktopManager->MarkUwpWindowRestored(hwnd);
+    }
+
+    if (EnsureTaskbar())
+        taskbarList->AddTab(hwnd);
+}
+
+void WindowManager::ActivateNextWindow(HWND hwnd)
+{
+    for (HWND next = ::GetWindow(hwnd, GW_HWNDNEXT); next; next = ::GetWindow(next, GW_HWNDNEXT))
+    {
+        if (!IsValidTargetWindow(next) || ::IsIconic(next)) continue;
+
+        BOOL cloaked = FALSE;
+        ::DwmGetWindowAttribute(next, DWMWA_CLOAKED, &cloaked, sizeof(cloaked));
+        if (cloaked) continue;
+
+        ::SetForegroundWindow(next);
+        return;
+    }
+}
+
 bool WindowManager::HideWindowVirtual(HWND hwnd)
 {
     if (!virtualDesktopManager || !virtualDesktopManager->IsAvailable())
@@ -221,70 +253,141 @@ bool WindowManager::HideWindowVirtual(HWND hwnd)
     return virtualDesktopManager->HideWindowToVirtualDesktop(hwnd);
 }
 
-bool WindowManager::ShowWindowVirtual(HWND hwnd, int originalDesktop)
+bool WindowManager::RestoreWindowVirtual(HWND hwnd, int originalDesktop)
 {
     if (!virtualDesktopManager || !virtualDesktopManager->IsAvailable())
     {
         return false;
     }
-
-    bool result = virtualDesktopManager->RestoreWindowFromVirtualDesktop(hwnd, originalDesktop);
-    if (result)
-    {
-        ::ShowWindow(hwnd, SW_RESTORE);
-        ::SetForegroundWindow(hwnd);
-    }
-    return result;
+    return virtualDesktopManager->RestoreWindowFromVirtualDesktop(hwnd, originalDesktop);
 }
 
-bool WindowManager::HideWindowFromTaskbar(HWND hwnd)
-{
-    if (!::IsWindow(hwnd))
-        return false;
+class WindowManager::WindowBackend : public HideBackend {
+public:
+    explicit WindowBackend(HWND hwnd) : hwnd(hwnd) {}
 
-    const bool isUWP = IsUWPApplication(hwnd);
+    bool HideTraditional() override { return WindowManager::HideWindowTraditional(hwnd); }
+    void UnhideTraditional() override { WindowManager::UnhideTraditional(hwnd); }
 
-    // First, use the traditional Win32 method for all windows
-    bool okTraditional = HideWindowTraditional(hwnd);
+    bool Cloak() override { return WindowManager::HideWindowCloaked(hwnd); }
+    void Uncloak() override { WindowManager::UncloakWindow(hwnd); }
 
-    // For UWP apps, apply the virtual desktop enhancement to hide taskbar remnants
-    if (isUWP && useVirtualDesktop)
+    bool Park() override
     {
-        bool okVirtual = HideWindowVirtual(hwnd);
+        if (!WindowManager::HideWindowVirtual(hwnd))
+            return false;
+        WindowManager::virtualDesktopManager->MarkUwpWindowHidden(hwnd);
+        return true;
+    }
 
-        if (okVirtual && virtualDesktopManager)
-        {
-            virtualDesktopManager->MarkUwpWindowHidden(hwnd);
-        }
+    bool IsParked() const override
+    {
+        return WindowManager::virtualDesktopManager &&
+            WindowManager::virtualDesktopManager->IsUwpWindowHidden(hwnd);
+    }
 
-        return okTraditional || okVirtual;
+    void Unpark(int desktop) override
+    {
+        (void)WindowManager::RestoreWindowVirtual(hwnd, desktop);
+        WindowManager::virtualDesktopManager->MarkUwpWindowRestored(hwnd);
     }
 
-    return okTraditional;
+private:
+    HWND hwnd;
+};
+
+bool WindowManager::HideWindowFromTaskbar(const WindowCapture& capture, HideMode& mode)
+{
+    mode = HideMode::Traditional;
+    if (!::IsWindow(capture.hwnd))
+        return false;
+
+    // Cloaking is opt-in per executable. Packaged windows are left out because
+    // the virtual desktop enhancement manages their cloak state itself; Win32
+    // apps that merely set an AUMID (Chrome, VS Code) can be cloaked.
+    HideRequest request;
+    request.isUwp = capture.isUwp;
+    request.isPackaged = capture.isPackaged;
+    request.cloakRequested = !cloakApps.empty() &&
+        HideModePolicy::SelectForExecutable(capture.icon.exePath, cloakApps) == HideMode::Cloak;
+    request.useVirtualDesktop = useVirtualDesktop;
+
+    WindowBackend window(capture.hwnd);
+    return HideModePolicy::Hide(window, request, mode);
+}
+
+bool WindowManager::RestoreWindow(HWND hwnd, const RestoreState& state)
+{
+    if (!PrepareRestore(hwnd, state))
+        return false;
+
+    // One show + one foreground (cloaked windows never left their show state)
+    if (state.hideMode != HideMode::Cloak)
+        ::ShowWindow(hwnd, state.wasMaximized ? SW_SHOWMAXIMIZED : SW_RESTORE);
+    ::SetForegroundWindow(hwnd);
+    return true;
 }
 
-bool WindowManager::ShowWindowInTaskbar(HWND hwnd, int originalDesktop)
+bool WindowManager::PrepareRestore(HWND hwnd, const RestoreState& state)
 {
     if (!::IsWindow(hwnd))
         return false;
 
-    const bool isUWP = IsUWPApplication(hwnd);
+    WindowBackend window(hwnd);
+    HideModePolicy::PrepareRestore(window, state);
+    return true;
+}
 
-    // For UWP apps, first try to move it back from the hidden virtual desktop
-    if (isUWP && useVirtualDesktop)
+void WindowManager::ShowInZOrder(const std::vector<ZOrderedWindow>& topToBottom)
+{
+    std::vector<HWND> batch;
+    batch.reserve(topToBottom.size());
+    for (const auto& w : topToBottom)
     {
-        (void)ShowWindowVirtual(hwnd, originalDesktop);
+        if (!::IsWindow(w.hwnd)) continue;
 
-        // Just untrack, don't try to remove the hidden desktop here
-        // (to avoid popping up all UWP windows at once).
-        if (virtualDesktopManager)
+        // A hung window would stall EndDeferWindowPos, let it catch up on its own
+        if (WindowMessaging::IsHung(w.hwnd))
         {
-            virtualDesktopManager->MarkUwpWindowRestored(hwnd);
+            ::ShowWindowAsync(w.hwnd, w.wasMaximized ? SW_SHOWMAXIMIZED : SW_SHOWNOACTIVATE);
+            continue;
         }
+
+        // SWP_SHOWWINDOW keeps the current min/max state, fix it up first if needed
+        if (::IsIconic(w.hwnd) || w.wasMaximized != (::IsZoomed(w.hwnd) != FALSE))
+            ::ShowWindow(w.hwnd, w.wasMaximized ? SW_SHOWMAXIMIZED : SW_SHOWNOACTIVATE);
+
+        batch.push_back(w.hwnd);
+    }
+    if (batch.empty()) return;
+
+    // Topmost windows are chained within the topmost band, so they keep it
+    const UINT flags = SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE | SWP_SHOWWINDOW;
+    auto insertAfter = [](HWND h, HWND& prevTopmost, HWND& prevNormal) {
+        const bool topmost = (::GetWindowLongPtrW(h, GWL_EXSTYLE) & WS_EX_TOPMOST) != 0;
+        HWND& prev = topmost ? prevTopmost : prevNormal;
+        HWND after = prev ? prev : (topmost ? HWND_TOPMOST : HWND_TOP);
+        prev = h;
+        return after;
+    };
+
+    HWND prevTopmost = nullptr, prevNormal = nullptr;
+    HDWP hdwp = ::BeginDeferWindowPos(static_cast<int>(batch.size()));
+    for (HWND h : batch)
+    {
+        if (!hdwp) break;
+        hdwp = ::DeferWindowPos(hdwp, h, insertAfter(h, prevTopmost, prevNormal), 0, 0, 0, 0, flags);
+    }
+
+    if (!hdwp || !::EndDeferWindowPos(hdwp))
+    {
+        // The batch was abandoned (DeferWindowPos frees it on failure), go one by one
+        prevTopmost = prevNormal = nullptr;
+        for (HWND h : batch)
+            ::SetWindowPos(h, insertAfter(h, prevTopmost, prevNormal), 0, 0, 0, 0, flags);
     }
 
-    // Finally, use the traditional method to restore it to the taskbar
-    return ShowWindowTraditional(hwnd);
+    ::SetForegroundWindow(batch.front());
 }
 
 bool WindowManager::IsValidTargetWindow(HWND hwnd)
@@ -314,16 +417,18 @@ bool WindowManager::IsValidTargetWindow(HWND hwnd)
     return (rc.right - rc.left >= 100) && (rc.bottom - rc.top >= 50);
 }
 
-bool WindowManager::MinimizeToTray(HWND hwnd)
+bool WindowManager::MinimizeToTray(const WindowCapture& capture, HideMode& mode)
 {
-    if (!IsValidTargetWindow(hwnd))
+    if (!capture.valid)
         return false;
-    return HideWindowFromTaskbar(hwnd);
+    return HideWindowFromTaskbar(capture, mode);
 }
 
 void WindowManager::TryRemoveHiddenDesktopIfUnused()
 {
-    if (virtualDesktopManager && useVirtualDesktop)
+    // Cloaked windows are parked there whatever the enhancement setting is,
+    // so this only asks whether anything is still parked
+    if (virtualDesktopManager)
     {
         virtualDesktopManager->TryRemoveHiddenDesktopIfEmpty();
     }
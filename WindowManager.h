@@ -4,10 +4,20 @@
 
 #include <windows.h>
 #include <shobjidl.h>
+#include <string>
+#include <vector>
+#include "HideMode.h"
+#include "WindowCapture.h"
 
 // Forward declaration
 class VirtualDesktopManager;
 
+// One window of a bulk restore; lists of these are ordered topmost first
+struct ZOrderedWindow {
+    HWND hwnd{ nullptr };
+    bool wasMaximized{ false };
+};
+
 class WindowManager {
 public:
     // ʼ/
@@ -21,40 +31,58 @@ public:
     static void SetUseVirtualDesktop(bool enable);
     [[nodiscard]] static bool GetUseVirtualDesktop();
 
-    // Hides a window from the taskbar and Alt-Tab
-    [[nodiscard]] static bool HideWindowFromTaskbar(HWND hwnd);
+    // Set the executables (';' separated) that are hidden with DWM cloaking
+    static void SetCloakApps(const std::wstring& appList);
+
+    // Gathers everything the hide pipeline needs about a window in one pass
+    [[nodiscard]] static WindowCapture CaptureWindow(HWND hwnd, int desktop);
+
+    // Hides a window from the taskbar and Alt-Tab. `mode` receives the way it
+    // was hidden, which the restore path needs back in RestoreState.
+    [[nodiscard]] static bool HideWindowFromTaskbar(const WindowCapture& capture, HideMode& mode);
+
+    // Restores a window to the taskbar and Alt-Tab and shows it, with a single
+    // show/foreground transition. Driven only by the state recorded at hide time.
+    [[nodiscard]] static bool RestoreWindow(HWND hwnd, const RestoreState& state);
 
-    // Restores a window to the taskbar and Alt-Tab
-    [[nodiscard]] static bool ShowWindowInTaskbar(HWND hwnd, int originalDesktop = 0);
+    // Bulk restore, step 1: everything RestoreWindow does except showing and
+    // activating. Returns false if the window is gone.
+    [[nodiscard]] static bool PrepareRestore(HWND hwnd, const RestoreState& state);
+
+    // Bulk restore, step 2: shows prepared windows in one DeferWindowPos batch,
+    // stacked in the given order, then activates the topmost one.
+    static void ShowInZOrder(const std::vector<ZOrderedWindow>& topToBottom);
 
     // Checks if a window is a valid target for minimizing to tray
     [[nodiscard]] static bool IsValidTargetWindow(HWND hwnd);
 
     // Unified entry point for "Minimize to Tray"
-    [[nodiscard]] static bool MinimizeToTray(HWND hwnd);
-
-    // Checks if a window belongs to a UWP application
-    [[nodiscard]] static bool IsUWPApplication(HWND hwnd);
+    [[nodiscard]] static bool MinimizeToTray(const WindowCapture& capture, HideMode& mode);
 
     // Tries to automatically remove the hidden desktop if it's no longer in use
     static void TryRemoveHiddenDesktopIfUnused();
 
 private:
+    // HideBackend for one window, on the statics below
+    class WindowBackend;
+
     static VirtualDesktopManager* virtualDesktopManager;
     static ITaskbarList3* taskbarList;
     static bool useVirtualDesktop;
+    static std::vector<std::wstring> cloakApps;
 
     // Traditional hide/show methods (callable by both Win32 and UWP)
     [[nodiscard]] static bool HideWindowTraditional(HWND hwnd);
-    [[nodiscard]] static bool ShowWindowTraditional(HWND hwnd);
+    static void UnhideTraditional(HWND hwnd); // Styles + taskbar tab, does not show
+
+    // Cloak hide/show methods (parked on the hidden desktop, no frame re-layout)
+    [[nodiscard]] static bool HideWindowCloaked(HWND hwnd);
+    static void UncloakWindow(HWND hwnd); // Back to the current desktop + taskbar tab, does not activate
+    static void ActivateNextWindow(HWND hwnd);
 
     // Virtual desktop methods (enhancement for UWP apps)
     [[nodiscard]] static bool HideWindowVirtual(HWND hwnd);
-    [[nodiscard]] static bool ShowWindowVirtual(HWND hwnd, int originalDesktop);
-
-    // Helper functions for UWP detection
-    [[nodiscard]] static bool IsApplicationFrameHostWindow(HWND hwnd);
-    [[nodiscard]] static bool HasValidAUMID(HWND hwnd);
+    [[nodiscard]] static bool RestoreWindowVirtual(HWND hwnd, int originalDesktop);
 
     // Helper to ensure the ITaskbarList3 instance is ready
     [[nodiscard]] static bool EnsureTaskbar();
@@ -0,0 +1,62 @@
+#include "WindowMessaging.h"
+#include "Diagnostics.h"
+
+bool WindowMessaging::IsHung(HWND hwnd)
+{
+    return ::IsHungAppWindow(hwnd) != FALSE;
+}
+
+bool WindowMessaging::SendWithDeadline(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam,
+    UINT timeoutMs, DWORD_PTR* result)
+{
+    DWORD_PTR res = 0;
+    if (result) *result = 0;
+    if (!::IsWindow(hwnd) || IsHung(hwnd)) return false;
+
+    Diagnostics::CountCall(L"SendMessageTimeoutW");
+    if (!::SendMessageTimeoutW(hwnd, msg, wParam, lParam,
+        SMTO_ABORTIFHUNG | SMTO_BLOCK, timeoutMs, &res))
+        return false;
+
+    if (result) *result = res;
+    return true;
+}
+
+std::wstring WindowMessaging::GetTitle(HWND hwnd)
+{
+    Diagnostics::CountCall(L"InternalGetWindowText");
+    wchar_t buf[256]{};
+    int len = ::InternalGetWindowText(hwnd, buf, (int)std::size(buf));
+    return std::wstring(buf, len > 0 ? len : 0);
+}
+
+HICON WindowMessaging::GetClassIcon(HWND hwnd, bool large)
+{
+    HICON icon = (HICON)::GetClassLongPtrW(hwnd, large ? GCLP_HICON : GCLP_HICONSM);
+    if (!icon) icon = (HICON)::GetClassLongPtrW(hwnd, large ? GCLP_HICONSM : GCLP_HICON);
+    return icon;
+}
+
+HICON WindowMessaging::GetIcon(HWND hwnd, bool large, UINT timeoutMs)
+{
+    if (!::IsWindow(hwnd)) return nullptr;
+
+    if (!IsHung(hwnd)) {
+        const ULONGLONG deadline = ::GetTickCount64() + timeoutMs;
+        const WPARAM smallFirst[] = { ICON_SMALL2, ICON_SMALL, ICON_BIG };
+        const WPARAM largeFirst[] = { ICON_BIG, ICON_SMALL2, ICON_SMALL };
+        const WPARAM* kinds = large ? largeFirst : smallFirst;
+        for (int i = 0; i < 3; ++i) {
+            const WPARAM kind = kinds[i];
+            ULONGLONG now = ::GetTickCount64();
+            if (now >= deadline) break;
+
+            DWORD_PTR res = 0;
+            if (!SendWithDeadline(hwnd, WM_GETICON, kind, 0, (UINT)(deadline - now), &res))
+                break; // Not responding, don't spend the rest of the budget on it
+            if (res) return (HICON)res;
+        }
+    }
+
+    return GetClassIcon(hwnd, large);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef WINDOWMESSAGING_H
+#define WINDOWMESSAGING_H
+
+#include <windows.h>
+#include <string>
+
+// Cross-process window queries that can never block the UI thread on a
+// hung target. Everything that talks to foreign windows goes through here.
+namespace WindowMessaging
+{
+    // Default budget for a metadata query against another process.
+    constexpr UINT kDefaultTimeoutMs = 100;
+
+    // True if the window's thread has stopped pumping messages.
+    [[nodiscard]] bool IsHung(HWND hwnd);
+
+    // SendMessageTimeoutW with SMTO_ABORTIFHUNG. Returns false if the window
+    // is hung, the deadline expired or the window is gone.
+    [[nodiscard]] bool SendWithDeadline(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam,
+        UINT timeoutMs, DWORD_PTR* result);
+
+    // Window title read from the window manager's copy (InternalGetWindowText),
+    // so no WM_GETTEXT is sent to the target. Empty if the window has none.
+    [[nodiscard]] std::wstring GetTitle(HWND hwnd);
+
+    // Icon registered with the window class, small one first unless `large`.
+    // Never sends a message.
+    [[nodiscard]] HICON GetClassIcon(HWND hwnd, bool large = false);
+
+    // WM_GETICON cascade (ICON_SMALL2, ICON_SMALL, ICON_BIG; ICON_BIG first when
+    // `large`) under one shared deadline, then the class icons. A hung or
+    // unresponsive window skips straight to the class icons. The returned icon
+    // is not owned by the caller.
+    [[nodiscard]] HICON GetIcon(HWND hwnd, bool large = false, UINT timeoutMs = kDefaultTimeoutMs);
+}
+
+#endif // WINDOWMESSAGING_H
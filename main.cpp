@@ -6,6 +6,7 @@
 #include <shellapi.h>
 #include <vector>
 #include <algorithm>
+#include <cstdio>
 #include <dwmapi.h>
 #include <gdiplus.h>
 #include "GlobalHook.h"
@@ -17,6 +18,8 @@
 #include "SettingsDialog.h"
 #include "Strings.h"
 #include "CollectionWindow.h" 
+#include "Diagnostics.h"
+#include "HandleAudit.h"
 
 #pragma comment(lib, "Comctl32.lib")
 #pragma comment(lib, "dwmapi.lib")
@@ -131,6 +134,12 @@ public:
 
     [[nodiscard]] bool Initialize(HINSTANCE hInstance);
     int Run();
+#ifdef WTT_HANDLE_AUDIT
+    // Hides and restores a window of our own `cycles` times and fails (exit
+    // code 2) if the process's GDI or USER objects grew; the report lists the
+    // creation sites of what is still live. See HandleAudit.h.
+    int RunSoak(int cycles);
+#endif
 
 private:
     static LRESULT CALLBACK WindowProc(HWND, UINT, WPARAM, LPARAM);
@@ -146,8 +155,10 @@ private:
     void UnregisterHotkeys();
     void OnHotkey(WPARAM hotkeyId);
     void MinimizeTopWindow();
+    void HideToTray(HWND hwnd, int desktop);
     void HideAllVisibleWindows();
     void DisableCollectionModeAndSave();
+    void ShowDiagnostics();
 
     // --- NEW: Owner-drawn menu helpers ---
     void OnMeasureMenuItem(HWND hwnd, LPMEASUREITEMSTRUCT lpmis);
@@ -156,6 +167,10 @@ private:
     void DrawMenuItemSeparator(Graphics& g, LPDRAWITEMSTRUCT lpdis, UINT dpi);
     void DrawMenuItemText(Graphics& g, LPDRAWITEMSTRUCT lpdis);
 
+#ifdef WTT_HANDLE_AUDIT
+    [[nodiscard]] bool SoakCycle(HWND target, int cycle);
+    [[nodiscard]] bool PumpUntilIconsSettle();
+#endif
 
     static WindowToTrayApp* instance;
     HINSTANCE               hInstance;
@@ -212,7 +227,7 @@ WindowToTrayApp::~WindowToTrayApp()
     instance = nullptr;
 
     if (hMenuFont_) {
-        ::DeleteObject(hMenuFont_);
+        ::DeleteObject(WTT_UNTRACK(hMenuFont_));
     }
 
     ::CoUninitialize();
@@ -266,6 +281,7 @@ bool WindowToTrayApp::Initialize(HINSTANCE hInst)
             [this] { this->DisableCollectionModeAndSave(); }
         );
         });
+    trayManager->SetIconChangedCallback(&CollectionWindow::NotifyIconChanged);
 
     mouseHook = new GlobalHook();
     mouseHook->SetMouseCallback(
@@ -325,9 +341,12 @@ void WindowToTrayApp::ApplySettingsToRuntime()
 {
     I18N::SetLanguage(settings.language);
     WindowManager::SetUseVirtualDesktop(settings.useVirtualDesktop);
+    WindowManager::SetCloakApps(settings.cloakApps);
 
     if (trayManager) {
         trayManager->SetCollectionMode(settings.useCollectionMode);
+        trayManager->SetIconBudget(settings.iconHandleBudget);
+        trayManager->SetGroupByApp(settings.groupTrayIcons);
     }
 
     if (mainTrayIconCreated) {
@@ -393,8 +412,18 @@ void WindowToTrayApp::MinimizeTopWindow()
     if (virtualDesktopManager && virtualDesktopManager->IsAvailable())
         currentDesktop = virtualDesktopManager->GetCurrentDesktopNumber();
 
-    if (WindowManager::MinimizeToTray(tgt))
-        trayManager->AddWindowToTray(tgt, currentDesktop, !settings.useCollectionMode);
+    HideToTray(tgt, currentDesktop);
+}
+
+void WindowToTrayApp::HideToTray(HWND hwnd, int desktop)
+{
+    Diagnostics::ScopedCallCount calls(L"hide");
+
+    // Captured once, then validated, hidden and registered from the same record
+    WindowCapture capture = WindowManager::CaptureWindow(hwnd, desktop);
+    HideMode mode = HideMode::Traditional;
+    if (WindowManager::MinimizeToTray(capture, mode))
+        (void)trayManager->AddWindowToTray(capture, mode, !settings.useCollectionMode);
 }
 
 void WindowToTrayApp::HideAllVisibleWindows()
@@ -431,13 +460,12 @@ void WindowToTrayApp::HideAllVisibleWindows()
         return TRUE;
         }, reinterpret_cast<LPARAM>(&ctx));
 
-    for (HWND h : *ctx.list) {
-        if (!::IsWindow(h)) continue;
-        if (!WindowManager::IsValidTargetWindow(h)) continue;
-        if (WindowManager::MinimizeToTray(h)) {
-            int originalDesktop = (currentDesktop >= 0) ? currentDesktop : 0;
-            trayManager->AddWindowToTray(h, originalDesktop, !settings.useCollectionMode);
-        }
+    // EnumWindows lists top to bottom; hide bottom-up so the topmost window gets
+    // the latest z-rank and restore-all stacks them back the same way
+    int originalDesktop = (currentDesktop >= 0) ? currentDesktop : 0;
+    for (auto it = ctx.list->rbegin(); it != ctx.list->rend(); ++it) {
+        if (!::IsWindow(*it)) continue;
+        HideToTray(*it, originalDesktop);
     }
 
     delete ctx.list;
@@ -449,11 +477,28 @@ void WindowToTrayApp::DisableCollectionModeAndSave()
         settings.useCollectionMode = false;
         settingsMgr.Set(settings);
         settingsMgr.Save();
-        trayManager->RestoreAllWindows();
+        trayManager->RestoreAllWindows(true);
         ApplySettingsToRuntime();
     }
 }
 
+void WindowToTrayApp::ShowDiagnostics()
+{
+    HANDLE self = ::GetCurrentProcess();
+    wchar_t handles[128];
+    swprintf_s(handles, L"GDI objects: %lu (peak %lu)\nUSER objects: %lu (peak %lu)\n",
+        ::GetGuiResources(self, GR_GDIOBJECTS), ::GetGuiResources(self, GR_GDIOBJECTS_PEAK),
+        ::GetGuiResources(self, GR_USEROBJECTS), ::GetGuiResources(self, GR_USEROBJECTS_PEAK));
+
+    std::wstring text = handles;
+    if (trayManager) text += trayManager->FormatIconReport();
+    text += L"\n" + Diagnostics::FormatLatencyReport();
+    text += L"\n" + Diagnostics::FormatCallReport();
+    ::OutputDebugStringW((L"[WindowToTray] " + text).c_str());
+
+    ::MessageBoxW(mainWindow, text.c_str(), I18N::S("diagnostics_title"), MB_OK | MB_ICONINFORMATION);
+}
+
 void WindowToTrayApp::OnMouseHook(POINT /*pt*/, HWND targetWindow)
 {
     if (!WindowManager::IsValidTargetWindow(targetWindow)) return;
@@ -473,6 +518,119 @@ int WindowToTrayApp::Run()
     return static_cast<int>(msg.wParam);
 }
 
+#ifdef WTT_HANDLE_AUDIT
+
+// Cycles before the baseline is taken, so first-use allocations (menu font,
+// theme data, the shell's own caches) don't count as growth
+static const int kSoakWarmupCycles = 50;
+// Growth still accepted after the run; a per-cycle leak is thousands
+static const DWORD kSoakSlack = 32;
+
+// `--soak N` on the command line, else 0
+static int SoakCyclesFromCommandLine()
+{
+    int argc = 0;
+    LPWSTR* argv = ::CommandLineToArgvW(::GetCommandLineW(), &argc);
+    if (!argv) return 0;
+    int cycles = 0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (wcscmp(argv[i], L"--soak") == 0) cycles = _wtoi(argv[i + 1]);
+    }
+    ::LocalFree(argv);
+    return cycles > 0 ? cycles : 0;
+}
+
+bool WindowToTrayApp::PumpUntilIconsSettle()
+{
+    for (;;) {
+        MSG msg;
+        while (::PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) return false;
+            ::TranslateMessage(&msg);
+            ::DispatchMessageW(&msg);
+        }
+        if (!trayManager->HasPendingIcons()) return true;
+        ::MsgWaitForMultipleObjects(0, nullptr, FALSE, 100, QS_ALLINPUT);
+    }
+}
+
+// One hide/restore. Tray icons and collection-mode entries alternate, and
+// every 100th cycle opens the owner-drawn menu (closed again by a timer)
+bool WindowToTrayApp::SoakCycle(HWND target, int cycle)
+{
+    const bool individual = cycle % 2 == 0;
+    WindowCapture capture = WindowManager::CaptureWindow(target, 0);
+    HideMode mode = HideMode::Traditional;
+    if (!WindowManager::MinimizeToTray(capture, mode) || !trayManager->AddWindowToTray(capture, mode, individual))
+        return false;
+    if (!individual) trayManager->MaterializeIcons();
+    if (!PumpUntilIconsSettle()) return false;
+
+    if (cycle % 100 == 0) {
+        ::SetTimer(nullptr, 0, 50, [](HWND, UINT, UINT_PTR id, DWORD) {
+            ::KillTimer(nullptr, id);
+            ::EndMenu();
+            });
+        (void)trayManager->HandleTrayMessage(1, MAKELPARAM(WM_CONTEXTMENU, 1));
+    }
+
+    return trayManager->RestoreWindowFromTray(trayManager->GetTrayIcons().FindByHandle(target)) &&
+        PumpUntilIconsSettle();
+}
+
+int WindowToTrayApp::RunSoak(int cycles)
+{
+    // A window of our own stands in for an application
+    WNDCLASSEXW wc{ sizeof(wc) };
+    wc.lpfnWndProc = ::DefWindowProcW;
+    wc.hInstance = hInstance;
+    wc.lpszClassName = L"WindowToTraySoakTarget";
+    wc.hIcon = ::LoadIcon(hInstance, MAKEINTRESOURCE(IDI_MAIN_ICON));
+    wc.hCursor = ::LoadCursor(nullptr, IDC_ARROW);
+    ::RegisterClassExW(&wc);
+    HWND target = ::CreateWindowExW(0, wc.lpszClassName, L"Window-To-Tray soak", WS_OVERLAPPEDWINDOW,
+        CW_USEDEFAULT, CW_USEDEFAULT, 320, 200, nullptr, nullptr, hInstance, nullptr);
+    if (!target) return 2;
+    ::ShowWindow(target, SW_SHOWNORMAL);
+
+    HANDLE self = ::GetCurrentProcess();
+    DWORD gdiStart = 0, userStart = 0;
+    bool completed = true;
+    int done = 0;
+    for (int i = -kSoakWarmupCycles; i < cycles && completed; ++i) {
+        if (i == 0) {
+            gdiStart = ::GetGuiResources(self, GR_GDIOBJECTS);
+            userStart = ::GetGuiResources(self, GR_USEROBJECTS);
+            HandleAudit::Mark();
+        }
+        completed = SoakCycle(target, i);
+        if (completed && i >= 0) done++;
+    }
+    ::DestroyWindow(target);
+
+    const DWORD gdiEnd = ::GetGuiResources(self, GR_GDIOBJECTS);
+    const DWORD userEnd = ::GetGuiResources(self, GR_USEROBJECTS);
+    const bool leaked = gdiEnd > gdiStart + kSoakSlack || userEnd > userStart + kSoakSlack;
+
+    wchar_t head[256];
+    swprintf_s(head, L"Soak: %d of %d cycles, GDI %lu -> %lu, USER %lu -> %lu: %s\n",
+        done, cycles, gdiStart, gdiEnd, userStart, userEnd,
+        !completed ? L"FAILED (cycle did not complete)" : leaked ? L"FAILED (handles grew)" : L"ok");
+    const std::wstring report = head + HandleAudit::FormatReport();
+
+    ::OutputDebugStringW(report.c_str());
+    fputws(report.c_str(), stdout);
+    FILE* file = nullptr;
+    const std::wstring path = SettingsManager::GetProgramDirectoryW() + L"\\handle_audit.txt";
+    if (_wfopen_s(&file, path.c_str(), L"w, ccs=UTF-8") == 0 && file) {
+        fputws(report.c_str(), file);
+        fclose(file);
+    }
+    return completed && !leaked ? 0 : 2;
+}
+
+#endif // WTT_HANDLE_AUDIT
+
 LRESULT CALLBACK WindowToTrayApp::WindowProc(
     HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
@@ -508,16 +666,16 @@ void WindowToTrayApp::OnMeasureMenuItem(HWND hwnd, LPMEASUREITEMSTRUCT lpmis)
 
     // Ensure menu font is created for the current DPI
     if (hMenuFont_ == nullptr || currentDpi_ != dpi) {
-        if (hMenuFont_) ::DeleteObject(hMenuFont_);
+        if (hMenuFont_) ::DeleteObject(WTT_UNTRACK(hMenuFont_));
         currentDpi_ = dpi;
         LOGFONTW lf = {};
         lf.lfHeight = -MulDiv(10, dpi, 72); // 10pt font size
         lf.lfWeight = FW_NORMAL;
         wcscpy_s(lf.lfFaceName, L"Segoe UI Variable"); // Win11 default
-        hMenuFont_ = ::CreateFontIndirectW(&lf);
+        hMenuFont_ = WTT_TRACK(::CreateFontIndirectW(&lf), "HFONT");
         if (!hMenuFont_) { // Fallback
             wcscpy_s(lf.lfFaceName, L"Segoe UI");
-            hMenuFont_ = ::CreateFontIndirectW(&lf);
+            hMenuFont_ = WTT_TRACK(::CreateFontIndirectW(&lf), "HFONT");
         }
     }
 
@@ -623,13 +781,36 @@ LRESULT WindowToTrayApp::HandleMessage(
         int currentDesktop = 0;
         if (virtualDesktopManager && virtualDesktopManager->IsAvailable())
             currentDesktop = virtualDesktopManager->GetCurrentDesktopNumber();
-        if (WindowManager::MinimizeToTray(tgt))
-            trayManager->AddWindowToTray(tgt, currentDesktop, !settings.useCollectionMode);
+        HideToTray(tgt, currentDesktop);
         return 0;
     }
     case WM_HOTKEY:
         OnHotkey(wParam);
         return 0;
+    case WM_ICON_READY:
+        if (trayManager) {
+            trayManager->OnIconReady(lParam);
+        }
+        else {
+            IconPipeline::Worker::Discard(lParam);
+        }
+        return 0;
+    case WM_RESTORE_CONTINUE:
+        if (trayManager) {
+            trayManager->ContinueRestore();
+        }
+        return 0;
+    case WM_TIMER:
+        if (wParam == IDT_ICON_IDLE && trayManager) {
+            trayManager->OnIdleTimer();
+            return 0;
+        }
+        break;
+    case WM_DPICHANGED:
+        if (trayManager) {
+            trayManager->OnDpiChanged(HIWORD(wParam));
+        }
+        return 0;
     case WM_TRAY_CALLBACK:
     {
         if (trayManager) {
@@ -662,7 +843,10 @@ LRESULT WindowToTrayApp::HandleMessage(
             ::PostQuitMessage(0);
             return 0;
         case IDM_RESTORE_ALL:
-            trayManager->RestoreAllWindows();
+            trayManager->RestoreAllWindows(true);
+            return 0;
+        case IDM_DIAGNOSTICS:
+            ShowDiagnostics();
             return 0;
         case IDM_ABOUT:
             ::MessageBox(hwnd, I18N::S("about_text"),
@@ -698,7 +882,12 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int)
         return 1;
     }
 
+#ifdef WTT_HANDLE_AUDIT
+    const int soakCycles = SoakCyclesFromCommandLine();
+    int ret = soakCycles > 0 ? app.RunSoak(soakCycles) : app.Run();
+#else
     int ret = app.Run();
+#endif
     if (mutex) ::CloseHandle(mutex);
     return ret;
 }
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "AppxManifest.h"
+#include "TestHarness.h"
+#include <cstring>
+
+namespace {
+
+    // Trimmed from a store app's AppxManifest.xml
+    const char kCalculator[] = R"(<?xml version="1.0" encoding="utf-8"?>
+<Package xmlns="http://schemas.microsoft.com/appx/manifest/foundation/windows10"
+         xmlns:uap="http://schemas.microsoft.com/appx/manifest/uap/windows10"
+         IgnorableNamespaces="uap">
+  <Identity Name="Microsoft.WindowsCalculator" Publisher="CN=Microsoft Corporation" Version="11.2210.0.0" />
+  <Properties>
+    <DisplayName>ms-resource:AppStoreName</DisplayName>
+    <Logo>Assets\CalculatorStoreLogo.png</Logo>
+  </Properties>
+  <Applications>
+    <Application Id="App" Executable="CalculatorApp.exe" EntryPoint="CalculatorApp.App">
+      <uap:VisualElements DisplayName="ms-resource:AppName" Square150x150Logo="Assets\CalculatorMedLogo.png"
+          Square44x44Logo="Assets\CalculatorAppList.png" Description="ms-resource:AppDescription"
+          BackgroundColor="transparent">
+        <uap:DefaultTile Wide310x150Logo="Assets\CalculatorWideTile.png" />
+      </uap:VisualElements>
+    </Application>
+  </Applications>
+</Package>
+)";
+
+    // An old Application left in a comment ahead of the live one, plus a
+    // CDATA section that mentions one
+    const char kCommentedOut[] = R"(<Package>
+  <Applications>
+    <!--
+    <Application Id="App" Executable="Old.exe">
+      <uap:VisualElements Square44x44Logo="Assets\Old.png" />
+    </Application>
+    -->
+    <Description><![CDATA[<Application Id="App"><uap:VisualElements Square44x44Logo="Cdata.png"/>]]></Description>
+    <Application Id="App" Executable="New.exe">
+      <uap:VisualElements Square44x44Logo="Assets\New.png" />
+    </Application>
+  </Applications>
+</Package>
+)";
+
+    // Several applications in one package; the second has no visual elements
+    const char kSeveralApps[] = R"(<Package>
+  <Applications>
+    <Application Id="Mail" Executable="HxOutlook.exe">
+      <uap:VisualElements DisplayName="Mail" Square44x44Logo="Images\MailAppList.png" />
+    </Application>
+    <Application Id="Background" Executable="HxTsr.exe">
+    </Application>
+    <Application Id="Calendar" Executable="HxCalendarAppImm.exe">
+      <uap:VisualElements DisplayName="Calendar" Square44x44Logo="Images\CalendarAppList.png" />
+    </Application>
+    <Application Id="Stub" />
+  </Applications>
+</Package>
+)";
+
+    // Single quotes, a '>' inside a value, and entities in the logo path
+    const char kQuirks[] = R"(<Package>
+  <Applications>
+    <Application Id='Tools &amp; More' Executable='tools.exe'>
+      <uap:VisualElements DisplayName='Fast > slow' Square44x44Logo = 'Assets\R&amp;D\Logo&#46;png' />
+    </Application>
+    <Application Id="Hex" Executable="hex.exe">
+      <uap:VisualElements Square44x44Logo="Assets\&#x4C;ogo.png" />
+    </Application>
+  </Applications>
+</Package>
+)";
+
+    bool Find(const char* xml, const std::string& appId, std::string& logo)
+    {
+        return AppxManifest::FindSquare44x44Logo(xml, std::strlen(xml), appId, logo);
+    }
+
+    // What a packaged app typically ships next to its Square44x44Logo
+    const std::vector<std::wstring> kAssets = {
+        L"Square44x44Logo.scale-100.png",
+        L"Square44x44Logo.scale-125.png",
+        L"Square44x44Logo.scale-150.png",
+        L"Square44x44Logo.scale-200.png",
+        L"Square44x44Logo.scale-400.png",
+        L"Square44x44Logo.targetsize-16.png",
+        L"Square44x44Logo.targetsize-16_altform-unplated.png",
+        L"Square44x44Logo.targetsize-24.png",
+        L"Square44x44Logo.targetsize-32.png",
+        L"Square44x44Logo.targetsize-32_altform-unplated.png",
+        L"Square44x44Logo.targetsize-32_altform-lightunplated.png",
+        L"Square44x44Logo.targetsize-32_contrast-white.png",
+        L"Square44x44Logo.contrast-black_scale-200.png",
+        L"Square44x44Logo.targetsize-48_altform-unplated.png",
+        L"Square44x44Logo.targetsize-256_altform-unplated.png",
+        L"Square44x44Logo.theme-light_targetsize-20.png",
+        L"Square150x150Logo.scale-100.png",
+        L"Square44x44LogoWide.scale-100.png",
+        L"Square44x44Logo.scale-100.jpg",
+    };
+
+    std::wstring Pick(const std::vector<std::wstring>& candidates, int px)
+    {
+        return AppxManifest::PickLogoVariant(L"Square44x44Logo.png", candidates, px);
+    }
+}
+
+TEST_CASE(FindsTheLogoOfAStoreManifest)
+{
+    std::string logo;
+    CHECK(Find(kCalculator, "", logo));
+    CHECK_EQ(logo, "Assets\\CalculatorAppList.png");
+    CHECK(Find(kCalculator, "App", logo));
+    CHECK_EQ(logo, "Assets\\CalculatorAppList.png");
+    CHECK(!Find(kCalculator, "Other", logo));
+}
+
+TEST_CASE(SkipsACommentedOutApplication)
+{
+    std::string logo;
+    CHECK(Find(kCommentedOut, "", logo));
+    CHECK_EQ(logo, "Assets\\New.png");
+    CHECK(Find(kCommentedOut, "App", logo));
+    CHECK_EQ(logo, "Assets\\New.png");
+}
+
+TEST_CASE(PicksAmongSeveralApplications)
+{
+    std::string logo;
+    CHECK(Find(kSeveralApps, "", logo));
+    CHECK_EQ(logo, "Images\\MailAppList.png");
+    CHECK(Find(kSeveralApps, "Calendar", logo));
+    CHECK_EQ(logo, "Images\\CalendarAppList.png");
+
+    // No logo of its own: neither the next application's nor anything else
+    logo.clear();
+    CHECK(!Find(kSeveralApps, "Background", logo));
+    CHECK(!Find(kSeveralApps, "Stub", logo));
+    CHECK(!Find(kSeveralApps, "mail", logo)); // Ids are case-sensitive
+    CHECK(logo.empty());
+}
+
+TEST_CASE(SingleQuotesAndEntities)
+{
+    std::string logo;
+    CHECK(Find(kQuirks, "Tools & More", logo));
+    CHECK_EQ(logo, "Assets\\R&D\\Logo.png");
+    CHECK(Find(kQuirks, "Hex", logo));
+    CHECK_EQ(logo, "Assets\\Logo.png");
+}
+
+TEST_CASE(TruncatedManifestsFailCleanly)
+{
+    for (const char* xml : { kCalculator, kCommentedOut, kSeveralApps, kQuirks }) {
+        const std::size_t size = std::strlen(xml);
+        std::string full;
+        CHECK(AppxManifest::FindSquare44x44Logo(xml, size, "", full));
+        for (std::size_t n = 0; n < size; ++n) {
+            // An exact-size copy, so a read past the end is out of bounds
+            const std::vector<char> copy(xml, xml + n);
+            std::string logo;
+            if (AppxManifest::FindSquare44x44Logo(copy.data(), copy.size(), "", logo)) CHECK_EQ(logo, full);
+        }
+    }
+    std::string logo;
+    CHECK(!AppxManifest::FindSquare44x44Logo(nullptr, 10, "", logo));
+}
+
+TEST_CASE(PickPrefersExactTargetSizeUnplated)
+{
+    CHECK(Pick(kAssets, 16) == L"Square44x44Logo.targetsize-16_altform-unplated.png");
+    CHECK(Pick(kAssets, 32) == L"Square44x44Logo.targetsize-32_altform-unplated.png");
+    CHECK(Pick(kAssets, 48) == L"Square44x44Logo.targetsize-48_altform-unplated.png");
+    CHECK(Pick(kAssets, 24) == L"Square44x44Logo.targetsize-24.png");  // Plated is all there is
+}
+
+TEST_CASE(PickFallsBackToTheNearestScale)
+{
+    CHECK(Pick(kAssets, 44) == L"Square44x44Logo.scale-100.png");      // Exact
+    CHECK(Pick(kAssets, 40) == L"Square44x44Logo.scale-100.png");      // 44 beats targetsize-48
+    CHECK(Pick(kAssets, 60) == L"Square44x44Logo.scale-150.png");      // 66: smallest larger
+    CHECK(Pick(kAssets, 20) == L"Square44x44Logo.targetsize-24.png");  // theme-light 20 is skipped
+    CHECK(Pick(kAssets, 300) == L"Square44x44Logo.targetsize-256_altform-unplated.png"); // Largest smaller
+
+    // Same size as targetsize and as scale: targetsize wins
+    const std::vector<std::wstring> tie = { L"Square44x44Logo.scale-100.png", L"Square44x44Logo.targetsize-44.png" };
+    CHECK(Pick(tie, 44) == L"Square44x44Logo.targetsize-44.png");
+
+    // Unqualified reads as scale-100; names match case-insensitively
+    const std::vector<std::wstring> plain = { L"SQUARE44X44LOGO.PNG", L"square44x44logo.Scale-200.PNG" };
+    CHECK(Pick(plain, 44) == L"SQUARE44X44LOGO.PNG");
+    CHECK(Pick(plain, 80) == L"square44x44logo.Scale-200.PNG");
+}
+
+TEST_CASE(PickSkipsUnusableVariants)
+{
+    const std::vector<std::wstring> contrast = {
+        L"Square44x44Logo.targetsize-32_contrast-white.png",
+        L"Square44x44Logo.contrast-black_scale-100.png",
+        L"Square44x44Logo.targetsize-32_altform-lightunplated.png",
+        L"Square44x44LogoWide.targetsize-32.png",
+        L"Square44x44Logo.targetsize-32.jpg",
+    };
+    CHECK(Pick(contrast, 32).empty());
+    CHECK(AppxManifest::PickLogoVariant(L"NoExtension", kAssets, 32).empty());
+    CHECK(Pick(kAssets, 0).empty());
+}
+
+int main()
+{
+    return TestHarness::RunAll();
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+// Timing helpers for the benchmark programs. Each benchmark also runs under
+// ctest with --quick (one short repetition) so it keeps building and working.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace BenchHarness {
+
+    inline bool& QuickRef()
+    {
+        static bool quick = false;
+        return quick;
+    }
+
+    // Reads --quick from the command line.
+    inline void Init(int argc, char** argv)
+    {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--quick") == 0) QuickRef() = true;
+        }
+    }
+
+    inline bool Quick() { return QuickRef(); }
+
+    // Keeps a result alive so the optimizer can't drop the work behind it.
+    inline void Consume(std::uint64_t value)
+    {
+        static volatile std::uint64_t sink = 0;
+        sink = sink + value;
+    }
+
+    // Nanoseconds per item: best of several runs of `body`, which processes
+    // `items` items per call. `setup` runs untimed before each call.
+    template <typename Setup, typename Body>
+    double NanosPerItem(std::uint64_t items, Setup&& setup, Body&& body)
+    {
+        using Clock = std::chrono::steady_clock;
+        const int reps = Quick() ? 1 : 7;
+        double best = 0.0;
+        for (int r = 0; r < reps; ++r) {
+            setup();
+            const auto start = Clock::now();
+            body();
+            const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            if (r == 0 || ns < best) best = ns;
+        }
+        return items ? best / static_cast<double>(items) : best;
+    }
+
+    template <typename Body>
+    double NanosPerItem(std::uint64_t items, Body&& body)
+    {
+        return NanosPerItem(items, [] {}, body);
+    }
+
+    // One result line: name, time per item, and items per second.
+    inline void Report(const char* name, double nanosPerItem, const char* item)
+    {
+        std::printf("%-44s %12.1f ns/%s %14.0f %s/s\n", name, nanosPerItem, item,
+            nanosPerItem > 0.0 ? 1e9 / nanosPerItem : 0.0, item);
+    }
+
+} // namespace BenchHarness
+
+#endif // BENCHHARNESS_H
@@ -0,0 +1,162 @@
+// The audit's bookkeeping, on made-up handle values. The soak run (--soak)
+// that uses it needs a Windows desktop; what it relies on is checked here.
+#include "HandleAudit.h"
+#include "TestHarness.h"
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // Distinct non-null values; nothing is dereferenced
+    void* Handle(std::uintptr_t n)
+    {
+        return reinterpret_cast<void*>(0x10000 + n * 16);
+    }
+
+    bool Has(const std::wstring& report, const std::string& text)
+    {
+        return report.find(std::wstring(text.begin(), text.end())) != std::wstring::npos;
+    }
+
+    std::string Site(int line)
+    {
+        return "HandleAuditTests.cpp:" + std::to_string(line);
+    }
+}
+
+TEST_CASE(TrackAndUntrackBalance)
+{
+    const std::size_t before = HandleAudit::LiveCount();
+    void* a = WTT_TRACK(Handle(1), "HICON");
+    void* b = WTT_TRACK(Handle(2), "HBITMAP");
+    CHECK(a == Handle(1));                       // The macros pass the handle through
+    CHECK_EQ(HandleAudit::LiveCount(), before + 2);
+
+    CHECK(WTT_UNTRACK(a) == Handle(1));
+    CHECK_EQ(HandleAudit::LiveCount(), before + 1);
+    WTT_UNTRACK(b);
+    CHECK_EQ(HandleAudit::LiveCount(), before);
+
+    // Null handles (a failed create, an icon without a color bitmap) are not recorded
+    WTT_TRACK(static_cast<void*>(nullptr), "HICON");
+    WTT_TRACKED(static_cast<void*>(nullptr), "HBITMAP");
+    WTT_UNTRACK(static_cast<void*>(nullptr));
+    CHECK_EQ(HandleAudit::LiveCount(), before);
+}
+
+TEST_CASE(ReportNamesTheLeakingSite)
+{
+    HandleAudit::Mark();
+    std::vector<void*> leaked;
+    int leakLine = 0, balancedLine = 0;
+    for (std::uintptr_t i = 0; i < 3; ++i) {
+        leaked.push_back(WTT_TRACK(Handle(100 + i), "HICON")); leakLine = __LINE__;
+    }
+    for (std::uintptr_t i = 0; i < 5; ++i) {
+        void* h = WTT_TRACK(Handle(200 + i), "HBITMAP"); balancedLine = __LINE__;
+        WTT_UNTRACK(h);
+    }
+
+    const std::wstring report = HandleAudit::FormatReport();
+    CHECK(Has(report, "+3 since mark, 3 live (3 created, 0 freed) HICON at " + Site(leakLine) + "\n"));
+    CHECK(!Has(report, Site(balancedLine)));   // Nothing live, nothing grown: not listed
+
+    // Freed after the next mark: listed as shrinking, then not at all
+    HandleAudit::Mark();
+    for (void* h : leaked) WTT_UNTRACK(h);
+    CHECK(Has(HandleAudit::FormatReport(),
+        "-3 since mark, 0 live (3 created, 3 freed) HICON at " + Site(leakLine) + "\n"));
+    HandleAudit::Mark();
+    CHECK(!Has(HandleAudit::FormatReport(), Site(leakLine)));
+}
+
+TEST_CASE(HandedOutTwiceMovesToTheNewSite)
+{
+    // Freed somewhere unaudited, then returned again by another create
+    const std::size_t before = HandleAudit::LiveCount();
+    HandleAudit::Mark();
+    WTT_TRACK(Handle(300), "HICON"); const int first = __LINE__;
+    WTT_TRACK(Handle(300), "HICON"); const int second = __LINE__;
+    CHECK_EQ(HandleAudit::LiveCount(), before + 1);
+
+    // The first site has nothing live any more, so only the second is listed
+    const std::wstring report = HandleAudit::FormatReport();
+    CHECK(!Has(report, Site(first)));
+    CHECK(Has(report, "+1 since mark, 1 live (1 created, 0 freed) HICON at " + Site(second)));
+    WTT_UNTRACK(Handle(300));
+    CHECK_EQ(HandleAudit::LiveCount(), before);
+}
+
+TEST_CASE(FreesOfUnrecordedHandlesAreReported)
+{
+    const std::size_t before = HandleAudit::LiveCount();
+    int line = 0;
+    for (std::uintptr_t i = 0; i < 2; ++i) {
+        WTT_UNTRACK(Handle(400 + i)); line = __LINE__;
+    }
+    CHECK_EQ(HandleAudit::LiveCount(), before);
+    CHECK(Has(HandleAudit::FormatReport(), "  2 frees of unrecorded handles at " + Site(line) + "\n"));
+}
+
+TEST_CASE(OutPointerHandles)
+{
+    // GetIconInfo hands its bitmaps out through a struct
+    const std::size_t before = HandleAudit::LiveCount();
+    struct { void* hbmColor; void* hbmMask; } info = { Handle(500), Handle(501) };
+    WTT_TRACKED(info.hbmColor, "HBITMAP");
+    WTT_TRACKED(info.hbmMask, "HBITMAP");
+    CHECK_EQ(HandleAudit::LiveCount(), before + 2);
+    WTT_UNTRACK(info.hbmColor);
+    WTT_UNTRACK(info.hbmMask);
+    CHECK_EQ(HandleAudit::LiveCount(), before);
+}
+
+TEST_CASE(SoakCyclesWithOneLeakPerHundred)
+{
+    // What --soak looks for: after warm-up the count grows with the cycles,
+    // and the report puts the growing site first
+    const int kWarmUp = 50, kCycles = 1000;
+    std::vector<void*> leaked;
+    int iconLine = 0;
+    for (int cycle = 0; cycle < kWarmUp + kCycles; ++cycle) {
+        if (cycle == kWarmUp) HandleAudit::Mark();
+        void* icon = WTT_TRACK(Handle(1000 + 4 * cycle), "HICON"); iconLine = __LINE__;
+        void* color = WTT_TRACK(Handle(1001 + 4 * cycle), "HBITMAP");
+        void* mask = WTT_TRACK(Handle(1002 + 4 * cycle), "HBITMAP");
+        WTT_UNTRACK(color);
+        WTT_UNTRACK(mask);
+        if (cycle % 100 == 99) leaked.push_back(icon);   // Never destroyed
+        else WTT_UNTRACK(icon);
+    }
+
+    const std::wstring report = HandleAudit::FormatReport();
+    const std::string first = "\n  +10 since mark, 10 live (1050 created, 1040 freed) HICON at " +
+        Site(iconLine) + "\n";
+    CHECK(report.find(std::wstring(first.begin(), first.end())) == report.find(L'\n'));
+    for (void* h : leaked) WTT_UNTRACK(h);
+}
+
+TEST_CASE(ConcurrentTrackingBalances)
+{
+    // The icon worker and the UI thread both create and free icons
+    const std::size_t before = HandleAudit::LiveCount();
+    std::vector<std::thread> threads;
+    for (std::uintptr_t t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (std::uintptr_t i = 0; i < 20000; ++i) {
+                void* h = WTT_TRACK(Handle(100000 + t * 100000 + i), "HICON");
+                if (i % 2) WTT_UNTRACK(h);
+            }
+            for (std::uintptr_t i = 0; i < 20000; i += 2) WTT_UNTRACK(Handle(100000 + t * 100000 + i));
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    CHECK_EQ(HandleAudit::LiveCount(), before);
+}
+
+int main()
+{
+    return TestHarness::RunAll();
+}
@@ -0,0 +1,248 @@
+#include "HideMode.h"
+#include "TestHarness.h"
+#include <set>
+
+using HideModePolicy::ParseAppList;
+using HideModePolicy::SelectForExecutable;
+
+namespace {
+
+    // The desktop API as the backend sees it
+    struct FakeDesktops {
+        int  current{ 0 };
+        int  hidden{ 3 };
+        bool available{ true };
+        std::set<const HideBackend*> parked;   // The hidden desktop's count
+    };
+
+    // A window on those desktops. Showing is the caller's job, as in
+    // WindowManager::RestoreWindow.
+    class FakeWindow : public HideBackend {
+    public:
+        explicit FakeWindow(FakeDesktops& desktops, int desktop = 0) : desktops(desktops), desktop(desktop) {}
+
+        bool HideTraditional() override
+        {
+            tab = false;
+            toolWindow = true;
+            visible = false;
+            return true;
+        }
+
+        void UnhideTraditional() override
+        {
+            tab = true;
+            toolWindow = false;
+            ++relayouts;   // The style change re-lays out the frame
+        }
+
+        bool Cloak() override
+        {
+            if (!desktops.available) return false;
+            desktop = desktops.hidden;
+            desktops.parked.insert(this);
+            tab = false;
+            return true;
+        }
+
+        void Uncloak() override
+        {
+            desktop = desktops.current;
+            desktops.parked.erase(this);
+            tab = true;
+        }
+
+        bool Park() override
+        {
+            if (!desktops.available) return false;
+            desktop = desktops.hidden;
+            desktops.parked.insert(this);
+            return true;
+        }
+
+        bool IsParked() const override { return desktops.parked.count(this) != 0; }
+
+        void Unpark(int to) override
+        {
+            desktop = to;
+            desktops.parked.erase(this);
+        }
+
+        // The tray entry's side of a round trip
+        bool Hide(const HideRequest& request)
+        {
+            state.originalDesktop = desktop;
+            return HideModePolicy::Hide(*this, request, state.hideMode);
+        }
+
+        void Restore()
+        {
+            HideModePolicy::PrepareRestore(*this, state);
+            if (state.hideMode != HideMode::Cloak) visible = true;
+        }
+
+        FakeDesktops& desktops;
+        RestoreState  state;
+        int  desktop;
+        bool visible{ true };
+        bool toolWindow{ false };
+        bool tab{ true };
+        int  relayouts{ 0 };
+    };
+
+    HideRequest Request(bool cloak, bool uwp = false, bool packaged = false, bool useVirtualDesktop = false)
+    {
+        HideRequest request;
+        request.isUwp = uwp;
+        request.isPackaged = packaged;
+        request.cloakRequested = cloak;
+        request.useVirtualDesktop = useVirtualDesktop;
+        return request;
+    }
+}
+
+TEST_CASE(ParseAppListSplitsTrimsAndLowers)
+{
+    const auto apps = ParseAppList(L"Code.exe; chrome.EXE ,\tnotepad.exe");
+    CHECK_EQ(apps.size(), 3u);
+    if (apps.size() != 3) return;
+    CHECK(apps[0] == L"code.exe");
+    CHECK(apps[1] == L"chrome.exe");
+    CHECK(apps[2] == L"notepad.exe");
+}
+
+TEST_CASE(ParseAppListSkipsEmptyItems)
+{
+    CHECK(ParseAppList(L"").empty());
+    CHECK(ParseAppList(L"  ").empty());
+    CHECK(ParseAppList(L";;, ;").empty());
+
+    const auto apps = ParseAppList(L";a.exe;;  ;b.exe;");
+    CHECK_EQ(apps.size(), 2u);
+    if (apps.size() == 2) {
+        CHECK(apps[0] == L"a.exe");
+        CHECK(apps[1] == L"b.exe");
+    }
+}
+
+TEST_CASE(ParseAppListKeepsInnerBlanks)
+{
+    const auto apps = ParseAppList(L" My App.exe ");
+    CHECK_EQ(apps.size(), 1u);
+    if (!apps.empty()) CHECK(apps[0] == L"my app.exe");
+}
+
+TEST_CASE(SelectMatchesFileNameOnly)
+{
+    const auto apps = ParseAppList(L"chrome.exe;Code.exe");
+    CHECK(SelectForExecutable(L"C:\\Program Files\\Google\\Chrome\\Application\\chrome.exe", apps) == HideMode::Cloak);
+    CHECK(SelectForExecutable(L"C:/Users/me/AppData/Local/Programs/VS Code/CODE.EXE", apps) == HideMode::Cloak);
+    CHECK(SelectForExecutable(L"chrome.exe", apps) == HideMode::Cloak);
+
+    // The directory never matches, nor does a name that merely contains an entry
+    CHECK(SelectForExecutable(L"C:\\chrome.exe\\other.exe", apps) == HideMode::Traditional);
+    CHECK(SelectForExecutable(L"C:\\x\\notchrome.exe", apps) == HideMode::Traditional);
+    CHECK(SelectForExecutable(L"C:\\x\\chrome.exe.bak", apps) == HideMode::Traditional);
+}
+
+TEST_CASE(SelectDefaultsToTraditional)
+{
+    const auto apps = ParseAppList(L"chrome.exe");
+    CHECK(SelectForExecutable(L"", apps) == HideMode::Traditional);
+    CHECK(SelectForExecutable(L"C:\\x\\chrome.exe", {}) == HideMode::Traditional);
+    CHECK(SelectForExecutable(L"C:\\x\\", apps) == HideMode::Traditional);
+}
+
+TEST_CASE(TraditionalRoundTrip)
+{
+    FakeDesktops desktops;
+    FakeWindow window(desktops);
+    CHECK(window.Hide(Request(false)));
+    CHECK(window.state.hideMode == HideMode::Traditional);
+    CHECK(!window.visible && !window.tab && window.toolWindow);
+    CHECK(desktops.parked.empty());
+
+    window.Restore();
+    CHECK(window.visible && window.tab && !window.toolWindow);
+    CHECK_EQ(window.desktop, 0);
+    CHECK_EQ(window.relayouts, 1);
+}
+
+TEST_CASE(CloakRoundTrip)
+{
+    FakeDesktops desktops;
+    FakeWindow window(desktops, 1);
+    CHECK(window.Hide(Request(true)));
+    CHECK(window.state.hideMode == HideMode::Cloak);
+    CHECK(window.visible && !window.toolWindow && !window.tab);   // Show state and styles kept
+    CHECK_EQ(window.desktop, desktops.hidden);
+    CHECK(window.IsParked());
+
+    // Back onto the desktop the user is on now, without a re-layout
+    desktops.current = 2;
+    window.Restore();
+    CHECK(window.visible && window.tab);
+    CHECK_EQ(window.desktop, 2);
+    CHECK_EQ(window.relayouts, 0);
+    CHECK(desktops.parked.empty());
+}
+
+TEST_CASE(CloakFallsBackWithoutDesktopApi)
+{
+    FakeDesktops desktops;
+    desktops.available = false;
+    FakeWindow window(desktops);
+    CHECK(window.Hide(Request(true)));
+    CHECK(window.state.hideMode == HideMode::Traditional);
+    CHECK(!window.visible && !window.tab);
+
+    window.Restore();
+    CHECK(window.visible && window.tab);
+    CHECK_EQ(window.desktop, 0);
+}
+
+TEST_CASE(PackagedWindowsAreNeverCloaked)
+{
+    FakeDesktops desktops;
+    FakeWindow window(desktops);
+    CHECK(window.Hide(Request(true, true, true, true)));
+    CHECK(window.state.hideMode == HideMode::Traditional);
+    CHECK(!window.visible && window.IsParked());   // The enhancement instead
+    window.Restore();
+    CHECK(window.visible && !window.IsParked());
+
+    // A Win32 window that merely sets an AUMID is cloaked
+    FakeWindow aumidOnly(desktops);
+    CHECK(aumidOnly.Hide(Request(true, true, false, true)));
+    CHECK(aumidOnly.state.hideMode == HideMode::Cloak);
+    aumidOnly.Restore();
+    CHECK(desktops.parked.empty());
+}
+
+TEST_CASE(UwpEnhancementRoundTrip)
+{
+    FakeDesktops desktops;
+    FakeWindow window(desktops, 1);
+    CHECK(window.Hide(Request(false, true, true, true)));
+    CHECK(!window.visible && !window.tab);
+    CHECK_EQ(window.desktop, desktops.hidden);
+    CHECK(window.IsParked());
+
+    // Back to the desktop it was hidden from, not the current one
+    window.Restore();
+    CHECK(window.visible && window.tab);
+    CHECK_EQ(window.desktop, 1);
+    CHECK(desktops.parked.empty());
+
+    // With the enhancement off it stays put
+    CHECK(window.Hide(Request(false, true, true, false)));
+    CHECK_EQ(window.desktop, 1);
+    CHECK(desktops.parked.empty());
+    window.Restore();
+    CHECK(window.visible && window.tab);
+}
+
+int main()
+{
+    return TestHarness::RunAll();
+}
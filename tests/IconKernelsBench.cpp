@@ -0,0 +1,271 @@
+// Throughput of the icon kernels on synthetic icons, per instruction set.
+#include "IconKernels.h"
+#include "IconSamples.h"
+#include "BenchHarness.h"
+#include <cmath>
+#include <cstdio>
+#include <queue>
+#include <utility>
+
+using namespace BenchHarness;
+using IconKernels::Isa;
+
+namespace {
+
+    const int kSizes[] = { 16, 24, 32, 48, 64, 128, 256 };
+
+    // Enough copies of an icon per timed run that small sizes aren't clock noise
+    int CopiesFor(int size)
+    {
+        return Quick() ? 1 : std::max(1, (1 << 18) / (size * size));
+    }
+
+    // The fill background removal used before the span kernel: exact match,
+    // one queue node per pixel
+    std::size_t QueueFloodFill(std::uint32_t* pixels, int width, int height)
+    {
+        const std::uint32_t bg = pixels[0];
+        if ((bg >> 24) == 0) return 0;
+        std::size_t cleared = 0;
+        std::queue<std::pair<int, int>> q;
+        auto seed = [&](int x, int y) {
+            if (x < 0 || x >= width || y < 0 || y >= height) return;
+            std::uint32_t& p = pixels[y * width + x];
+            if (p != bg) return;
+            q.push({ x, y });
+            p = 0;
+            ++cleared;
+        };
+        seed(0, 0); seed(width - 1, 0); seed(0, height - 1); seed(width - 1, height - 1);
+        while (!q.empty()) {
+            const auto p = q.front();
+            q.pop();
+            seed(p.first + 1, p.second); seed(p.first - 1, p.second);
+            seed(p.first, p.second + 1); seed(p.first, p.second - 1);
+        }
+        return cleared;
+    }
+
+    // Times `fill` over fresh copies of `icon`; returns ns per pixel
+    template <typename Fill>
+    double TimeFill(const std::vector<std::uint32_t>& icon, int size, Fill&& fill)
+    {
+        const int copies = CopiesFor(size);
+        std::vector<std::vector<std::uint32_t>> work(copies);
+        return NanosPerItem(static_cast<std::uint64_t>(copies) * size * size,
+            [&] { for (auto& w : work) w = icon; },
+            [&] {
+                std::uint64_t cleared = 0;
+                for (auto& w : work) cleared += fill(w.data());
+                Consume(cleared);
+            });
+    }
+
+    void BenchFloodFill()
+    {
+        std::printf("\nFlood fill from the corners (ns per pixel)\n");
+        std::vector<IconKernels::FillSeed> stack;
+        char name[96];
+        for (int size : kSizes) {
+            const auto flat = IconSamples::TileIcon(size, size, 0xFFF0F0F0u, 0xFF2060C0u);
+            const auto noisy = IconSamples::TileIcon(size, size, 0xFFF0F0F0u, 0xFF2060C0u, 6, 7);
+
+            std::snprintf(name, sizeof(name), "%3d px  queue fill (exact)", size);
+            Report(name, TimeFill(flat, size, [&](std::uint32_t* p) { return QueueFloodFill(p, size, size); }), "px");
+
+            for (Isa isa : IconSamples::SupportedIsas()) {
+                IconKernels::SelectIsa(isa);
+                std::snprintf(name, sizeof(name), "%3d px  span fill (exact) %s", size, IconKernels::IsaName(isa));
+                Report(name, TimeFill(flat, size, [&](std::uint32_t* p) {
+                    return IconKernels::FloodFillCorners(p, size, size, size, stack);
+                }), "px");
+                std::snprintf(name, sizeof(name), "%3d px  span fill (tol 8) %s", size, IconKernels::IsaName(isa));
+                Report(name, TimeFill(noisy, size, [&](std::uint32_t* p) {
+                    return IconKernels::FloodFillCorners(p, size, size, size, stack, 8);
+                }), "px");
+            }
+        }
+        IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+    }
+
+    void BenchConvert()
+    {
+        std::printf("\nColor + mask to ARGB (ns per pixel)\n");
+        struct Format { int bpp; bool mask; bool alpha; const char* label; };
+        const Format formats[] = {
+            { 1, true, false, "1 bpp + mask" }, { 4, true, false, "4 bpp + mask" }, { 8, true, false, "8 bpp + mask" },
+            { 24, true, false, "24 bpp + mask" }, { 32, true, false, "32 bpp + mask" }, { 32, false, true, "32 bpp alpha" },
+        };
+        std::uint32_t palette[256];
+        IconSamples::Random rng(3);
+        for (auto& p : palette) p = rng.Next() & 0xFFFFFF;
+        char name[96];
+        for (int size : { 16, 32, 48, 256 }) {
+            const int copies = CopiesFor(size);
+            std::vector<std::uint32_t> dst(static_cast<std::size_t>(size) * size);
+            const int maskStride = ((size + 31) / 32) * 4;
+            std::vector<std::uint8_t> mask(static_cast<std::size_t>(maskStride) * size);
+            for (auto& b : mask) b = static_cast<std::uint8_t>(rng.Next());
+
+            for (const Format& f : formats) {
+                const int stride = ((size * f.bpp + 31) / 32) * 4;
+                std::vector<std::uint8_t> bits(static_cast<std::size_t>(stride) * size);
+                for (std::size_t i = 0; i < bits.size(); ++i) {
+                    bits[i] = (f.bpp == 32 && i % 4 == 3 && !f.alpha) ? 0 : static_cast<std::uint8_t>(rng.Next());
+                }
+                IconKernels::SourceBitmap src;
+                src.bits = bits.data();
+                src.bitsPerPixel = f.bpp;
+                src.stride = stride;
+                src.palette = f.bpp <= 8 ? palette : nullptr;
+                src.paletteSize = f.bpp <= 8 ? 1 << f.bpp : 0;
+
+                for (Isa isa : IconSamples::SupportedIsas()) {
+                    IconKernels::SelectIsa(isa);
+                    std::snprintf(name, sizeof(name), "%3d px  %-14s %s", size, f.label, IconKernels::IsaName(isa));
+                    Report(name, NanosPerItem(static_cast<std::uint64_t>(copies) * size * size, [&] {
+                        for (int i = 0; i < copies; ++i) {
+                            IconKernels::ConvertToArgb(src, f.mask ? mask.data() : nullptr, maskStride, size, size,
+                                dst.data(), size);
+                        }
+                        Consume(dst[0]);
+                    }), "px");
+                }
+            }
+        }
+        IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+    }
+
+    // Stand-in for the GDI+ DrawImage HighQualityBicubic path, which can't
+    // run here: a 2-D bicubic (Catmull-Rom, widened when shrinking) with the
+    // weights worked out per tap and per output pixel, premultiplied
+    void DirectBicubic(const std::uint32_t* src, int srcWidth, int srcHeight, std::uint32_t* dst,
+        int dstWidth, int dstHeight)
+    {
+        auto cubic = [](float x) {
+            x = std::fabs(x);
+            if (x < 1.0f) return (1.5f * x - 2.5f) * x * x + 1.0f;
+            if (x < 2.0f) return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+            return 0.0f;
+        };
+        const float rx = float(srcWidth) / dstWidth, ry = float(srcHeight) / dstHeight;
+        const float sx = std::max(1.0f, rx), sy = std::max(1.0f, ry);
+        for (int y = 0; y < dstHeight; ++y) {
+            const float cy = (y + 0.5f) * ry;
+            const int y0 = std::max(0, static_cast<int>(std::floor(cy - 2 * sy)));
+            const int y1 = std::min(srcHeight, static_cast<int>(std::ceil(cy + 2 * sy)));
+            for (int x = 0; x < dstWidth; ++x) {
+                const float cx = (x + 0.5f) * rx;
+                const int x0 = std::max(0, static_cast<int>(std::floor(cx - 2 * sx)));
+                const int x1 = std::min(srcWidth, static_cast<int>(std::ceil(cx + 2 * sx)));
+                float acc[4] = {}, total = 0.0f;
+                for (int v = y0; v < y1; ++v) {
+                    const float wy = cubic((v + 0.5f - cy) / sy);
+                    for (int u = x0; u < x1; ++u) {
+                        const float w = wy * cubic((u + 0.5f - cx) / sx);
+                        const std::uint32_t p = src[static_cast<std::size_t>(v) * srcWidth + u];
+                        const float a = float(p >> 24), f = w * a / 255.0f;
+                        acc[0] += f * float((p >> 16) & 0xFF);
+                        acc[1] += f * float((p >> 8) & 0xFF);
+                        acc[2] += f * float(p & 0xFF);
+                        acc[3] += w * a;
+                        total += w;
+                    }
+                }
+                const float a = std::min(255.0f, std::max(0.0f, acc[3] / total));
+                std::uint32_t out = 0;
+                if (a >= 0.5f) {
+                    out = static_cast<std::uint32_t>(a + 0.5f) << 24;
+                    for (int i = 0; i < 3; ++i) {
+                        const float c = std::min(255.0f, std::max(0.0f, acc[i] / total * 255.0f / a));
+                        out |= static_cast<std::uint32_t>(c + 0.5f) << (16 - 8 * i);
+                    }
+                }
+                dst[static_cast<std::size_t>(y) * dstWidth + x] = out;
+            }
+        }
+    }
+
+    void BenchScaling()
+    {
+        std::printf("\nScaling (ns per output pixel)\n");
+        const int pairs[][2] = { { 256, 16 }, { 256, 32 }, { 48, 32 }, { 32, 20 }, { 32, 48 }, { 16, 32 } };
+        char name[96];
+        for (const auto& p : pairs) {
+            const int from = p[0], to = p[1];
+            const auto src = IconSamples::TileIcon(from, from, 0x00000000u, 0xFF2060C0u);
+            std::vector<std::uint32_t> dst(static_cast<std::size_t>(to) * to);
+            const int copies = CopiesFor(to);
+            const std::uint64_t items = static_cast<std::uint64_t>(copies) * to * to;
+
+            std::snprintf(name, sizeof(name), "%3d -> %3d px  direct bicubic", from, to);
+            Report(name, NanosPerItem(items, [&] {
+                for (int i = 0; i < copies; ++i) DirectBicubic(src.data(), from, from, dst.data(), to, to);
+                Consume(dst[0]);
+            }), "px");
+
+            for (Isa isa : IconSamples::SupportedIsas()) {
+                IconKernels::SelectIsa(isa);
+                for (auto filter : { IconKernels::Filter::Box, IconKernels::Filter::Lanczos3 }) {
+                    std::snprintf(name, sizeof(name), "%3d -> %3d px  %s %s", from, to,
+                        filter == IconKernels::Filter::Box ? "box" : "lanczos3", IconKernels::IsaName(isa));
+                    Report(name, NanosPerItem(items, [&] {
+                        for (int i = 0; i < copies; ++i) {
+                            IconKernels::Resample(src.data(), from, from, from, dst.data(), to, to, to, filter);
+                        }
+                        Consume(dst[0]);
+                    }), "px");
+                }
+                if (to <= from) {
+                    std::snprintf(name, sizeof(name), "%3d -> %3d px  area %s", from, to, IconKernels::IsaName(isa));
+                    Report(name, NanosPerItem(items, [&] {
+                        for (int i = 0; i < copies; ++i) {
+                            IconKernels::AreaScaler scaler(from, from, dst.data(), to, to, to);
+                            for (int y = 0; y < from; ++y) {
+                                scaler.PushRow(src.data() + static_cast<std::size_t>(y) * from);
+                            }
+                        }
+                        Consume(dst[0]);
+                    }), "px");
+                }
+            }
+        }
+        IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+    }
+
+    void BenchAlphaBounds()
+    {
+        std::printf("\nAlpha bounds after the fill (ns per pixel)\n");
+        std::vector<IconKernels::FillSeed> stack;
+        char name[96];
+        for (int size : kSizes) {
+            auto icon = IconSamples::TileIcon(size, size, 0xFFF0F0F0u, 0xFF2060C0u);
+            (void)IconKernels::FloodFillCorners(icon.data(), size, size, size, stack);
+            const int copies = CopiesFor(size);
+            for (Isa isa : IconSamples::SupportedIsas()) {
+                IconKernels::SelectIsa(isa);
+                std::snprintf(name, sizeof(name), "%3d px  bounds %s", size, IconKernels::IsaName(isa));
+                Report(name, NanosPerItem(static_cast<std::uint64_t>(copies) * size * size, [&] {
+                    int sum = 0;
+                    for (int i = 0; i < copies; ++i) {
+                        const IconKernels::Bounds b = IconKernels::AlphaBounds(icon.data(), size, size, size);
+                        sum += b.left + b.right + static_cast<int>(IconKernels::ChooseScale(b, size, size) * 8);
+                    }
+                    Consume(static_cast<std::uint64_t>(sum));
+                }), "px");
+            }
+        }
+        IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Init(argc, argv);
+    std::printf("Best instruction set: %s\n", IconKernels::IsaName(IconKernels::BestSupportedIsa()));
+    BenchFloodFill();
+    BenchAlphaBounds();
+    BenchScaling();
+    BenchConvert();
+    return 0;
+}
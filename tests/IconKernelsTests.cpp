@@ -0,0 +1,728 @@
+// The SSE2 and AVX2 row scans must give the scalar results bit for bit, and
+// the scalar path must match a plain reference written from the contract.
+#include "IconKernels.h"
+#include "IconSamples.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+
+using IconKernels::Isa;
+using IconSamples::kPadding;
+
+namespace {
+
+    // Runs `produce` once per supported instruction set and checks every
+    // result against the scalar one. Leaves the best set active.
+    void CheckSameOnEveryIsa(const std::function<std::vector<std::uint32_t>()>& produce)
+    {
+        std::vector<std::uint32_t> scalar;
+        for (Isa isa : IconSamples::SupportedIsas()) {
+            CHECK(IconKernels::SelectIsa(isa));
+            const std::vector<std::uint32_t> out = produce();
+            if (isa == Isa::Scalar) scalar = out;
+            else if (out != scalar) {
+                std::fprintf(stderr, "  %s differs from Scalar\n", IconKernels::IsaName(isa));
+                CHECK(out == scalar);
+            }
+        }
+        IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+    }
+
+    bool PaddingIntact(const std::vector<std::uint32_t>& pixels, int width, int stride)
+    {
+        for (std::size_t i = 0; i < pixels.size(); ++i) {
+            if (static_cast<int>(i % stride) >= width && pixels[i] != kPadding) return false;
+        }
+        return true;
+    }
+
+    bool Near(std::uint32_t p, std::uint32_t value, int tol)
+    {
+        for (int shift = 0; shift < 32; shift += 8) {
+            if (std::abs(int((p >> shift) & 0xFF) - int((value >> shift) & 0xFF)) > tol) return false;
+        }
+        return true;
+    }
+
+    // Breadth-first fill, one pixel at a time, straight from the contract
+    std::size_t ReferenceFill(std::vector<std::uint32_t>& pixels, int width, int height, int stride,
+        int tolerance, std::vector<std::uint8_t>& mask)
+    {
+        mask.assign(static_cast<std::size_t>(width) * height, 0);
+        const std::uint32_t bg = pixels[0];
+        if ((bg >> 24) == 0) return 0;
+        const int tol = std::min<int>(tolerance, int(bg >> 24) - 1);
+
+        std::queue<std::pair<int, int>> q;
+        auto visit = [&](int x, int y) {
+            if (x < 0 || y < 0 || x >= width || y >= height) return;
+            if (mask[static_cast<std::size_t>(y) * width + x]) return;
+            if (!Near(pixels[static_cast<std::size_t>(y) * stride + x], bg, tol)) return;
+            mask[static_cast<std::size_t>(y) * width + x] = 1;
+            q.push({ x, y });
+        };
+        visit(0, 0); visit(width - 1, 0); visit(0, height - 1); visit(width - 1, height - 1);
+        std::size_t cleared = 0;
+        while (!q.empty()) {
+            const auto p = q.front();
+            q.pop();
+            ++cleared;
+            visit(p.first + 1, p.second); visit(p.first - 1, p.second);
+            visit(p.first, p.second + 1); visit(p.first, p.second - 1);
+        }
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (mask[static_cast<std::size_t>(y) * width + x]) pixels[static_cast<std::size_t>(y) * stride + x] = 0;
+            }
+        }
+        return cleared;
+    }
+
+    // Background with every channel (alpha too) jittered, broken by blobs of
+    // unrelated color so the fill has to find its way around them
+    std::vector<std::uint32_t> Blotchy(int width, int height, int stride, std::uint32_t bg, int jitter,
+        std::uint32_t seed)
+    {
+        IconSamples::Random rng(seed);
+        std::vector<std::uint32_t> pixels(static_cast<std::size_t>(stride) * height, kPadding);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                std::uint32_t p = bg;
+                if (rng.Below(4) == 0) p = rng.Next();
+                else if (jitter > 0 && (x || y)) {
+                    p = 0;
+                    for (int shift = 0; shift < 32; shift += 8) {
+                        const int v = int((bg >> shift) & 0xFF) + rng.Below(2 * jitter + 1) - jitter;
+                        p |= std::uint32_t(std::min(255, std::max(0, v))) << shift;
+                    }
+                }
+                pixels[static_cast<std::size_t>(y) * stride + x] = p;
+            }
+        }
+        return pixels;
+    }
+
+    void CheckFill(const std::vector<std::uint32_t>& source, int width, int height, int stride, int tolerance)
+    {
+        std::vector<std::uint32_t> expected = source;
+        std::vector<std::uint8_t> expectedMask;
+        const std::size_t expectedCount = ReferenceFill(expected, width, height, stride, tolerance, expectedMask);
+
+        std::vector<IconKernels::FillSeed> stack;
+        for (Isa isa : IconSamples::SupportedIsas()) {
+            IconKernels::SelectIsa(isa);
+            std::vector<std::uint32_t> pixels = source;
+            std::vector<std::uint8_t> mask;
+            const std::size_t count = IconKernels::FloodFillCorners(pixels.data(), width, height, stride, stack,
+                static_cast<std::uint8_t>(tolerance), &mask);
+            const bool ok = count == expectedCount && pixels == expected && mask == expectedMask;
+            if (!ok) {
+                std::fprintf(stderr, "  %dx%d stride %d tol %d on %s: %zu cleared, expected %zu\n",
+                    width, height, stride, tolerance, IconKernels::IsaName(isa), count, expectedCount);
+            }
+            CHECK(ok);
+            CHECK(PaddingIntact(pixels, width, stride));
+        }
+        IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+    }
+
+    // ConvertToArgb as the contract reads, one pixel at a time
+    std::vector<std::uint32_t> ReferenceConvert(const IconKernels::SourceBitmap& color, const std::uint8_t* mask,
+        int maskStride, int width, int height, int dstStride)
+    {
+        std::vector<std::uint32_t> out(static_cast<std::size_t>(dstStride) * height, kPadding);
+        bool alphaSeen = false;
+        for (int y = 0; y < height; ++y) {
+            const std::uint8_t* r = color.bits + static_cast<std::ptrdiff_t>(y) * color.stride;
+            for (int x = 0; x < width; ++x) {
+                std::uint32_t p;
+                if (color.bitsPerPixel == 32) {
+                    p = std::uint32_t(r[x * 4]) | (std::uint32_t(r[x * 4 + 1]) << 8) |
+                        (std::uint32_t(r[x * 4 + 2]) << 16) | (std::uint32_t(r[x * 4 + 3]) << 24);
+                    alphaSeen = alphaSeen || (p >> 24) != 0;
+                }
+                else if (color.bitsPerPixel == 24) {
+                    p = 0xFF000000u | (std::uint32_t(r[x * 3 + 2]) << 16) | (std::uint32_t(r[x * 3 + 1]) << 8) | r[x * 3];
+                }
+                else {
+                    const int bpp = color.bitsPerPixel;
+                    const int bit = x * bpp;
+                    const int index = (r[bit / 8] >> (8 - bpp - bit % 8)) & ((1 << bpp) - 1);
+                    p = index < color.paletteSize ? 0xFF000000u | (color.palette[index] & 0xFFFFFF) : 0xFF000000u;
+                }
+                out[static_cast<std::size_t>(y) * dstStride + x] = p;
+            }
+        }
+        if (color.bitsPerPixel == 32) {
+            if (alphaSeen) return out;
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) out[static_cast<std::size_t>(y) * dstStride + x] |= 0xFF000000u;
+            }
+        }
+        if (mask) {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    if (mask[y * maskStride + x / 8] & (0x80 >> (x % 8))) out[static_cast<std::size_t>(y) * dstStride + x] = 0;
+                }
+            }
+        }
+        return out;
+    }
+
+    std::vector<std::uint8_t> RandomBytes(std::size_t n, std::uint32_t seed)
+    {
+        IconSamples::Random rng(seed);
+        std::vector<std::uint8_t> bytes(n);
+        for (auto& b : bytes) b = static_cast<std::uint8_t>(rng.Next() >> 24);
+        return bytes;
+    }
+
+    // Widths around the 4- and 8-pixel steps and the 64-pixel match words
+    const int kWidths[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100 };
+}
+
+TEST_CASE(FloodFillMatchesReferenceAcrossStridesAndTolerances)
+{
+    std::uint32_t seed = 1;
+    for (int width : kWidths) {
+        for (int height : { 1, 3, 17 }) {
+            for (int pad : { 0, 1, 9 }) {
+                const int stride = width + pad;
+                for (int tol : { 0, 1, 8, 40, 255 }) {
+                    CheckFill(Blotchy(width, height, stride, 0xFFF0F0F0u, tol ? tol + 2 : 0, seed++),
+                        width, height, stride, tol);
+                    // Translucent background: the tolerance is held under its alpha
+                    CheckFill(Blotchy(width, height, stride, 0x06808080u, 3, seed++), width, height, stride, tol);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(FloodFillOnTileIcons)
+{
+    for (int size : { 16, 24, 32, 48, 64, 128, 256 }) {
+        for (int pad : { 0, 3 }) {
+            CheckFill(IconSamples::TileIcon(size, size + pad, 0xFFF0F0F0u, 0xFF2060C0u), size, size, size + pad, 0);
+            CheckFill(IconSamples::TileIcon(size, size + pad, 0xFFF0F0F0u, 0xFF2060C0u, 6, size), size, size,
+                size + pad, 8);
+        }
+    }
+}
+
+TEST_CASE(FloodFillLeavesTransparentBackgroundAlone)
+{
+    std::vector<std::uint32_t> pixels(64, 0x00FFFFFFu);
+    std::vector<IconKernels::FillSeed> stack;
+    std::vector<std::uint8_t> mask;
+    for (Isa isa : IconSamples::SupportedIsas()) {
+        IconKernels::SelectIsa(isa);
+        CHECK_EQ(IconKernels::FloodFillCorners(pixels.data(), 8, 8, 8, stack, 255, &mask), 0u);
+        CHECK(std::all_of(pixels.begin(), pixels.end(), [](std::uint32_t p) { return p == 0x00FFFFFFu; }));
+        CHECK(std::all_of(mask.begin(), mask.end(), [](std::uint8_t m) { return m == 0; }));
+    }
+    IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+}
+
+TEST_CASE(ConvertToArgbEveryDepthAndMask)
+{
+    std::uint32_t palette[256];
+    IconSamples::Random rng(5);
+    for (auto& p : palette) p = rng.Next();
+
+    struct Depth { int bpp; bool alpha; };
+    const Depth depths[] = { { 1, false }, { 4, false }, { 8, false }, { 24, false }, { 32, false }, { 32, true } };
+
+    std::uint32_t seed = 1;
+    for (const Depth& d : depths) {
+        for (int paletteSize : { 256, 3 }) { // 3: the rest read as opaque black
+            if (d.bpp > 8 && paletteSize != 256) continue;
+            for (bool withMask : { false, true }) {
+                for (int width : kWidths) {
+                    const int height = 3;
+                    const int stride = ((width * d.bpp + 31) / 32) * 4;
+                    std::vector<std::uint8_t> bits = RandomBytes(static_cast<std::size_t>(stride) * height, seed++);
+                    if (d.bpp == 32 && !d.alpha) {
+                        for (int i = 3; i < static_cast<int>(bits.size()); i += 4) bits[i] = 0;
+                    }
+                    if (d.bpp == 32 && d.alpha) bits[3] = 0x80; // At least one alpha byte set
+                    const int maskStride = ((width + 31) / 32) * 4;
+                    const std::vector<std::uint8_t> mask = RandomBytes(static_cast<std::size_t>(maskStride) * height, seed++);
+
+                    IconKernels::SourceBitmap src;
+                    src.bits = bits.data();
+                    src.bitsPerPixel = d.bpp;
+                    src.stride = stride;
+                    src.palette = d.bpp <= 8 ? palette : nullptr;
+                    src.paletteSize = d.bpp <= 8 ? paletteSize : 0;
+
+                    const int dstStride = width + 2;
+                    const std::uint8_t* m = withMask ? mask.data() : nullptr;
+                    const auto expected = ReferenceConvert(src, m, maskStride, width, height, dstStride);
+                    for (Isa isa : IconSamples::SupportedIsas()) {
+                        IconKernels::SelectIsa(isa);
+                        std::vector<std::uint32_t> out(expected.size(), kPadding);
+                        CHECK(IconKernels::ConvertToArgb(src, m, maskStride, width, height, out.data(), dstStride));
+                        if (out != expected) {
+                            std::fprintf(stderr, "  %d bpp%s%s, width %d, palette %d on %s\n", d.bpp,
+                                d.alpha ? " alpha" : "", withMask ? " masked" : "", width, paletteSize,
+                                IconKernels::IsaName(isa));
+                        }
+                        CHECK(out == expected);
+                    }
+                }
+            }
+        }
+    }
+    IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+}
+
+TEST_CASE(ConvertToArgbRejectsUnsupportedDepths)
+{
+    std::uint8_t bits[64] = {};
+    std::uint32_t out[16];
+    IconKernels::SourceBitmap src;
+    src.bits = bits;
+    src.stride = 16;
+    for (int bpp : { 0, 2, 16, 48 }) {
+        src.bitsPerPixel = bpp;
+        CHECK(!IconKernels::ConvertToArgb(src, nullptr, 0, 4, 4, out, 4));
+    }
+}
+
+TEST_CASE(ResampleIsIdenticalOnEveryIsa)
+{
+    const int sizes[][4] = { { 32, 32, 16, 16 }, { 16, 16, 32, 32 }, { 48, 48, 20, 20 }, { 256, 256, 32, 32 },
+        { 7, 5, 13, 11 }, { 33, 17, 9, 30 }, { 1, 1, 16, 16 } };
+    for (const auto& s : sizes) {
+        const int srcStride = s[0] + 3, dstStride = s[2] + 5;
+        const auto src = IconSamples::RandomPixels(static_cast<std::size_t>(srcStride) * s[1], s[0] * 31 + s[2]);
+        for (auto filter : { IconKernels::Filter::Box, IconKernels::Filter::Lanczos3 }) {
+            CheckSameOnEveryIsa([&] {
+                std::vector<std::uint32_t> dst(static_cast<std::size_t>(dstStride) * s[3], kPadding);
+                IconKernels::Resample(src.data(), s[0], s[1], srcStride, dst.data(), s[2], s[3], dstStride, filter);
+                CHECK(PaddingIntact(dst, s[2], dstStride));
+                return dst;
+            });
+        }
+    }
+}
+
+TEST_CASE(AreaScalerIsIdenticalOnEveryIsa)
+{
+    const int sizes[][4] = { { 256, 256, 32, 32 }, { 48, 48, 16, 16 }, { 33, 17, 17, 9 }, { 20, 20, 20, 20 },
+        { 100, 7, 3, 7 } };
+    for (const auto& s : sizes) {
+        const auto src = IconSamples::RandomPixels(static_cast<std::size_t>(s[0]) * s[1], s[0] + s[2]);
+        const int dstStride = s[2] + 1;
+        CheckSameOnEveryIsa([&] {
+            std::vector<std::uint32_t> dst(static_cast<std::size_t>(dstStride) * s[3], kPadding);
+            IconKernels::AreaScaler scaler(s[0], s[1], dst.data(), s[2], s[3], dstStride);
+            for (int y = 0; y < s[1]; ++y) scaler.PushRow(src.data() + static_cast<std::size_t>(y) * s[0]);
+            CHECK(PaddingIntact(dst, s[2], dstStride));
+            return dst;
+        });
+    }
+}
+
+namespace {
+
+    // Source and output sizes for the scaling tests: down, up, odd ratios,
+    // one axis only, and 1 px
+    const int kScaleSizes[][4] = { { 256, 256, 32, 32 }, { 48, 48, 16, 16 }, { 32, 32, 20, 20 },
+        { 16, 16, 48, 48 }, { 7, 5, 13, 11 }, { 33, 17, 9, 30 }, { 24, 24, 24, 24 }, { 1, 1, 16, 16 },
+        { 16, 16, 1, 1 } };
+
+    const std::uint32_t kSolids[] = { 0xFF000000u, 0xFFFFFFFFu, 0xFF2060C0u, 0xFFD13438u, 0x80FF8000u,
+        0x01FFFFFFu, 0x00000000u };
+
+    // Runs `scale` into an output pre-filled with `fill` and returns it
+    template <typename Scale>
+    std::vector<std::uint32_t> ScaleInto(std::uint32_t fill, int dstHeight, int dstStride, Scale&& scale)
+    {
+        std::vector<std::uint32_t> dst(static_cast<std::size_t>(dstStride) * dstHeight, fill);
+        scale(dst.data());
+        return dst;
+    }
+
+    // Every output pixel must be written: two runs over different fills agree
+    template <typename Scale>
+    void CheckEveryPixelWritten(int dstWidth, int dstHeight, Scale&& scale)
+    {
+        const int dstStride = dstWidth + 3;
+        auto a = ScaleInto(kPadding, dstHeight, dstStride, scale);
+        auto b = ScaleInto(~kPadding, dstHeight, dstStride, scale);
+        for (int y = 0; y < dstHeight; ++y) {
+            for (int x = 0; x < dstStride; ++x) {
+                const std::size_t i = static_cast<std::size_t>(y) * dstStride + x;
+                if (x >= dstWidth) CHECK(a[i] == kPadding && b[i] == ~kPadding);
+                else if (a[i] != b[i]) {
+                    std::fprintf(stderr, "  %dx%d: (%d,%d) not written\n", dstWidth, dstHeight, x, y);
+                    CHECK_EQ(a[i], b[i]);
+                }
+            }
+        }
+    }
+
+    void CheckSolid(const std::vector<std::uint32_t>& dst, int dstWidth, int dstHeight, std::uint32_t color,
+        const char* what)
+    {
+        for (int y = 0; y < dstHeight; ++y) {
+            for (int x = 0; x < dstWidth; ++x) {
+                const std::uint32_t p = dst[static_cast<std::size_t>(y) * dstWidth + x];
+                if (p != color) {
+                    std::fprintf(stderr, "  %s %dx%d: %08X became %08X at (%d,%d)\n", what, dstWidth, dstHeight,
+                        color, p, x, y);
+                    CHECK_EQ(p, color);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(ResampleKeepsSolidColors)
+{
+    for (const auto& s : kScaleSizes) {
+        for (std::uint32_t color : kSolids) {
+            const std::vector<std::uint32_t> src(static_cast<std::size_t>(s[0]) * s[1], color);
+            for (Isa isa : IconSamples::SupportedIsas()) {
+                IconKernels::SelectIsa(isa);
+                for (auto filter : { IconKernels::Filter::Box, IconKernels::Filter::Lanczos3 }) {
+                    std::vector<std::uint32_t> dst(static_cast<std::size_t>(s[2]) * s[3], kPadding);
+                    IconKernels::Resample(src.data(), s[0], s[1], s[0], dst.data(), s[2], s[3], s[2], filter);
+                    CheckSolid(dst, s[2], s[3], color, filter == IconKernels::Filter::Box ? "box" : "lanczos3");
+                }
+            }
+        }
+    }
+    IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+}
+
+TEST_CASE(ResampleWritesEveryPixel)
+{
+    for (const auto& s : kScaleSizes) {
+        const auto src = IconSamples::RandomPixels(static_cast<std::size_t>(s[0]) * s[1], s[0] + s[3]);
+        for (auto filter : { IconKernels::Filter::Box, IconKernels::Filter::Lanczos3 }) {
+            CheckEveryPixelWritten(s[2], s[3], [&](std::uint32_t* dst) {
+                IconKernels::Resample(src.data(), s[0], s[1], s[0], dst, s[2], s[3], s[2] + 3, filter);
+            });
+        }
+    }
+}
+
+TEST_CASE(AreaScalerKeepsSolidColors)
+{
+    for (const auto& s : kScaleSizes) {
+        if (s[2] > s[0] || s[3] > s[1]) continue; // Reduction only
+        for (std::uint32_t color : kSolids) {
+            const std::vector<std::uint32_t> row(s[0], color);
+            for (Isa isa : IconSamples::SupportedIsas()) {
+                IconKernels::SelectIsa(isa);
+                std::vector<std::uint32_t> dst(static_cast<std::size_t>(s[2]) * s[3], kPadding);
+                IconKernels::AreaScaler scaler(s[0], s[1], dst.data(), s[2], s[3], s[2]);
+                for (int y = 0; y < s[1]; ++y) scaler.PushRow(row.data());
+                CheckSolid(dst, s[2], s[3], color, "area");
+            }
+        }
+    }
+    IconKernels::SelectIsa(IconKernels::BestSupportedIsa());
+}
+
+TEST_CASE(AreaScalerWritesEveryPixel)
+{
+    for (const auto& s : kScaleSizes) {
+        if (s[2] > s[0] || s[3] > s[1]) continue;
+        const auto src = IconSamples::RandomPixels(static_cast<std::size_t>(s[0]) * s[1], s[0] * 7 + s[3]);
+        CheckEveryPixelWritten(s[2], s[3], [&](std::uint32_t* dst) {
+            IconKernels::AreaScaler scaler(s[0], s[1], dst, s[2], s[3], s[2] + 3);
+            for (int y = 0; y < s[1]; ++y) scaler.PushRow(src.data() + static_cast<std::size_t>(y) * s[0]);
+        });
+    }
+}
+
+TEST_CASE(AreaScalerWritesRowsAsTheyComplete)
+{
+    // 48 -> 16: output row o is done once source row 3o + 2 is in; enlarging
+    // is refused outright
+    const std::vector<std::uint32_t> row(48, 0xFF2060C0u);
+    std::vector<std::uint32_t> dst(16 * 16, kPadding);
+    IconKernels::AreaScaler scaler(48, 48, dst.data(), 16, 16, 16);
+    for (int y = 0; y < 48; ++y) {
+        scaler.PushRow(row.data());
+        const int done = (y + 1) / 3;
+        CHECK_EQ(dst[static_cast<std::size_t>(std::max(0, done - 1)) * 16], done ? 0xFF2060C0u : kPadding);
+        if (done < 16) CHECK_EQ(dst[static_cast<std::size_t>(done) * 16], kPadding);
+    }
+    scaler.PushRow(row.data()); // Past the last row: ignored
+
+    std::vector<std::uint32_t> big(32 * 32, kPadding);
+    IconKernels::AreaScaler enlarge(16, 16, big.data(), 32, 32, 32);
+    for (int y = 0; y < 16; ++y) enlarge.PushRow(row.data());
+    CHECK(std::all_of(big.begin(), big.end(), [](std::uint32_t p) { return p == kPadding; }));
+}
+
+TEST_CASE(DrawCountBadgeIsIdenticalOnEveryIsa)
+{
+    for (int size : { 16, 20, 24, 32, 48, 64 }) {
+        for (int count : { 1, 9, 10, 99, 100 }) {
+            const auto icon = IconSamples::TileIcon(size, size + 2, 0xFFF0F0F0u, 0xFF2060C0u);
+            CheckSameOnEveryIsa([&] {
+                std::vector<std::uint32_t> pixels = icon;
+                IconKernels::DrawCountBadge(pixels.data(), size, size + 2, count);
+                CHECK(PaddingIntact(pixels, size, size + 2));
+                return pixels;
+            });
+        }
+    }
+}
+
+namespace {
+
+    // Expected badges at one dot per pixel (16-27 px icons): '#' text, 'R'
+    // opaque badge red, 'r' an anti-aliased edge, '.' untouched
+    struct BadgeArt {
+        int         count;
+        int         width;
+        const char* rows[7];
+    };
+
+    const BadgeArt kBadgeArt[] = {
+        { 1, 7, { ".rrRrr.",
+                  "rRR#RRr",
+                  "rR##RRr",
+                  "RRR#RRR",
+                  "rRR#RRr",
+                  "rR###Rr",
+                  ".rrRrr." } },
+        { 9, 7, { ".rrRrr.",
+                  "rR###Rr",
+                  "rR#R#Rr",
+                  "RR###RR",
+                  "rRRR#Rr",
+                  "rR###Rr",
+                  ".rrRrr." } },
+        { 10, 11, { ".rrRRRRRrr.",
+                    "rRR#RR###Rr",
+                    "rR##RR#R#Rr",
+                    "RRR#RR#R#RR",
+                    "rRR#RR#R#Rr",
+                    "rR###R###Rr",
+                    ".rrRRRRRrr." } },
+        { 99, 11, { ".rrRRRRRrr.",
+                    "rR###R###Rr",
+                    "rR#R#R#R#Rr",
+                    "RR###R###RR",
+                    "rRRR#RRR#Rr",
+                    "rR###R###Rr",
+                    ".rrRRRRRrr." } },
+        { 100, 15, { ".rrRRRRRRRRRrr.",
+                     "rR###R###RRRRRr",
+                     "rR#R#R#R#RR#RRr",
+                     "RR###R###R###RR",
+                     "rRRR#RRR#RR#RRr",
+                     "rR###R###RRRRRr",
+                     ".rrRRRRRRRRRrr." } },
+    };
+
+    char BadgeClass(std::uint32_t p)
+    {
+        if (p == 0) return '.';
+        if (p == 0xFFFFFFFFu) return '#';
+        if (p == 0xFFD13438u) return 'R';
+        // Over transparency an edge keeps the badge color at partial alpha
+        return (p & 0x00FFFFFFu) == 0x00D13438u ? 'r' : '?';
+    }
+
+    // Draws the badge on a transparent size x size icon and compares it with
+    // the art scaled by `dot`. At one dot per pixel the match is exact; larger
+    // badges must keep the text dots exact and the solid cells solid, while
+    // their edges only have to stay badge-colored and symmetric.
+    void CheckBadge(int size, const BadgeArt& art)
+    {
+        const int dot = std::max(1, (size + 4) / 16);
+        const int height = 7 * dot, width = art.width * dot;
+        const int top = size - height, left = size - width;
+        std::vector<std::uint32_t> pixels(static_cast<std::size_t>(size) * size, 0);
+        IconKernels::DrawCountBadge(pixels.data(), size, size, art.count);
+
+        int wrong = 0;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const std::uint32_t p = pixels[static_cast<std::size_t>(y) * size + x];
+                const char got = BadgeClass(p);
+                if (y < top || x < left) {
+                    wrong += got != '.';
+                    continue;
+                }
+                const char want = art.rows[(y - top) / dot][(x - left) / dot];
+                if (dot == 1 || want == '#' || want == 'R') wrong += got != want;
+                else wrong += got == '#' || got == '?';
+
+                // The capsule is symmetric both ways
+                const int my = top + size - 1 - y, mx = left + size - 1 - x;
+                const std::uint32_t mirror = pixels[static_cast<std::size_t>(my) * size + mx];
+                wrong += (p >> 24) != (mirror >> 24);
+            }
+        }
+        if (wrong) std::fprintf(stderr, "  %d px, count %d: %d pixels differ\n", size, art.count, wrong);
+        CHECK_EQ(wrong, 0);
+    }
+}
+
+TEST_CASE(DrawCountBadgeMatchesTheReference)
+{
+    for (int size : { 16, 20, 24, 32, 48 }) {
+        for (const BadgeArt& art : kBadgeArt) CheckBadge(size, art);
+    }
+}
+
+TEST_CASE(DrawCountBadgeOverAnOpaqueIcon)
+{
+    for (int size : { 16, 20, 24, 32, 48 }) {
+        const int dot = std::max(1, (size + 4) / 16);
+        for (const BadgeArt& art : kBadgeArt) {
+            const auto icon = IconSamples::TileIcon(size, size + 2, 0xFFF0F0F0u, 0xFF2060C0u);
+            std::vector<std::uint32_t> pixels = icon;
+            IconKernels::DrawCountBadge(pixels.data(), size, size + 2, art.count);
+            CHECK(PaddingIntact(pixels, size, size + 2));
+
+            const int top = size - 7 * dot, left = size - art.width * dot;
+            for (int y = 0; y < size; ++y) {
+                for (int x = 0; x < size; ++x) {
+                    const std::size_t i = static_cast<std::size_t>(y) * (size + 2) + x;
+                    if (y < top || x < left) {
+                        CHECK(pixels[i] == icon[i]);
+                        continue;
+                    }
+                    const char want = art.rows[(y - top) / dot][(x - left) / dot];
+                    if (want == '#') CHECK(pixels[i] == 0xFFFFFFFFu);
+                    else if (want == 'R') CHECK(pixels[i] == 0xFFD13438u);
+                    else CHECK((pixels[i] >> 24) == 0xFF);   // Edges blend, the icon stays opaque
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(DrawCountBadgeLeavesSmallIconsAlone)
+{
+    for (int size = 1; size < 16; ++size) {
+        const auto icon = IconSamples::TileIcon(size, size + 2, 0xFFF0F0F0u, 0xFF2060C0u);
+        for (const BadgeArt& art : kBadgeArt) {
+            std::vector<std::uint32_t> pixels = icon;
+            IconKernels::DrawCountBadge(pixels.data(), size, size + 2, art.count);
+            CHECK(pixels == icon);
+        }
+    }
+
+    // No count, no badge
+    const auto icon = IconSamples::TileIcon(32, 32, 0xFFF0F0F0u, 0xFF2060C0u);
+    for (int count : { 0, -1 }) {
+        std::vector<std::uint32_t> pixels = icon;
+        IconKernels::DrawCountBadge(pixels.data(), 32, 32, count);
+        CHECK(pixels == icon);
+    }
+}
+
+TEST_CASE(DecontaminateEdgesHandWorked)
+{
+    // On white: 7F7F7F is black at 128/255 coverage and FF7F7F red at the
+    // same, so both come back as that alpha over a pure color
+    std::vector<std::uint32_t> pixels = {
+        0, 0xFF7F7F7Fu, 0xFF7F7F7Fu, 0xFF000000u, 0, 0xFFFF7F7Fu, 0xFFFFFFFFu,
+        0, 0x807F7F7Fu, 0x00123456u, 0xFF7F7F7Fu, 0xFF7F7F7Fu, 0xFF7F7F7Fu, 0,
+    };
+    std::vector<std::uint8_t> mask = {
+        1, 0, 0, 0, 1, 0, 0,
+        1, 0, 0, 0, 0, 0, 1,
+    };
+    const std::uint32_t expected[] = {
+        0, 0x80000000u,                // Next to a cleared pixel
+        0xFF7F7F7Fu,                   // Not next to one: untouched
+        0xFF000000u,                   // Fully covered: untouched
+        0, 0x80FF0000u,
+        0,                             // The background itself has no coverage
+        0, 0x40000000u,                // Half the source alpha carries over
+        0x00123456u,                   // Transparent: untouched
+        0xFF7F7F7Fu, 0x80000000u, 0x80000000u, 0,
+    };
+    CHECK_EQ(IconKernels::DecontaminateEdges(pixels.data(), 7, 2, 7, 0xFFFFFFFFu, mask), 6u);
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+        if (pixels[i] != expected[i]) std::fprintf(stderr, "  pixel %zu: %08X\n", i, pixels[i]);
+        CHECK_EQ(pixels[i], expected[i]);
+    }
+
+    // A mask smaller than the image is refused
+    mask.resize(10);
+    CHECK_EQ(IconKernels::DecontaminateEdges(pixels.data(), 7, 2, 7, 0xFFFFFFFFu, mask), 0u);
+}
+
+TEST_CASE(DecontaminateEdgesOnTileIcons)
+{
+    // Edge pixels of a tile icon are Blend(fg, bg, coverage). The kernel
+    // takes the smallest coverage that explains the pixel, which is the true
+    // one when every channel of fg sits at 0 or 255 (and bg leaves room to
+    // measure it); otherwise the result must at least composite back over bg
+    // to what was there.
+    struct Case { std::uint32_t bg, fg; bool exact; };
+    const Case cases[] = {
+        { 0xFFF0F0F0u, 0xFF000000u, true }, { 0xFF808080u, 0xFF0000FFu, true },
+        { 0xFF808080u, 0xFFFFFF00u, true }, { 0xFFF0F0F0u, 0xFF2060C0u, false },
+        { 0xFFF0F0F0u, 0xFFE01010u, false },
+    };
+    std::vector<IconKernels::FillSeed> stack;
+    for (const Case& c : cases) {
+        const std::uint32_t bg = c.bg;
+        for (int size : { 16, 32, 48, 64 }) {
+            const int stride = size + 1;
+            std::vector<std::uint32_t> pixels = IconSamples::TileIcon(size, stride, bg, c.fg);
+            std::vector<std::uint8_t> mask;
+            IconKernels::FloodFillCorners(pixels.data(), size, size, stride, stack, 0, &mask);
+            const auto filled = pixels;
+            IconKernels::DecontaminateEdges(pixels.data(), size, size, stride, bg, mask);
+            CHECK(PaddingIntact(pixels, size, stride));
+
+            auto cleared = [&](int x, int y) {
+                return x >= 0 && y >= 0 && x < size && y < size && mask[static_cast<std::size_t>(y) * size + x];
+            };
+            for (int y = 0; y < size; ++y) {
+                for (int x = 0; x < size; ++x) {
+                    const std::size_t i = static_cast<std::size_t>(y) * stride + x;
+                    const bool edge = !cleared(x, y) &&
+                        (cleared(x - 1, y) || cleared(x + 1, y) || cleared(x, y - 1) || cleared(x, y + 1));
+                    const float coverage = IconSamples::TileCoverage(size, x, y);
+                    if (!edge || coverage >= 1.0f) {
+                        CHECK_EQ(pixels[i], filled[i]);
+                        continue;
+                    }
+
+                    // Both the blend and the result were rounded to 8 bits
+                    const int alpha = static_cast<int>(pixels[i] >> 24);
+                    const std::uint32_t back = IconSamples::Blend(pixels[i] | 0xFF000000u, bg, alpha / 255.0f);
+                    bool ok = Near(back, filled[i], 2);
+                    if (c.exact) {
+                        ok = ok && std::abs(alpha - static_cast<int>(coverage * 255.0f + 0.5f)) <= 2;
+                        if (alpha >= 64) ok = ok && Near(pixels[i] | 0xFF000000u, c.fg, 4);
+                    }
+                    else {
+                        ok = ok && alpha <= static_cast<int>(coverage * 255.0f + 0.5f) + 2;
+                    }
+                    if (!ok) {
+                        std::fprintf(stderr, "  fg %08X size %d (%d,%d): coverage %.3f gave %08X\n",
+                            c.fg, size, x, y, coverage, pixels[i]);
+                    }
+                    CHECK(ok);
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    return TestHarness::RunAll();
+}
@@ -0,0 +1,122 @@
+#pragma once
+#ifndef ICONSAMPLES_H
+#define ICONSAMPLES_H
+
+// Synthetic icons for the kernel tests and benchmarks. Everything is seeded,
+// so a failure reproduces and timings compare across runs.
+
+#include "IconKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace IconSamples {
+
+    // Written to the padding between rows; kernels must never touch it.
+    const std::uint32_t kPadding = 0xDEADBEEFu;
+
+    // xorshift32, the same sequence everywhere
+    class Random {
+    public:
+        explicit Random(std::uint32_t seed) : state_(seed ? seed : 1) {}
+
+        std::uint32_t Next()
+        {
+            state_ ^= state_ << 13;
+            state_ ^= state_ >> 17;
+            state_ ^= state_ << 5;
+            return state_;
+        }
+
+        int Below(int n) { return static_cast<int>(Next() % static_cast<std::uint32_t>(n)); }
+
+    private:
+        std::uint32_t state_;
+    };
+
+    // Instruction sets this CPU can run, scalar first.
+    inline std::vector<IconKernels::Isa> SupportedIsas()
+    {
+        std::vector<IconKernels::Isa> isas;
+        for (IconKernels::Isa isa : { IconKernels::Isa::Scalar, IconKernels::Isa::Sse2, IconKernels::Isa::Avx2 }) {
+            if (static_cast<int>(isa) <= static_cast<int>(IconKernels::BestSupportedIsa())) isas.push_back(isa);
+        }
+        return isas;
+    }
+
+    inline std::uint32_t Pack(int a, int r, int g, int b)
+    {
+        return (std::uint32_t(a) << 24) | (std::uint32_t(r) << 16) | (std::uint32_t(g) << 8) | std::uint32_t(b);
+    }
+
+    // Opaque `fg` over opaque `bg` at `coverage` (0-1), as an anti-aliased
+    // edge is rendered onto its tile
+    inline std::uint32_t Blend(std::uint32_t fg, std::uint32_t bg, float coverage)
+    {
+        int c[3];
+        for (int i = 0; i < 3; ++i) {
+            const int shift = 16 - 8 * i;
+            const float f = float((fg >> shift) & 0xFF), b = float((bg >> shift) & 0xFF);
+            c[i] = static_cast<int>(b + (f - b) * coverage + 0.5f);
+        }
+        return Pack(255, c[0], c[1], c[2]);
+    }
+
+    // Each color channel moved by up to +-amount, alpha kept
+    inline std::uint32_t Jitter(std::uint32_t p, int amount, Random& rng)
+    {
+        if (amount <= 0) return p;
+        std::uint32_t out = p & 0xFF000000u;
+        for (int shift = 0; shift < 24; shift += 8) {
+            const int v = static_cast<int>((p >> shift) & 0xFF) + rng.Below(2 * amount + 1) - amount;
+            out |= std::uint32_t(std::min(255, std::max(0, v))) << shift;
+        }
+        return out;
+    }
+
+    // Foreground share (0-1) of pixel (x, y) in TileIcon: a ring with
+    // background inside it (unreachable from the corners) around a small
+    // disc, edges blended over one pixel
+    inline float TileCoverage(int size, int x, int y)
+    {
+        const float c = size * 0.5f;
+        const float outer = size * 0.42f, inner = size * 0.30f, dot = size * 0.12f;
+        const float d = std::hypot(x + 0.5f - c, y + 0.5f - c);
+        auto edge = [d](float r) { return std::min(1.0f, std::max(0.0f, r - d + 0.5f)); };
+        return std::max(std::min(edge(outer), 1.0f - edge(inner)), edge(dot));
+    }
+
+    // An app icon drawn on an opaque tile, shaped as TileCoverage describes.
+    // The background is jittered by up to `noise` per channel. Rows are
+    // `stride` pixels apart; the padding holds kPadding.
+    inline std::vector<std::uint32_t> TileIcon(int size, int stride, std::uint32_t background,
+        std::uint32_t foreground, int noise = 0, std::uint32_t seed = 1)
+    {
+        std::vector<std::uint32_t> pixels(static_cast<std::size_t>(stride) * size, kPadding);
+        Random rng(seed);
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const float coverage = TileCoverage(size, x, y);
+                const std::uint32_t bg = (x == 0 && y == 0) ? background : Jitter(background, noise, rng);
+                pixels[static_cast<std::size_t>(y) * stride + x] =
+                    coverage <= 0.0f ? bg : Blend(foreground, background, coverage);
+            }
+        }
+        return pixels;
+    }
+
+    // Any ARGB value, alpha included, with runs of repeats so matches occur
+    inline std::vector<std::uint32_t> RandomPixels(std::size_t n, std::uint32_t seed)
+    {
+        Random rng(seed);
+        std::vector<std::uint32_t> pixels(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            pixels[i] = (i > 0 && rng.Below(3) == 0) ? pixels[i - 1] : rng.Next();
+        }
+        return pixels;
+    }
+
+} // namespace IconSamples
+
+#endif // ICONSAMPLES_H
@@ -0,0 +1,91 @@
+// Finding an icon in an exe's resources. On Windows the same files also go
+// through ExtractIconExW, the call IconPipeline's PE reader replaced; elsewhere
+// only the reader runs.
+#include "PeIcons.h"
+#include "PeSamples.h"
+#include "TestData.h"
+#include "BenchHarness.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <shellapi.h>
+#endif
+
+using namespace BenchHarness;
+
+namespace {
+
+    // Reads the file and picks the 32 px image, as IconPipeline does per
+    // lookup (it maps the file rather than reading it)
+    bool ReadAndFind(const std::string& path, PeIcons::IconImage& image)
+    {
+        const std::vector<std::uint8_t> file = TestData::ReadFile(path);
+        return PeIcons::FindIcon(file.data(), file.size(), 0, 32, image);
+    }
+
+    void BenchFile(const std::string& path, const char* label, int calls)
+    {
+        char name[96];
+        std::snprintf(name, sizeof(name), "%-24s read + FindIcon", label);
+        Report(name, NanosPerItem(calls, [&] {
+            std::uint64_t found = 0;
+            for (int i = 0; i < calls; ++i) {
+                PeIcons::IconImage image;
+                found += ReadAndFind(path, image);
+            }
+            Consume(found);
+        }), "call");
+
+#ifdef _WIN32
+        const std::wstring wide(path.begin(), path.end());
+        std::snprintf(name, sizeof(name), "%-24s ExtractIconExW", label);
+        Report(name, NanosPerItem(calls, [&] {
+            std::uint64_t found = 0;
+            for (int i = 0; i < calls; ++i) {
+                HICON large = nullptr;
+                if (::ExtractIconExW(wide.c_str(), 0, &large, nullptr, 1) == 1 && large) {
+                    ++found;
+                    ::DestroyIcon(large);
+                }
+            }
+            Consume(found);
+        }), "call");
+#endif
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Init(argc, argv);
+    const int calls = Quick() ? 2 : 200;
+
+    // In memory: the resource walk alone
+    for (bool plus : { false, true }) {
+        const auto pe = PeSamples::BuildPe(plus, PeSamples::AppIconGroups());
+        for (int size : { 16, 32, 256 }) {
+            char name[96];
+            std::snprintf(name, sizeof(name), "%s in memory, %3d px", plus ? "PE32+" : "PE32 ", size);
+            Report(name, NanosPerItem(calls * 100, [&] {
+                std::uint64_t width = 0;
+                for (int i = 0; i < calls * 100; ++i) {
+                    PeIcons::IconImage image;
+                    if (PeIcons::FindIcon(pe.data(), pe.size(), 0, size, image)) width += image.width;
+                }
+                Consume(width);
+            }), "call");
+        }
+    }
+
+    BenchFile(TestData::Path("VirtualDesktopAccessor.dll"), "no icon (VDA dll)", calls);
+#ifdef _WIN32
+    char windows[MAX_PATH];
+    if (::GetWindowsDirectoryA(windows, MAX_PATH)) {
+        BenchFile(std::string(windows) + "\\explorer.exe", "explorer.exe", calls);
+        BenchFile(std::string(windows) + "\\System32\\notepad.exe", "notepad.exe", calls);
+        BenchFile(std::string(windows) + "\\System32\\shell32.dll", "shell32.dll", calls);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include "PeIcons.h"
+#include "PeSamples.h"
+#include "IconSamples.h"
+#include "TestData.h"
+#include "TestHarness.h"
+
+namespace {
+
+    struct Expect {
+        int  target;
+        int  width;
+        int  bitCount;
+        bool png;
+    };
+
+    // Best image per requested size in AppIconGroups' first group
+    const Expect kMainIcon[] = {
+        { 16, 16, 32, false },   // Exact size, deeper color wins
+        { 20, 32, 32, false },   // Smallest larger
+        { 32, 32, 32, false },
+        { 40, 48, 32, false },
+        { 48, 48, 32, false },
+        { 64, 256, 32, true },
+        { 256, 256, 32, true },
+        { 512, 256, 32, true },  // Nothing larger: largest smaller
+    };
+
+    bool Inside(const PeIcons::IconImage& image, const std::vector<std::uint8_t>& file)
+    {
+        return image.data >= file.data() && image.size <= file.size() &&
+            static_cast<std::size_t>(image.data - file.data()) <= file.size() - image.size;
+    }
+
+    void CheckMainIcon(const std::vector<std::uint8_t>& pe, int group)
+    {
+        for (const Expect& e : kMainIcon) {
+            PeIcons::IconImage image;
+            CHECK(PeIcons::FindIcon(pe.data(), pe.size(), group, e.target, image));
+            if (image.width != e.width || image.bitCount != e.bitCount || image.png != e.png) {
+                std::fprintf(stderr, "  target %d: got %d px %d bpp%s\n", e.target, image.width, image.bitCount,
+                    image.png ? " png" : "");
+            }
+            CHECK_EQ(image.width, e.width);
+            CHECK_EQ(image.height, e.width);
+            CHECK_EQ(image.bitCount, e.bitCount);
+            CHECK_EQ(image.png, e.png);
+            CHECK(Inside(image, pe));
+        }
+    }
+
+    // FindIcon on an exact-size copy of the first `size` bytes, so reading
+    // past the end is an out-of-bounds access rather than stale data
+    void FindOnCopy(const std::uint8_t* data, std::size_t size, int group, int target)
+    {
+        const std::vector<std::uint8_t> copy(data, data + size);
+        PeIcons::IconImage image;
+        if (PeIcons::FindIcon(copy.data(), copy.size(), group, target, image)) {
+            CHECK(Inside(image, copy));
+            CHECK(image.width > 0 && image.height > 0);
+        }
+    }
+}
+
+TEST_CASE(Pe32FindsEverySize)
+{
+    const auto pe = PeSamples::BuildPe(false, PeSamples::AppIconGroups());
+    CheckMainIcon(pe, 0);
+}
+
+TEST_CASE(Pe32PlusFindsEverySize)
+{
+    const auto pe = PeSamples::BuildPe(true, PeSamples::AppIconGroups());
+    CheckMainIcon(pe, 0);
+}
+
+TEST_CASE(GroupsByIndexAndById)
+{
+    const auto pe = PeSamples::BuildPe(true, PeSamples::AppIconGroups());
+    PeIcons::IconImage image;
+
+    // Index 1 and id 7 are the document icon: 24 and 32 px only
+    CHECK(PeIcons::FindIcon(pe.data(), pe.size(), 1, 16, image));
+    CHECK_EQ(image.width, 24);
+    CHECK(PeIcons::FindIcon(pe.data(), pe.size(), -7, 32, image));
+    CHECK_EQ(image.width, 32);
+    CHECK(PeIcons::FindIcon(pe.data(), pe.size(), -7, 48, image));
+    CHECK_EQ(image.width, 32);
+
+    // Id 1 is the main icon
+    CheckMainIcon(pe, -1);
+
+    CHECK(!PeIcons::FindIcon(pe.data(), pe.size(), 2, 32, image));    // Past the last group
+    CHECK(!PeIcons::FindIcon(pe.data(), pe.size(), -2, 32, image));   // No such id
+    CHECK(!PeIcons::FindIcon(pe.data(), pe.size(), 0, 0, image));     // No size asked for
+}
+
+TEST_CASE(ImageDataWinsOverTheGroupDirectory)
+{
+    // The directory claims 32 px, the bitmap is 48
+    const auto pe = PeSamples::BuildPe(false, { { 1, { { 48, 32, false, 1, 32 }, { 16, 32, false, 2 } } } });
+    PeIcons::IconImage image;
+    CHECK(PeIcons::FindIcon(pe.data(), pe.size(), 0, 48, image));
+    CHECK_EQ(image.width, 48);
+    CHECK(PeIcons::FindIcon(pe.data(), pe.size(), 0, 32, image));
+    CHECK_EQ(image.width, 48);
+}
+
+TEST_CASE(MissingIconImagesAreSkipped)
+{
+    // The 32 px image is listed but not stored; the next best is used
+    auto groups = PeSamples::AppIconGroups();
+    groups[0].icons[2].stored = false;
+    auto pe = PeSamples::BuildPe(false, groups);
+    PeIcons::IconImage image;
+    CHECK(PeIcons::FindIcon(pe.data(), pe.size(), 0, 32, image));
+    CHECK_EQ(image.width, 48);
+
+    // None of the group's images stored
+    pe = PeSamples::BuildPe(false, { { 1, { { 32, 32, false, 1, -1, false } } }, { 2, { { 16, 32, false, 2 } } } });
+    CHECK(!PeIcons::FindIcon(pe.data(), pe.size(), 0, 32, image));
+    CHECK(PeIcons::FindIcon(pe.data(), pe.size(), 1, 32, image));
+}
+
+TEST_CASE(VirtualDesktopAccessorHasNoIcon)
+{
+    const auto dll = TestData::ReadFile(TestData::Path("VirtualDesktopAccessor.dll"));
+    CHECK(dll.size() > 4096);
+    PeIcons::IconImage image;
+    for (int group : { 0, 1, -1 }) {
+        for (int size : { 16, 32, 256 }) CHECK(!PeIcons::FindIcon(dll.data(), dll.size(), group, size, image));
+    }
+}
+
+TEST_CASE(NotAPeFile)
+{
+    PeIcons::IconImage image;
+    const std::vector<std::uint8_t> text(4096, 'x');
+    CHECK(!PeIcons::FindIcon(text.data(), text.size(), 0, 32, image));
+    CHECK(!PeIcons::FindIcon(nullptr, 0, 0, 32, image));
+
+    // Right signatures, unknown optional header magic
+    auto pe = PeSamples::BuildPe(false, PeSamples::AppIconGroups());
+    pe[0x98] = 0x07;
+    pe[0x99] = 0x01;
+    CHECK(!PeIcons::FindIcon(pe.data(), pe.size(), 0, 32, image));
+}
+
+TEST_CASE(TruncatedImagesFailCleanly)
+{
+    for (bool plus : { false, true }) {
+        const auto pe = PeSamples::BuildPe(plus, PeSamples::AppIconGroups());
+        for (std::size_t size = 0; size < pe.size(); ++size) FindOnCopy(pe.data(), size, 0, 32);
+
+        // Cut inside the resource section: the early images are still there
+        PeIcons::IconImage image;
+        std::size_t smallest = pe.size();
+        while (smallest > 0 && PeIcons::FindIcon(pe.data(), smallest - 1, 0, 32, image)) --smallest;
+        CHECK(smallest > PeSamples::kResourceRaw);
+    }
+}
+
+TEST_CASE(MutatedImagesFailCleanly)
+{
+    IconSamples::Random rng(42);
+    for (bool plus : { false, true }) {
+        const auto pe = PeSamples::BuildPe(plus, PeSamples::AppIconGroups());
+        // Headers and the directory tree are where the offsets live, so
+        // most mutations land there
+        const std::size_t hot = PeSamples::kResourceRaw + 0x200;
+        for (int round = 0; round < 20000; ++round) {
+            std::vector<std::uint8_t> m = pe;
+            const int flips = 1 + rng.Below(4);
+            for (int i = 0; i < flips; ++i) {
+                const std::size_t at = rng.Below(4) ? static_cast<std::size_t>(rng.Below(static_cast<int>(hot)))
+                                                    : static_cast<std::size_t>(rng.Below(static_cast<int>(m.size())));
+                switch (rng.Below(3)) {
+                case 0: m[at] ^= std::uint8_t(1u << rng.Below(8)); break;
+                case 1: m[at] = 0xFF; break;
+                default: m[at] = std::uint8_t(rng.Next()); break;
+                }
+            }
+            FindOnCopy(m.data(), m.size(), rng.Below(3) - 1, 16 << rng.Below(5));
+        }
+    }
+}
+
+int main()
+{
+    return TestHarness::RunAll();
+}
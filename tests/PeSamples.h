@@ -0,0 +1,220 @@
+#pragma once
+#ifndef PESAMPLES_H
+#define PESAMPLES_H
+
+// Minimal PE32 / PE32+ images with an icon resource tree, built in memory for
+// the PeIcons tests and benchmark. Only what a resource walk reads is filled
+// in; there is no code.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace PeSamples {
+
+    // One RT_ICON image. `declaredWidth` is what the group directory claims
+    // (-1: the real width), to check that the image data wins; with `stored`
+    // false the group lists the image but the RT_ICON is missing.
+    struct IconSpec {
+        int           width;
+        int           bitCount;
+        bool          png;
+        std::uint16_t id;
+        int           declaredWidth = -1;
+        bool          stored = true;
+    };
+
+    // One RT_GROUP_ICON, listing its images in order
+    struct GroupSpec {
+        std::uint16_t         id;
+        std::vector<IconSpec> icons;
+    };
+
+    const std::uint32_t kResourceRva = 0x2000;
+    const std::uint32_t kResourceRaw = 0x600;
+
+    inline void Put16(std::vector<std::uint8_t>& b, std::size_t at, std::uint32_t v)
+    {
+        b[at] = std::uint8_t(v);
+        b[at + 1] = std::uint8_t(v >> 8);
+    }
+
+    inline void Put32(std::vector<std::uint8_t>& b, std::size_t at, std::uint32_t v)
+    {
+        Put16(b, at, v & 0xFFFF);
+        Put16(b, at + 2, v >> 16);
+    }
+
+    inline void PutBe32(std::vector<std::uint8_t>& b, std::size_t at, std::uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i) b[at + i] = std::uint8_t(v >> (24 - 8 * i));
+    }
+
+    // RT_ICON data: a PNG header, or a DIB with palette, XOR and AND rows
+    inline std::vector<std::uint8_t> IconData(const IconSpec& icon)
+    {
+        std::vector<std::uint8_t> d;
+        if (icon.png) {
+            static const std::uint8_t kHead[16] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n',
+                0, 0, 0, 13, 'I', 'H', 'D', 'R' };
+            d.assign(kHead, kHead + 16);
+            d.resize(16 + 13 + 4 + 12, 0);
+            PutBe32(d, 16, icon.width);
+            PutBe32(d, 20, icon.width);
+            d[24] = 8;
+            d[25] = 6;
+            std::memcpy(&d[37], "IEND", 4);
+            return d;
+        }
+        const int colors = icon.bitCount <= 8 ? 1 << icon.bitCount : 0;
+        const std::size_t xorRow = ((icon.width * icon.bitCount + 31) / 32) * 4;
+        const std::size_t andRow = ((icon.width + 31) / 32) * 4;
+        d.resize(40 + colors * 4 + (xorRow + andRow) * icon.width, 0);
+        Put32(d, 0, 40);
+        Put32(d, 4, icon.width);
+        Put32(d, 8, icon.width * 2);
+        Put16(d, 12, 1);
+        Put16(d, 14, icon.bitCount);
+        for (std::size_t i = 40; i < d.size(); ++i) d[i] = std::uint8_t(i * 7);
+        return d;
+    }
+
+    // Resource section contents, laid out as the linker does: directories,
+    // then data entries, then data
+    class ResourceWriter {
+    public:
+        std::size_t Directory(std::size_t ids)
+        {
+            const std::size_t at = blob_.size();
+            blob_.resize(at + 16 + ids * 8, 0);
+            Put16(blob_, at + 14, static_cast<std::uint32_t>(ids));
+            return at;
+        }
+
+        void Entry(std::size_t dir, std::size_t index, std::uint32_t id, std::size_t target, bool subdirectory)
+        {
+            const std::size_t at = dir + 16 + index * 8;
+            Put32(blob_, at, id);
+            Put32(blob_, at + 4, static_cast<std::uint32_t>(target) | (subdirectory ? 0x80000000u : 0));
+        }
+
+        // A language directory with one data entry for `data`
+        std::size_t Leaf(std::vector<std::uint8_t> data)
+        {
+            const std::size_t lang = Directory(1);
+            const std::size_t leaf = blob_.size();
+            blob_.resize(leaf + 16, 0);
+            Entry(lang, 0, 0x409, leaf, false);
+            pending_.push_back({ leaf, std::move(data) });
+            return lang;
+        }
+
+        std::vector<std::uint8_t> Finish()
+        {
+            for (auto& p : pending_) {
+                blob_.resize((blob_.size() + 3) & ~std::size_t(3), 0);
+                Put32(blob_, p.leaf, kResourceRva + static_cast<std::uint32_t>(blob_.size()));
+                Put32(blob_, p.leaf + 4, static_cast<std::uint32_t>(p.data.size()));
+                blob_.insert(blob_.end(), p.data.begin(), p.data.end());
+            }
+            return blob_;
+        }
+
+    private:
+        struct Pending {
+            std::size_t               leaf;
+            std::vector<std::uint8_t> data;
+        };
+        std::vector<std::uint8_t> blob_;
+        std::vector<Pending>      pending_;
+    };
+
+    // A DLL-shaped image: headers, an empty .text and the .rsrc section
+    inline std::vector<std::uint8_t> BuildPe(bool pe32Plus, const std::vector<GroupSpec>& groups)
+    {
+        std::vector<const IconSpec*> icons;
+        for (const GroupSpec& g : groups) {
+            for (const IconSpec& i : g.icons) {
+                if (i.stored) icons.push_back(&i);
+            }
+        }
+
+        ResourceWriter w;
+        const std::size_t root = w.Directory(2);
+        const std::size_t iconType = w.Directory(icons.size());
+        const std::size_t groupType = w.Directory(groups.size());
+        w.Entry(root, 0, 3, iconType, true);
+        w.Entry(root, 1, 14, groupType, true);
+        for (std::size_t i = 0; i < icons.size(); ++i) {
+            w.Entry(iconType, i, icons[i]->id, w.Leaf(IconData(*icons[i])), true);
+        }
+        for (std::size_t gi = 0; gi < groups.size(); ++gi) {
+            const GroupSpec& g = groups[gi];
+            std::vector<std::uint8_t> dir(6 + g.icons.size() * 14, 0);
+            Put16(dir, 2, 1);
+            Put16(dir, 4, static_cast<std::uint32_t>(g.icons.size()));
+            for (std::size_t i = 0; i < g.icons.size(); ++i) {
+                const IconSpec& icon = g.icons[i];
+                const int declared = icon.declaredWidth >= 0 ? icon.declaredWidth : icon.width;
+                const std::size_t at = 6 + i * 14;
+                dir[at] = dir[at + 1] = std::uint8_t(declared >= 256 ? 0 : declared);
+                Put16(dir, at + 4, 1);
+                Put16(dir, at + 6, icon.bitCount);
+                Put32(dir, at + 8, static_cast<std::uint32_t>(IconData(icon).size()));
+                Put16(dir, at + 12, icon.id);
+            }
+            w.Entry(groupType, gi, g.id, w.Leaf(dir), true);
+        }
+        const std::vector<std::uint8_t> rsrc = w.Finish();
+        const std::uint32_t rsrcRawSize = (static_cast<std::uint32_t>(rsrc.size()) + 0x1FF) & ~0x1FFu;
+
+        std::vector<std::uint8_t> pe(kResourceRaw + rsrcRawSize, 0);
+        pe[0] = 'M';
+        pe[1] = 'Z';
+        Put32(pe, 0x3C, 0x80);
+        std::memcpy(&pe[0x80], "PE\0\0", 4);
+
+        const std::size_t coff = 0x84;
+        const std::uint32_t optionalSize = pe32Plus ? 240 : 224;
+        Put16(pe, coff, pe32Plus ? 0x8664 : 0x14C);
+        Put16(pe, coff + 2, 2);
+        Put16(pe, coff + 16, optionalSize);
+        Put16(pe, coff + 18, 0x2102);
+
+        const std::size_t opt = coff + 20;
+        Put16(pe, opt, pe32Plus ? 0x20B : 0x10B);
+        const std::size_t dirs = opt + (pe32Plus ? 112 : 96);
+        Put32(pe, dirs - 4, 16);
+        Put32(pe, dirs + 2 * 8, kResourceRva);
+        Put32(pe, dirs + 2 * 8 + 4, static_cast<std::uint32_t>(rsrc.size()));
+
+        const std::size_t sections = opt + optionalSize;
+        std::memcpy(&pe[sections], ".text", 5);
+        Put32(pe, sections + 8, 0x100);
+        Put32(pe, sections + 12, 0x1000);
+        Put32(pe, sections + 16, 0x200);
+        Put32(pe, sections + 20, 0x400);
+        std::memcpy(&pe[sections + 40], ".rsrc", 5);
+        Put32(pe, sections + 40 + 8, static_cast<std::uint32_t>(rsrc.size()));
+        Put32(pe, sections + 40 + 12, kResourceRva);
+        Put32(pe, sections + 40 + 16, rsrcRawSize);
+        Put32(pe, sections + 40 + 20, kResourceRaw);
+
+        std::copy(rsrc.begin(), rsrc.end(), pe.begin() + kResourceRaw);
+        return pe;
+    }
+
+    // What a typical application exe carries: the main icon in five sizes
+    // and depths, with the 256 px one stored as PNG, plus a document icon
+    inline std::vector<GroupSpec> AppIconGroups()
+    {
+        return {
+            { 1, { { 16, 4, false, 1 }, { 16, 32, false, 2 }, { 32, 32, false, 3 }, { 48, 8, false, 4 },
+                   { 48, 32, false, 5 }, { 256, 32, true, 6 } } },
+            { 7, { { 32, 32, false, 7 }, { 24, 32, false, 8 } } },
+        };
+    }
+
+} // namespace PeSamples
+
+#endif // PESAMPLES_H
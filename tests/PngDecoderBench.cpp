@@ -0,0 +1,135 @@
+// Loading a large app logo as a small icon: the streaming decode into an area
+// scaler IconPipeline uses, against decoding the whole image first. On Windows
+// the same files also go through GDI+ the way LoadPngAsIcon used to (Bitmap,
+// DrawImage at icon size, GetHBITMAP).
+#include "PngDecoder.h"
+#include "IconKernels.h"
+#include "TestData.h"
+#include "BenchHarness.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <shlwapi.h>
+#include <gdiplus.h>
+#endif
+
+using namespace BenchHarness;
+
+namespace {
+
+    struct Logo {
+        std::string               name;
+        std::vector<std::uint8_t> file;
+        PngDecoder::Header        header;
+    };
+
+    int RunsFor(const PngDecoder::Header& header)
+    {
+        return Quick() ? 1 : (std::max)(1, (1 << 22) / (header.width * header.height));
+    }
+
+    void BenchDecode(const Logo& logo)
+    {
+        const int runs = RunsFor(logo.header);
+        const std::uint64_t pixels = static_cast<std::uint64_t>(runs) * logo.header.width * logo.header.height;
+        char name[96];
+        std::snprintf(name, sizeof(name), "%-15s decode only", logo.name.c_str());
+        Report(name, NanosPerItem(pixels, [&] {
+            std::uint64_t sum = 0;
+            for (int i = 0; i < runs; ++i) {
+                PngDecoder::Decode(logo.file.data(), logo.file.size(),
+                    [&](int, const std::uint32_t* row) { sum += row[0]; });
+            }
+            Consume(sum);
+        }), "px");
+    }
+
+    // ns per source pixel to produce a size x size icon
+    void BenchToIcon(const Logo& logo, int size)
+    {
+        const int w = logo.header.width, h = logo.header.height;
+        const int runs = RunsFor(logo.header);
+        const std::uint64_t pixels = static_cast<std::uint64_t>(runs) * w * h;
+        std::vector<std::uint32_t> icon(static_cast<std::size_t>(size) * size);
+        char name[96];
+
+        std::snprintf(name, sizeof(name), "%-15s -> %2d px  stream + area", logo.name.c_str(), size);
+        Report(name, NanosPerItem(pixels, [&] {
+            for (int i = 0; i < runs; ++i) {
+                IconKernels::AreaScaler scaler(w, h, icon.data(), size, size, size);
+                PngDecoder::Decode(logo.file.data(), logo.file.size(),
+                    [&](int, const std::uint32_t* row) { scaler.PushRow(row); });
+            }
+            Consume(icon[0]);
+        }), "px");
+
+        std::snprintf(name, sizeof(name), "%-15s -> %2d px  full decode + box", logo.name.c_str(), size);
+        Report(name, NanosPerItem(pixels, [&] {
+            for (int i = 0; i < runs; ++i) {
+                std::vector<std::uint32_t> full(static_cast<std::size_t>(w) * h);
+                PngDecoder::Decode(logo.file.data(), logo.file.size(), [&](int y, const std::uint32_t* row) {
+                    std::copy(row, row + w, full.data() + static_cast<std::size_t>(y) * w);
+                });
+                IconKernels::Resample(full.data(), w, h, w, icon.data(), size, size, size, IconKernels::Filter::Box);
+            }
+            Consume(icon[0]);
+        }), "px");
+
+#ifdef _WIN32
+        std::snprintf(name, sizeof(name), "%-15s -> %2d px  GDI+", logo.name.c_str(), size);
+        Report(name, NanosPerItem(pixels, [&] {
+            std::uint64_t made = 0;
+            for (int i = 0; i < runs; ++i) {
+                IStream* stream = ::SHCreateMemStream(logo.file.data(), static_cast<UINT>(logo.file.size()));
+                if (!stream) continue;
+                {
+                    Gdiplus::Bitmap src(stream);
+                    Gdiplus::Bitmap dst(size, size, PixelFormat32bppARGB);
+                    Gdiplus::Graphics g(&dst);
+                    g.SetInterpolationMode(Gdiplus::InterpolationModeHighQualityBicubic);
+                    g.DrawImage(&src, 0, 0, size, size);
+                    HBITMAP bitmap = nullptr;
+                    if (dst.GetHBITMAP(Gdiplus::Color(0, 0, 0, 0), &bitmap) == Gdiplus::Ok && bitmap) {
+                        ++made;
+                        ::DeleteObject(bitmap);
+                    }
+                }
+                stream->Release();
+            }
+            Consume(made);
+        }), "px");
+#endif
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Init(argc, argv);
+#ifdef _WIN32
+    ULONG_PTR token = 0;
+    Gdiplus::GdiplusStartupInput si;
+    Gdiplus::GdiplusStartup(&token, &si, nullptr);
+#endif
+
+    for (const char* file : { "rgba8-256.png", "rgba8-512.png", "rgba8-1024.png", "rgb8-wide.png" }) {
+        Logo logo;
+        logo.name = file;
+        logo.file = TestData::ReadFile(TestData::Path("tests/data/png/") + file);
+        if (!PngDecoder::ReadHeader(logo.file.data(), logo.file.size(), logo.header)) {
+            std::fprintf(stderr, "can't read %s\n", file);
+            return 1;
+        }
+        BenchDecode(logo);
+        if (logo.header.height >= 32) {
+            for (int size : { 16, 32 }) BenchToIcon(logo, size);
+        }
+    }
+
+#ifdef _WIN32
+    Gdiplus::GdiplusShutdown(token);
+#endif
+    return 0;
+}
@@ -0,0 +1,59 @@
+// Fuzz entry point for PngDecoder. Built with -DWTT_FUZZ=ON under Clang it is
+// a libFuzzer target (seed it with data/png); otherwise it is a plain program
+// that replays the files named on its command line, which is how ctest runs
+// the corpus through it.
+#include "PngDecoder.h"
+#include "TestData.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+    volatile std::uint32_t sink = 0;
+
+    void Fail(const char* what, int y)
+    {
+        std::fprintf(stderr, "PngDecoderFuzz: %s (row %d)\n", what, y);
+        std::abort();
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    PngDecoder::Header header;
+    const bool haveHeader = PngDecoder::ReadHeader(data, size, header);
+    if (haveHeader && (header.width <= 0 || header.height <= 0 || header.width > PngDecoder::kMaxDimension ||
+                          header.height > PngDecoder::kMaxDimension)) {
+        Fail("header out of range", -1);
+    }
+
+    int next = 0;
+    std::uint32_t sum = 0;
+    const bool ok = PngDecoder::Decode(data, size, [&](int y, const std::uint32_t* argb) {
+        if (!haveHeader || y != next || y >= header.height) Fail("row out of order", y);
+        ++next;
+        // Every pixel of the row must be readable
+        for (int x = 0; x < header.width; ++x) sum += argb[x];
+    });
+    if (ok && next != header.height) Fail("decode succeeded with rows missing", next);
+    sink = sum;
+    return 0;
+}
+
+#ifndef WTT_LIBFUZZER
+int main(int argc, char** argv)
+{
+    int replayed = 0;
+    for (int i = 1; i < argc; ++i) {
+        const auto file = TestData::ReadFile(argv[i]);
+        if (file.empty()) {
+            std::fprintf(stderr, "PngDecoderFuzz: can't read %s\n", argv[i]);
+            return 1;
+        }
+        LLVMFuzzerTestOneInput(file.data(), file.size());
+        ++replayed;
+    }
+    std::printf("%d inputs replayed\n", replayed);
+    return 0;
+}
+#endif
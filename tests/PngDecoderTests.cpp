@@ -0,0 +1,156 @@
+// Golden decodes of the corpus in data/png (see generate.py there), plus
+// truncated and mutated copies of it.
+#include "PngDecoder.h"
+#include "IconSamples.h"
+#include "TestData.h"
+#include "TestHarness.h"
+#include <set>
+#include <sstream>
+#include <string>
+
+namespace {
+
+    const std::string kCorpus = TestData::Path("tests/data/png/");
+
+    struct Golden {
+        std::string   name;
+        bool          ok = false;
+        int           width = 0, height = 0;
+        std::uint64_t hash = 0;
+    };
+
+    std::vector<Golden> LoadGolden()
+    {
+        std::vector<Golden> all;
+        std::ifstream in(kCorpus + "golden.txt");
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            Golden g;
+            std::string status;
+            fields >> g.name >> status;
+            g.ok = status == "ok";
+            if (g.ok) fields >> g.width >> g.height >> std::hex >> g.hash;
+            if (!g.name.empty()) all.push_back(g);
+        }
+        return all;
+    }
+
+    // What a decode delivered: rows in order, each `width` pixels, hashed as
+    // generate.py does
+    struct Result {
+        bool          ok = false;
+        bool          inOrder = true;
+        int           rows = 0;
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+    };
+
+    Result DecodeAll(const std::vector<std::uint8_t>& file)
+    {
+        Result r;
+        PngDecoder::Header header;
+        const bool haveHeader = PngDecoder::ReadHeader(file.data(), file.size(), header);
+        r.ok = PngDecoder::Decode(file.data(), file.size(), [&](int y, const std::uint32_t* argb) {
+            r.inOrder = r.inOrder && haveHeader && y == r.rows && y < header.height;
+            ++r.rows;
+            for (int x = 0; x < header.width; ++x) {
+                for (int shift = 0; shift < 32; shift += 8) {
+                    r.hash = (r.hash ^ ((argb[x] >> shift) & 0xFF)) * 0x100000001B3ull;
+                }
+            }
+        });
+        return r;
+    }
+}
+
+TEST_CASE(GoldenDecodes)
+{
+    const std::vector<Golden> golden = LoadGolden();
+    CHECK(golden.size() > 40);
+    for (const Golden& g : golden) {
+        const auto file = TestData::ReadFile(kCorpus + g.name);
+        CHECK(!file.empty());
+        const Result r = DecodeAll(file);
+        CHECK(r.inOrder);
+        const bool ok = g.ok ? (r.ok && r.rows == g.height && r.hash == g.hash) : !r.ok;
+        if (!ok) {
+            std::fprintf(stderr, "  %s: %s after %d rows, hash %016llx\n", g.name.c_str(),
+                r.ok ? "decoded" : "failed", r.rows, static_cast<unsigned long long>(r.hash));
+        }
+        CHECK(ok);
+
+        PngDecoder::Header header;
+        if (g.ok) {
+            CHECK(PngDecoder::ReadHeader(file.data(), file.size(), header));
+            CHECK_EQ(header.width, g.width);
+            CHECK_EQ(header.height, g.height);
+        }
+    }
+}
+
+TEST_CASE(CorpusCoversEveryColorTypeAndDepth)
+{
+    std::set<std::pair<int, int>> seen;
+    for (const Golden& g : LoadGolden()) {
+        PngDecoder::Header header;
+        const auto file = TestData::ReadFile(kCorpus + g.name);
+        if (g.ok && PngDecoder::ReadHeader(file.data(), file.size(), header)) {
+            seen.insert({ header.colorType, header.bitDepth });
+        }
+    }
+    const std::pair<int, int> all[] = { { 0, 1 }, { 0, 2 }, { 0, 4 }, { 0, 8 }, { 0, 16 }, { 2, 8 }, { 2, 16 },
+        { 3, 1 }, { 3, 2 }, { 3, 4 }, { 3, 8 }, { 4, 8 }, { 4, 16 }, { 6, 8 }, { 6, 16 } };
+    for (const auto& format : all) CHECK(seen.count(format) == 1);
+}
+
+TEST_CASE(InterlacedIsReportedByTheHeader)
+{
+    const auto file = TestData::ReadFile(kCorpus + "interlaced.png");
+    PngDecoder::Header header;
+    CHECK(PngDecoder::ReadHeader(file.data(), file.size(), header));
+    CHECK(header.interlaced);
+    CHECK(!PngDecoder::Decode(file.data(), file.size(), [](int, const std::uint32_t*) {}));
+}
+
+TEST_CASE(TruncatedFilesFailCleanly)
+{
+    for (const char* name : { "rgba8-idat-bytes.png", "palette2-trns.png", "gray16.png", "rgba8-fixed.png",
+             "rgb8-stored.png", "rgba8-48.png" }) {
+        const auto file = TestData::ReadFile(kCorpus + name);
+        const Result full = DecodeAll(file);
+        CHECK(full.ok);
+        for (std::size_t n = 0; n < file.size(); ++n) {
+            // An exact-size copy, so a read past the end is out of bounds
+            const std::vector<std::uint8_t> cut(file.begin(), file.begin() + n);
+            const Result r = DecodeAll(cut);
+            CHECK(r.inOrder);
+            // Once every IDAT is in, IEND doesn't matter; before that it must fail
+            if (r.ok) CHECK(r.hash == full.hash && r.rows == full.rows);
+        }
+    }
+}
+
+TEST_CASE(MutatedFilesFailCleanly)
+{
+    IconSamples::Random rng(7);
+    for (const Golden& g : LoadGolden()) {
+        const auto file = TestData::ReadFile(kCorpus + g.name);
+        // The 512 and 1024 px logos are there for the benchmark; a
+        // mutation of them exercises nothing the smaller files don't
+        if (file.size() < 16 || g.width > 256) continue;
+        for (int round = 0; round < 300; ++round) {
+            std::vector<std::uint8_t> m = file;
+            const int flips = 1 + rng.Below(4);
+            for (int i = 0; i < flips; ++i) {
+                const std::size_t at = static_cast<std::size_t>(rng.Below(static_cast<int>(m.size())));
+                m[at] = rng.Below(2) ? std::uint8_t(m[at] ^ (1u << rng.Below(8))) : std::uint8_t(rng.Next());
+            }
+            CHECK(DecodeAll(m).inOrder);
+        }
+    }
+}
+
+int main()
+{
+    return TestHarness::RunAll();
+}
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef TESTDATA_H
+#define TESTDATA_H
+
+// Files from the source tree (sample binaries, the PNG corpus) for tests and
+// benchmarks. WTT_SOURCE_DIR is set by tests/CMakeLists.txt.
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace TestData {
+
+    // Path of `relative` under the repository root
+    inline std::string Path(const std::string& relative)
+    {
+        return std::string(WTT_SOURCE_DIR) + "/" + relative;
+    }
+
+    // Whole file; empty if it can't be read
+    inline std::vector<std::uint8_t> ReadFile(const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return {};
+        std::vector<std::uint8_t> data(static_cast<std::size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return data;
+    }
+
+} // namespace TestData
+
+#endif // TESTDATA_H
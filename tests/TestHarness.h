@@ -0,0 +1,68 @@
+#pragma once
+#ifndef TESTHARNESS_H
+#define TESTHARNESS_H
+
+// Minimal runner for the platform-neutral tests. TEST_CASE registers a case,
+// CHECK reports a failure and carries on, and each test program's main()
+// returns RunAll().
+
+#include <cstdio>
+#include <vector>
+
+namespace TestHarness {
+
+    struct Case {
+        const char* name;
+        void (*run)();
+    };
+
+    inline std::vector<Case>& Cases()
+    {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    inline int& Failures()
+    {
+        static int failures = 0;
+        return failures;
+    }
+
+    struct Registrar {
+        Registrar(const char* name, void (*run)()) { Cases().push_back({ name, run }); }
+    };
+
+    inline void Fail(const char* file, int line, const char* expr)
+    {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+        Failures()++;
+    }
+
+    // Runs every case in registration order; non-zero if any failed.
+    inline int RunAll()
+    {
+        int failed = 0;
+        for (const Case& c : Cases()) {
+            const int before = Failures();
+            c.run();
+            const bool ok = Failures() == before;
+            std::printf("[%s] %s\n", ok ? " ok " : "FAIL", c.name);
+            if (!ok) failed++;
+        }
+        std::printf("%d of %d cases failed\n", failed, static_cast<int>(Cases().size()));
+        return failed ? 1 : 0;
+    }
+
+} // namespace TestHarness
+
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestHarness::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(cond) \
+    do { if (!(cond)) TestHarness::Fail(__FILE__, __LINE__, #cond); } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+#endif // TESTHARNESS_H
@@ -0,0 +1,120 @@
+// TrayRegistry against the std::map<UINT, TrayIcon> it replaced, whose
+// "is this window in the tray" and "any UWP entry left" were full scans.
+#include "TrayRegistry.h"
+#include "BenchHarness.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+    struct Entry {
+        std::uintptr_t targetWindow = 0;
+        bool           isUwp = false;
+        std::uint64_t  payload = 0;
+    };
+
+    using Registry = TrayRegistry<Entry, std::uintptr_t>;
+    using LegacyMap = std::map<std::uint32_t, Entry>;
+
+    Entry Make(std::uintptr_t window)
+    {
+        Entry e;
+        e.targetWindow = window;
+        e.isUwp = window % 16 == 0;
+        e.payload = window;
+        return e;
+    }
+
+    // Window handles are pointer-like: spread out, not dense
+    std::uintptr_t WindowOf(int i) { return 0x10000 + static_cast<std::uintptr_t>(i) * 0x2A; }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace BenchHarness;
+    Init(argc, argv);
+
+    const int n = Quick() ? 1000 : 10000;
+    std::mt19937 rng(42);
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::printf("%d entries\n", n);
+
+    Registry reg;
+    std::vector<Registry::Id> ids(n);
+    Report("registry insert", NanosPerItem(n, [&] { reg = Registry(); }, [&] {
+        for (int i = 0; i < n; ++i) ids[i] = reg.Insert(Make(WindowOf(i)));
+    }), "op");
+
+    LegacyMap legacy;
+    Report("map insert", NanosPerItem(n, [&] { legacy.clear(); }, [&] {
+        for (int i = 0; i < n; ++i) legacy.emplace(ids[i], Make(WindowOf(i)));
+    }), "op");
+
+    Report("registry find by id", NanosPerItem(n, [&] {
+        std::uint64_t sum = 0;
+        for (int i : order) sum += reg.Find(ids[i])->payload;
+        Consume(sum);
+    }), "op");
+
+    Report("map find by id", NanosPerItem(n, [&] {
+        std::uint64_t sum = 0;
+        for (int i : order) sum += legacy.find(ids[i])->second.payload;
+        Consume(sum);
+    }), "op");
+
+    Report("registry contains(window)", NanosPerItem(n, [&] {
+        std::uint64_t hits = 0;
+        for (int i : order) hits += reg.Contains(WindowOf(i));
+        Consume(hits);
+    }), "op");
+
+    // The old IsWindowInTray: a scan per query, so fewer queries are timed
+    const int scans = std::max(1, n / 10);
+    Report("map contains(window) scan", NanosPerItem(scans, [&] {
+        std::uint64_t hits = 0;
+        for (int q = 0; q < scans; ++q) {
+            const std::uintptr_t w = WindowOf(order[q]);
+            hits += std::any_of(legacy.begin(), legacy.end(),
+                [w](const LegacyMap::value_type& kv) { return kv.second.targetWindow == w; });
+        }
+        Consume(hits);
+    }), "op");
+
+    Report("registry uwp count", NanosPerItem(1, [&] { Consume(reg.UwpCount()); }), "op");
+    Report("map uwp count scan", NanosPerItem(1, [&] {
+        Consume(static_cast<std::uint64_t>(std::count_if(legacy.begin(), legacy.end(),
+            [](const LegacyMap::value_type& kv) { return kv.second.isUwp; })));
+    }), "op");
+
+    Report("registry iterate", NanosPerItem(n, [&] {
+        std::uint64_t sum = 0;
+        for (const auto& r : reg) sum += r.entry.payload;
+        Consume(sum);
+    }), "entry");
+
+    Report("map iterate", NanosPerItem(n, [&] {
+        std::uint64_t sum = 0;
+        for (const auto& kv : legacy) sum += kv.second.payload;
+        Consume(sum);
+    }), "entry");
+
+    // Removal empties the container, so each repetition refills it untimed
+    Report("registry remove", NanosPerItem(n, [&] {
+        reg = Registry();
+        for (int i = 0; i < n; ++i) ids[i] = reg.Insert(Make(WindowOf(i)));
+    }, [&] {
+        for (int i : order) reg.Remove(ids[i]);
+    }), "op");
+
+    Report("map remove", NanosPerItem(n, [&] {
+        legacy.clear();
+        for (int i = 0; i < n; ++i) legacy.emplace(ids[i], Make(WindowOf(i)));
+    }, [&] {
+        for (int i : order) legacy.erase(ids[i]);
+    }), "op");
+    return 0;
+}
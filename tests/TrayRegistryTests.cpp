@@ -0,0 +1,191 @@
+#include "TrayRegistry.h"
+#include "TestHarness.h"
+#include <set>
+
+namespace {
+    struct Entry {
+        int  targetWindow = 0;
+        bool isUwp = false;
+        int  payload = 0;
+    };
+
+    using Registry = TrayRegistry<Entry, int>;
+
+    Entry Make(int window, bool uwp = false, int payload = 0)
+    {
+        Entry e;
+        e.targetWindow = window;
+        e.isUwp = uwp;
+        e.payload = payload;
+        return e;
+    }
+
+    std::uint32_t SlotOf(Registry::Id id) { return id & Registry::kSlotMask; }
+    std::uint32_t GenerationOf(Registry::Id id) { return id >> Registry::kSlotBits; }
+}
+
+TEST_CASE(InsertFindAndLookupByHandle)
+{
+    Registry reg;
+    const Registry::Id a = reg.Insert(Make(10, false, 1));
+    const Registry::Id b = reg.Insert(Make(20, true, 2));
+    CHECK(a != 0 && b != 0 && a != b);
+    CHECK_EQ(reg.Size(), 2u);
+    CHECK_EQ(reg.UwpCount(), 1u);
+
+    CHECK(reg.Find(a) && reg.Find(a)->payload == 1);
+    CHECK(reg.Find(b) && reg.Find(b)->payload == 2);
+    CHECK_EQ(reg.FindByHandle(20), b);
+    CHECK_EQ(reg.FindByHandle(30), 0u);
+    CHECK(reg.Contains(10));
+    CHECK(!reg.Contains(30));
+}
+
+TEST_CASE(IdsStayClearOfReservedUids)
+{
+    // Slot 0 generation 1 is the smallest id; the main icon's uID 1 and the
+    // group icons below 1 << kSlotBits are never handed out
+    Registry reg;
+    const Registry::Id first = reg.Insert(Make(1));
+    CHECK_EQ(first, 1u << Registry::kSlotBits);
+    for (int i = 2; i < 100; ++i) CHECK(reg.Insert(Make(i)) >= (1u << Registry::kSlotBits));
+}
+
+TEST_CASE(DuplicateHandleIsRejected)
+{
+    Registry reg;
+    CHECK(reg.Insert(Make(10, true)) != 0);
+    CHECK_EQ(reg.Insert(Make(10, true)), 0u);
+    CHECK_EQ(reg.Size(), 1u);
+    CHECK_EQ(reg.UwpCount(), 1u);
+}
+
+TEST_CASE(RemoveMovesTheEntryOutAndStalesTheId)
+{
+    Registry reg;
+    const Registry::Id a = reg.Insert(Make(10, true, 7));
+
+    Entry out;
+    CHECK(reg.Remove(a, &out));
+    CHECK_EQ(out.payload, 7);
+    CHECK_EQ(reg.Size(), 0u);
+    CHECK_EQ(reg.UwpCount(), 0u);
+    CHECK(!reg.Contains(10));
+
+    CHECK(reg.Find(a) == nullptr);
+    CHECK(!reg.Remove(a));
+}
+
+TEST_CASE(FreedSlotIsReusedUnderANewGeneration)
+{
+    Registry reg;
+    const Registry::Id a = reg.Insert(Make(10, false, 1));
+    CHECK(reg.Remove(a));
+
+    const Registry::Id b = reg.Insert(Make(20, false, 2));
+    CHECK_EQ(SlotOf(b), SlotOf(a));
+    CHECK_EQ(GenerationOf(b), GenerationOf(a) + 1);
+
+    // The old id must not resolve to the entry now in its slot
+    CHECK(reg.Find(a) == nullptr);
+    CHECK(!reg.Remove(a));
+    CHECK(reg.Find(b) && reg.Find(b)->payload == 2);
+}
+
+TEST_CASE(GenerationWrapsToOneNeverZero)
+{
+    Registry reg;
+    Registry::Id id = reg.Insert(Make(1));
+    const std::uint32_t slot = SlotOf(id);
+
+    bool wrapped = false;
+    for (std::uint32_t i = 0; i < Registry::kMaxGeneration + 2; ++i) {
+        const std::uint32_t before = GenerationOf(id);
+        CHECK(reg.Remove(id));
+        id = reg.Insert(Make(1));
+        CHECK(id != 0);
+        CHECK_EQ(SlotOf(id), slot);
+        CHECK(GenerationOf(id) != 0);
+        if (before == Registry::kMaxGeneration) {
+            CHECK_EQ(GenerationOf(id), 1u);
+            wrapped = true;
+        }
+    }
+    CHECK(wrapped);
+}
+
+TEST_CASE(MalformedAndStaleIdsAreRejected)
+{
+    Registry reg;
+    const Registry::Id a = reg.Insert(Make(10));
+    const Registry::Id slot = SlotOf(a);
+
+    CHECK(reg.Find(0) == nullptr);
+    CHECK(reg.Find(slot) == nullptr);                                           // Generation 0
+    CHECK(reg.Find(a + 1) == nullptr);                                          // Slot never used
+    CHECK(reg.Find(a + (1u << Registry::kSlotBits)) == nullptr);                // Future generation
+    CHECK(reg.Find(Registry::kSlotMask | (1u << Registry::kSlotBits)) == nullptr);
+    CHECK(!reg.Remove(a + (1u << Registry::kSlotBits)));
+    CHECK_EQ(reg.Size(), 1u);
+    CHECK(reg.Find(a) != nullptr);
+}
+
+TEST_CASE(ClearStalesEveryId)
+{
+    Registry reg;
+    std::vector<Registry::Id> ids;
+    for (int i = 0; i < 16; ++i) ids.push_back(reg.Insert(Make(i, i % 2 == 0)));
+    CHECK_EQ(reg.UwpCount(), 8u);
+
+    reg.Clear();
+    CHECK(reg.Empty());
+    CHECK_EQ(reg.UwpCount(), 0u);
+    for (Registry::Id id : ids) {
+        CHECK(reg.Find(id) == nullptr);
+        CHECK(!reg.Remove(id));
+    }
+
+    // Cleared slots are reused, still without reviving the old ids
+    std::set<Registry::Id> old(ids.begin(), ids.end());
+    for (int i = 0; i < 16; ++i) {
+        const Registry::Id id = reg.Insert(Make(100 + i));
+        CHECK(id != 0);
+        CHECK(old.count(id) == 0);
+        CHECK(SlotOf(id) < 16);
+    }
+}
+
+TEST_CASE(SwapRemoveKeepsOtherIdsValid)
+{
+    Registry reg;
+    std::vector<Registry::Id> ids;
+    for (int i = 0; i < 64; ++i) ids.push_back(reg.Insert(Make(i, false, i)));
+
+    // Remove every third entry, from the front so the tail moves each time
+    for (int i = 0; i < 64; i += 3) CHECK(reg.Remove(ids[i]));
+
+    for (int i = 0; i < 64; ++i) {
+        const Entry* e = reg.Find(ids[i]);
+        if (i % 3 == 0) {
+            CHECK(e == nullptr);
+            CHECK(!reg.Contains(i));
+        }
+        else {
+            CHECK(e && e->payload == i);
+            CHECK_EQ(reg.FindByHandle(i), ids[i]);
+        }
+    }
+
+    // Iteration sees each live record once, with the id it was issued
+    std::set<int> seen;
+    for (const auto& r : reg) {
+        CHECK(seen.insert(r.entry.payload).second);
+        CHECK_EQ(r.id, ids[r.entry.payload]);
+    }
+    CHECK_EQ(seen.size(), reg.Size());
+}
+
+int main()
+{
+    return TestHarness::RunAll();
+}
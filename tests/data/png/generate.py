@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""Writes the PNG corpus for PngDecoderTests and PngDecoderFuzz, and
+golden.txt with what each file must decode to.
+
+The expected pixels come from the samples written here, not from the
+decoder under test. Run from this directory; the output is deterministic
+for a given zlib.
+
+golden.txt, one file per line:
+    <name> ok <width> <height> <fnv1a64 of the ARGB rows, little-endian>
+    <name> fail
+"""
+import random
+import struct
+import zlib
+
+random.seed(20240601)
+
+CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+KIND = {0: 'gray', 2: 'rgb', 3: 'palette', 4: 'grayalpha', 6: 'rgba'}
+DEPTHS = {0: [1, 2, 4, 8, 16], 2: [8, 16], 3: [1, 2, 4, 8], 4: [8, 16], 6: [8, 16]}
+
+
+def chunk(kind, data):
+    return struct.pack('>I', len(data)) + kind + data + struct.pack('>I', zlib.crc32(kind + data) & 0xFFFFFFFF)
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    return a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+
+
+def filter_rows(rows, bpp, filters):
+    out = b''
+    prev = bytes(len(rows[0]))
+    for y, row in enumerate(rows):
+        f = filters(y)
+        line = bytearray([f])
+        for i in range(len(row)):
+            a = row[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            line.append((row[i] - [0, a, b, (a + b) // 2, paeth(a, b, c)][f]) & 255)
+        out += bytes(line)
+        prev = row
+    return out
+
+
+def fnv1a64(pixels):
+    h = 0xCBF29CE484222325
+    for p in pixels:
+        for byte in struct.pack('<I', p):
+            h = ((h ^ byte) * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+class Image:
+    """Samples of one image plus everything needed to encode and expect it"""
+
+    def __init__(self, ct, depth, width, height, pixel=None, palette_size=None, trns=False):
+        self.ct, self.depth, self.width, self.height = ct, depth, width, height
+        maxv = (1 << depth) - 1
+        self.palette = None
+        self.trns = None
+        self.key = None
+        if ct == 3:
+            n = palette_size or (1 << depth)
+            self.palette = [(random.randrange(256), random.randrange(256), random.randrange(256)) for _ in range(n)]
+            if trns:
+                self.trns = [random.randrange(256) for _ in range(max(1, n // 2))]
+        elif trns and ct in (0, 2):
+            self.key = tuple(random.randrange(maxv + 1) for _ in range(CHANNELS[ct]))
+        self.samples = []
+        for y in range(height):
+            for x in range(width):
+                if pixel:
+                    s = pixel(x, y, maxv)
+                elif ct == 3:
+                    s = [random.randrange(len(self.palette))]
+                else:
+                    s = [random.randrange(maxv + 1) for _ in range(CHANNELS[ct])]
+                if self.key and random.random() < 0.3:
+                    s = list(self.key)
+                self.samples.append(s)
+
+    def rows(self):
+        d = self.depth
+        out = []
+        for y in range(self.height):
+            px = self.samples[y * self.width:(y + 1) * self.width]
+            if d < 8:
+                bits = ''.join(format(s[0], '0%db' % d) for s in px)
+                bits += '0' * ((-len(bits)) % 8)
+                out.append(bytes(int(bits[i:i + 8], 2) for i in range(0, len(bits), 8)))
+            elif d == 8:
+                out.append(bytes(v for s in px for v in s))
+            else:
+                out.append(b''.join(struct.pack('>H', v) for s in px for v in s))
+        return out
+
+    def expected(self):
+        d, maxv = self.depth, (1 << self.depth) - 1
+
+        def to8(v):
+            return v >> 8 if d == 16 else v * 255 // maxv
+
+        out = []
+        for s in self.samples:
+            if self.ct == 0:
+                g = to8(s[0])
+                a = 0 if self.key and s[0] == self.key[0] else 255
+                out.append((a << 24) | (g << 16) | (g << 8) | g)
+            elif self.ct == 2:
+                a = 0 if self.key and tuple(s) == self.key else 255
+                out.append((a << 24) | (to8(s[0]) << 16) | (to8(s[1]) << 8) | to8(s[2]))
+            elif self.ct == 3:
+                r, g, b = self.palette[s[0]]
+                a = self.trns[s[0]] if self.trns and s[0] < len(self.trns) else 255
+                out.append((a << 24) | (r << 16) | (g << 8) | b)
+            elif self.ct == 4:
+                g = to8(s[0])
+                out.append((to8(s[1]) << 24) | (g << 16) | (g << 8) | g)
+            else:
+                out.append((to8(s[3]) << 24) | (to8(s[0]) << 16) | (to8(s[1]) << 8) | to8(s[2]))
+        return out
+
+    def encode(self, filters=lambda y: y % 5, compress=None, split=3, before=b'', after=b'', interlace=0):
+        bpp = max(1, CHANNELS[self.ct] * self.depth // 8)
+        raw = filter_rows(self.rows(), bpp, filters)
+        z = compress(raw) if compress else zlib.compress(raw, 9)
+        idats = b''
+        if split == 'bytes':
+            # One byte per IDAT, with an empty IDAT in the middle
+            for i, b in enumerate(z):
+                idats += chunk(b'IDAT', bytes([b]))
+                if i == len(z) // 2:
+                    idats += chunk(b'IDAT', b'')
+        else:
+            cuts = sorted(random.sample(range(1, len(z)), min(split - 1, len(z) - 1)))
+            for a, b in zip([0] + cuts, cuts + [len(z)]):
+                idats += chunk(b'IDAT', z[a:b])
+        head = chunk(b'IHDR', struct.pack('>IIBBBBB', self.width, self.height, self.depth, self.ct, 0, 0, interlace))
+        if self.palette:
+            head += chunk(b'PLTE', bytes(v for p in self.palette for v in p))
+        if self.trns:
+            head += chunk(b'tRNS', bytes(self.trns))
+        if self.key:
+            head += chunk(b'tRNS', b''.join(struct.pack('>H', v) for v in self.key))
+        return b'\x89PNG\r\n\x1a\n' + head + before + idats + after + chunk(b'IEND', b'')
+
+
+golden = []
+
+
+def ok(name, image, data):
+    open(name, 'wb').write(data)
+    golden.append('%s ok %d %d %016x' % (name, image.width, image.height, fnv1a64(image.expected())))
+
+
+def fail(name, data):
+    open(name, 'wb').write(data)
+    golden.append('%s fail' % name)
+
+
+def zlib_stream(deflate, data):
+    return b'\x78\x01' + deflate + struct.pack('>I', zlib.adler32(data) & 0xFFFFFFFF)
+
+
+def deflate(raw, level=9, strategy=zlib.Z_DEFAULT_STRATEGY):
+    c = zlib.compressobj(level, zlib.DEFLATED, -15, 9, strategy)
+    return c.compress(raw) + c.flush()
+
+
+# Every color type at every depth; rows cycle through all five filters and
+# the data is split over three IDATs
+for ct in sorted(DEPTHS):
+    for depth in DEPTHS[ct]:
+        image = Image(ct, depth, 13, 10)
+        ok('%s%d.png' % (KIND[ct], depth), image, image.encode())
+
+# Transparency: gray and RGB keys, a tRNS shorter than the palette, and a
+# palette shorter than the depth allows
+for ct, depth in [(0, 1), (0, 4), (0, 8), (0, 16), (2, 8), (2, 16), (3, 2), (3, 8)]:
+    image = Image(ct, depth, 11, 7, trns=True)
+    ok('%s%d-trns.png' % (KIND[ct], depth), image, image.encode())
+image = Image(3, 4, 9, 6, palette_size=5)
+ok('palette4-short.png', image, image.encode())
+
+# The zlib stream split every byte, stored uncompressed, and with fixed codes
+image = Image(6, 8, 12, 9)
+ok('rgba8-idat-bytes.png', image, image.encode(split='bytes'))
+image = Image(2, 8, 40, 12)
+ok('rgb8-stored.png', image, image.encode(compress=lambda raw: zlib.compress(raw, 0)))
+image = Image(6, 8, 24, 24)
+ok('rgba8-fixed.png', image, image.encode(
+    compress=lambda raw: zlib_stream(deflate(raw, 9, zlib.Z_FIXED), raw)))
+
+# A single filter type throughout, to pin each one down on its own
+for f in range(5):
+    image = Image(6, 16, 7, 6)
+    ok('rgba16-filter%d.png' % f, image, image.encode(filters=lambda y, f=f: f))
+
+# Ancillary chunks around the image data; one pixel; a long row
+image = Image(6, 8, 10, 10)
+ok('rgba8-ancillary.png', image, image.encode(
+    before=chunk(b'gAMA', struct.pack('>I', 45455)) + chunk(b'sRGB', b'\x00') + chunk(b'tEXt', b'Software\x00test'),
+    after=chunk(b'tEXt', b'Comment\x00after the image')))
+image = Image(0, 8, 1, 1)
+ok('gray8-1x1.png', image, image.encode())
+image = Image(2, 8, 600, 2)
+ok('rgb8-wide.png', image, image.encode())
+
+
+# A 256 px app logo: a soft-edged disc on transparency, which compresses
+# with long back-references (also what the benchmark decodes)
+def logo(x, y, maxv):
+    dx, dy = x + 0.5 - 128, y + 0.5 - 128
+    d = (dx * dx + dy * dy) ** 0.5
+    a = max(0.0, min(1.0, 100.5 - d))
+    return [int(40 + x * 0.6), int(90 + y * 0.5), 200, int(a * 255 + 0.5)]
+
+
+image = Image(6, 8, 256, 256, pixel=logo)
+ok('rgba8-256.png', image, image.encode(filters=lambda y: 4))
+for size in (16, 32, 48):
+    image = Image(6, 8, size, size, pixel=lambda x, y, m, s=size: logo(x * 256 // s, y * 256 // s, m))
+    ok('rgba8-%d.png' % size, image, image.encode(filters=lambda y: 4))
+# Large logos for the benchmark, sampled from the same disc
+for size in (512, 1024):
+    image = Image(6, 8, size, size, pixel=lambda x, y, m, s=size: logo(x * 256.0 / s, y * 256.0 / s, m))
+    ok('rgba8-%d.png' % size, image, image.encode(filters=lambda y: 4))
+
+# Files the decoder must refuse
+image = Image(6, 8, 8, 8)
+fail('interlaced.png', image.encode(interlace=1))
+# A filter byte of 5 on the fourth row
+raw = bytearray(filter_rows(image.rows(), 4, lambda y: 0))
+raw[3 * (8 * 4 + 1)] = 5
+ihdr = chunk(b'IHDR', struct.pack('>IIBBBBB', 8, 8, 8, 6, 0, 0, 0))
+sig = b'\x89PNG\r\n\x1a\n'
+fail('bad-filter.png', sig + ihdr + chunk(b'IDAT', zlib.compress(bytes(raw))) + chunk(b'IEND', b''))
+# Image data ends two rows early
+raw = filter_rows(image.rows()[:6], 4, lambda y: 0)
+fail('short-data.png', sig + ihdr + chunk(b'IDAT', zlib.compress(raw)) + chunk(b'IEND', b''))
+# The zlib stream is cut off inside a chunk that claims more
+z = zlib.compress(filter_rows(image.rows(), 4, lambda y: 1))
+fail('truncated-idat.png', sig + ihdr + struct.pack('>I', len(z)) + b'IDAT' + z[:len(z) // 2])
+# Palette image without PLTE; RGB at 4 bits; too wide; no IDAT at all
+fail('no-plte.png', sig + chunk(b'IHDR', struct.pack('>IIBBBBB', 4, 4, 8, 3, 0, 0, 0)) +
+     chunk(b'IDAT', zlib.compress(bytes(20))) + chunk(b'IEND', b''))
+fail('bad-depth.png', sig + chunk(b'IHDR', struct.pack('>IIBBBBB', 4, 4, 4, 2, 0, 0, 0)) +
+     chunk(b'IDAT', zlib.compress(bytes(40))) + chunk(b'IEND', b''))
+fail('too-wide.png', sig + chunk(b'IHDR', struct.pack('>IIBBBBB', 20000, 1, 8, 0, 0, 0, 0)) +
+     chunk(b'IDAT', zlib.compress(bytes(20001))) + chunk(b'IEND', b''))
+fail('no-idat.png', sig + ihdr + chunk(b'IEND', b''))
+
+
+# A fixed-code block whose first match reaches back before the output
+class Bits:
+    def __init__(self):
+        self.bits = []
+
+    def put(self, value, n):              # Extra bits and headers, LSB first
+        self.bits += [(value >> i) & 1 for i in range(n)]
+
+    def code(self, value, n):             # Huffman codes, MSB first
+        self.bits += [(value >> (n - 1 - i)) & 1 for i in range(n)]
+
+    def bytes(self):
+        b = self.bits + [0] * ((-len(self.bits)) % 8)
+        return bytes(sum(b[i + j] << j for j in range(8)) for i in range(0, len(b), 8))
+
+
+w = Bits()
+w.put(1, 1)                  # Final block
+w.put(1, 2)                  # Fixed codes
+w.code(0x30 + 0, 8)          # Literal 0 (the filter byte)
+w.code(1, 7)                 # Length 3
+w.code(13, 5)                # Distance 97 + extra
+w.put(3, 5)
+w.code(0, 7)                 # End of block
+fail('bad-distance.png', sig + chunk(b'IHDR', struct.pack('>IIBBBBB', 4, 1, 8, 0, 0, 0, 0)) +
+     chunk(b'IDAT', b'\x78\x01' + w.bytes() + b'\x00\x00\x00\x00') + chunk(b'IEND', b''))
+
+# Dynamic block header with an over-subscribed code length code
+w = Bits()
+w.put(1, 1)
+w.put(2, 2)                  # Dynamic codes
+w.put(0, 5)                  # 257 literal/length codes
+w.put(0, 5)                  # 1 distance code
+w.put(15, 4)                 # All 19 code length codes...
+for _ in range(19):
+    w.put(1, 3)              # ...each 1 bit long
+fail('bad-huffman.png', sig + chunk(b'IHDR', struct.pack('>IIBBBBB', 4, 1, 8, 0, 0, 0, 0)) +
+     chunk(b'IDAT', b'\x78\x01' + w.bytes() + bytes(8)) + chunk(b'IEND', b''))
+
+open('golden.txt', 'w').write('\n'.join(golden) + '\n')